@@ -0,0 +1,178 @@
+/*
+ * Batch API (colm_batch.c) against a loop over the single message functions, in cycles per byte (best of 5 runs).
+ * Every batch holds BATCH messages of the same size with 16 bytes of associated data and their own nonce,
+ * either all with the same key or with KEYS different keys (one after another, like the sessions of a server).
+ *
+ * Build:
+ *   cc -O3 -Isrc bench/bench_batch.c src/colm_parallel.c src/colm_dispatch.c src/colm_ad_cache.c src/colm_vaes.c src/colm_batch.c -o bench_batch
+ * (on ARM with -march=armv8-a+crypto, without colm_vaes.c and together with the AES key schedule)
+ */
+
+#include "colm.h"
+#include "bench_common.h"
+
+#define RUNS 5
+#define BATCH 1024
+#define AD_LEN 16
+#define KEYS 8
+
+static const uint64_t sizes[] = { 16, 64, 256, 576, 1024, 1500 };
+
+enum { COLM0_ENC, COLM0_DEC, COLM127_ENC, COLM127_DEC, OPERATIONS };
+
+static const char* names[] = { "colm0_encrypt", "colm0_decrypt", "colm127_encrypt", "colm127_decrypt" };
+
+// msgs is prepared for the operation, loop == 1 processes it with the single message functions
+static double measure(const colm_key_ctx* ctx, int operation, colm_batch_msg* msgs, int loop)
+{
+	uint64_t iterations = bench_iterations(msgs[0].in_len * BATCH) + 1;
+	uint64_t best = UINT64_MAX;
+	uint64_t start, cycles, i, out_len, tag_len;
+	size_t m;
+	int run;
+
+	for (run = 0; run < RUNS; run++)
+	{
+		start = bench_now();
+		for (i = 0; i < iterations; i++)
+		{
+			if (!loop)
+			{
+				switch (operation)
+				{
+					case COLM0_ENC: colm0_encrypt_batch(ctx, msgs, BATCH); break;
+					case COLM0_DEC: colm0_decrypt_batch(ctx, msgs, BATCH); break;
+					case COLM127_ENC: colm127_encrypt_batch(ctx, msgs, BATCH); break;
+					case COLM127_DEC: colm127_decrypt_batch(ctx, msgs, BATCH); break;
+				}
+				continue;
+			}
+
+			for (m = 0; m < BATCH; m++)
+			{
+				colm_batch_msg* msg = &msgs[m];
+				switch (operation)
+				{
+					case COLM0_ENC:
+						colm0_encrypt_ctx(msg->ctx ? msg->ctx : ctx, msg->in, msg->in_len, msg->associated_data, msg->data_len, msg->npub, &out_len, msg->out);
+						break;
+					case COLM0_DEC:
+						colm0_decrypt_ctx(msg->ctx ? msg->ctx : ctx, msg->in, msg->in_len, msg->associated_data, msg->data_len, msg->npub, &out_len, msg->out);
+						break;
+					case COLM127_ENC:
+						tag_len = 0;
+						colm127_encrypt_ctx(msg->ctx ? msg->ctx : ctx, msg->in, msg->in_len, msg->associated_data, msg->data_len, msg->npub, &out_len, msg->out, &tag_len, msg->tags);
+						break;
+					case COLM127_DEC:
+						colm127_decrypt_ctx(msg->ctx ? msg->ctx : ctx, msg->in, msg->in_len, msg->associated_data, msg->data_len, msg->npub, msg->tag_len, msg->tags, &out_len, msg->out);
+						break;
+				}
+			}
+		}
+		cycles = bench_now() - start;
+		if (cycles < best)
+		{
+			best = cycles;
+		}
+	}
+
+	return (double)best / (double)(iterations * BATCH); // per message
+}
+
+// messages for the operation, key_ctxs == NULL: all messages with the key of the call
+static colm_batch_msg* prepare(const colm_key_ctx* ctx, int operation, const colm_key_ctx* key_ctxs, colm_batch_msg* encrypt_msgs, colm_batch_msg* decrypt_msgs, uint64_t len)
+{
+	size_t m;
+
+	for (m = 0; m < BATCH; m++)
+	{
+		encrypt_msgs[m].ctx = key_ctxs != NULL ? &key_ctxs[m % KEYS] : NULL;
+	}
+
+	if (operation != COLM0_DEC && operation != COLM127_DEC)
+	{
+		return encrypt_msgs;
+	}
+
+	// the decryptions need valid ciphertexts (and intermediate tags)
+	operation == COLM0_DEC ? colm0_encrypt_batch(ctx, encrypt_msgs, BATCH) : colm127_encrypt_batch(ctx, encrypt_msgs, BATCH);
+	for (m = 0; m < BATCH; m++)
+	{
+		decrypt_msgs[m] = (colm_batch_msg){ .in = encrypt_msgs[m].out, .in_len = len + BLOCKSIZE, .associated_data = encrypt_msgs[m].associated_data, .data_len = AD_LEN, .npub = m,
+		                                    .out = encrypt_msgs[m].in, .tags = encrypt_msgs[m].tags, .tag_len = encrypt_msgs[m].tag_len, .ctx = encrypt_msgs[m].ctx };
+	}
+
+	return decrypt_msgs;
+}
+
+int main(void)
+{
+	const uint8_t key_bytes[BLOCKSIZE] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+	uint64_t max_len = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+	uint8_t* messages = malloc(BATCH * max_len);
+	uint8_t* ciphertexts = malloc(BATCH * (max_len + BLOCKSIZE));
+	uint8_t* tags = malloc(BATCH * BLOCKSIZE);
+	uint8_t ad[AD_LEN] = { 0 };
+	colm_batch_msg encrypt_msgs[BATCH], decrypt_msgs[BATCH];
+	colm_batch_msg* msgs;
+	colm_key_ctx ctx, key_ctxs[KEYS];
+	uint8_t session_key[BLOCKSIZE];
+	double loop_cycles, batch_cycles, keys_cycles, bytes;
+	uint64_t len;
+	size_t s, m;
+	int operation;
+
+	if (colm_key_ctx_init(&ctx, LOAD_KEY(key_bytes)) != 0)
+	{
+		fprintf(stderr, "no AES instructions on this CPU\n");
+		return 1;
+	}
+
+	for (m = 0; m < KEYS; m++)
+	{
+		memcpy(session_key, key_bytes, BLOCKSIZE);
+		session_key[0] ^= (uint8_t)(m + 1);
+		colm_key_ctx_init(&key_ctxs[m], LOAD_KEY(session_key));
+	}
+
+	bench_init();
+	bench_fill(messages, BATCH * max_len);
+
+	printf("# backend: %s, %d messages per batch, %s per byte\n", colm_backend_name(), BATCH, bench_unit());
+	printf("operation,bytes,loop,batch,batch_%d_keys,speedup\n", KEYS);
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+	{
+		len = sizes[s];
+		bytes = (double)len;
+
+		for (m = 0; m < BATCH; m++)
+		{
+			encrypt_msgs[m] = (colm_batch_msg){ .in = messages + m * len, .in_len = len, .associated_data = ad, .data_len = AD_LEN, .npub = m,
+			                                    .out = ciphertexts + m * (len + BLOCKSIZE), .tags = tags + m * BLOCKSIZE };
+		}
+
+		for (operation = 0; operation < OPERATIONS; operation++)
+		{
+			msgs = prepare(&ctx, operation, NULL, encrypt_msgs, decrypt_msgs, len);
+			loop_cycles = measure(&ctx, operation, msgs, 1) / bytes;
+			batch_cycles = measure(&ctx, operation, msgs, 0) / bytes;
+
+			msgs = prepare(&ctx, operation, key_ctxs, encrypt_msgs, decrypt_msgs, len);
+			keys_cycles = measure(&ctx, operation, msgs, 0) / bytes;
+
+			printf("%s,%llu,%.2f,%.2f,%.2f,%.2f\n", names[operation], (unsigned long long)len, loop_cycles, batch_cycles, keys_cycles, loop_cycles / batch_cycles);
+		}
+	}
+
+	for (m = 0; m < KEYS; m++)
+	{
+		colm_key_ctx_free(&key_ctxs[m]);
+	}
+	colm_key_ctx_free(&ctx);
+	free(messages);
+	free(ciphertexts);
+	free(tags);
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Helpers shared by the benchmarks.
+ * Cycles are read from the PMU cycle counter through perf_event_open. If the counter is not available (missing permissions,
+ * virtual machines without PMU, ...) the time stamp counter of the CPU is used (rdtsc on x86, CNTVCT_EL0 on ARMv8): it runs at a fixed
+ * rate, on x86 usually close to the nominal clock, on ARM often much slower. Without both the monotonic clock is used and all results
+ * are in nanoseconds. bench_unit() names the unit of the current counter.
+ */
+
+#ifndef COLM_BENCH_COMMON
+#define COLM_BENCH_COMMON
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+enum { BENCH_PERF, BENCH_TSC, BENCH_CLOCK };
+
+static int bench_cycle_fd = -1;
+static int bench_counter = BENCH_CLOCK;
+
+static inline void bench_init(void)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	bench_cycle_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	if (bench_cycle_fd >= 0)
+	{
+		ioctl(bench_cycle_fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(bench_cycle_fd, PERF_EVENT_IOC_ENABLE, 0);
+		bench_counter = BENCH_PERF;
+	}
+	else
+	{
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+		bench_counter = BENCH_TSC;
+#endif
+	}
+}
+
+// cycles (or time stamp counter ticks / nanoseconds if the cycle counter is not available)
+static inline uint64_t bench_now(void)
+{
+	uint64_t value;
+	struct timespec ts;
+
+	if (bench_counter == BENCH_PERF && read(bench_cycle_fd, &value, sizeof(value)) == sizeof(value))
+	{
+		return value;
+	}
+
+	if (bench_counter == BENCH_TSC)
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		_mm_lfence(); // no earlier instruction may still be running
+		value = __rdtsc();
+		_mm_lfence();
+		return value;
+#elif defined(__aarch64__)
+		__asm__ volatile("isb\n\tmrs %0, cntvct_el0" : "=r"(value) : : "memory");
+		return value;
+#endif
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline const char* bench_unit(void)
+{
+	switch (bench_counter)
+	{
+		case BENCH_PERF: return "cycles";
+#if defined(__aarch64__)
+		case BENCH_TSC: return "cntvct ticks";
+#else
+		case BENCH_TSC: return "tsc cycles";
+#endif
+		default: return "ns";
+	}
+}
+
+static inline void bench_fill(uint8_t* buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		buf[i] = (uint8_t)(i * 131 + 7);
+	}
+}
+
+// number of iterations so that every measurement processes roughly the same amount of data
+static inline uint64_t bench_iterations(uint64_t len)
+{
+	uint64_t iterations = (1u << 22) / (len + 64);
+	return iterations < 16 ? 16 : iterations;
+}
+
+#endif
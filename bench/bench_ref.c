@@ -0,0 +1,14 @@
+/*
+ * The reference implementation (src/colm.c) under other names, so it can be linked together with the library for comparisons.
+ * The prototypes are in bench_ref.h.
+ */
+
+#define colm0_encrypt ref_colm0_encrypt
+#define colm0_decrypt ref_colm0_decrypt
+#define colm127_encrypt ref_colm127_encrypt
+#define colm127_decrypt ref_colm127_decrypt
+#define mac ref_mac
+#define gf_mul3 ref_gf_mul3
+#define gf_mul7 ref_gf_mul7
+
+#include "colm.c"
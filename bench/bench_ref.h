@@ -0,0 +1,15 @@
+/*
+ * The reference implementation of src/colm.c, renamed by bench_ref.c (same parameters as colm0_encrypt etc. of colm.h).
+ */
+
+#ifndef COLM_BENCH_REF
+#define COLM_BENCH_REF
+
+#include "colm.h"
+
+int8_t ref_colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t* c_len, uint8_t* ciphertext);
+int8_t ref_colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t* m_len, uint8_t* message);
+int8_t ref_colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags);
+int8_t ref_colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message);
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * Rho kernels of colm_rho.h: the doubling chain against the lookahead, in cycles per block (best of 5 runs).
+ * Every group takes the w of the group before it, like the encryption loops, the blocks come from a buffer (the AES output in the loops).
+ * The first column checks that both kernels give the same result.
+ *
+ * Build:
+ *   cc -O3 -Isrc bench/bench_rho.c -o bench_rho   (on ARM with -march=armv8-a+crypto)
+ * The effect on whole messages: build bench_width with the default and with -DCOLM_RHO_LOOKAHEAD=8 and compare.
+ */
+
+#include "colm.h"
+#include "colm_rho.h"
+#include "bench_common.h"
+
+#define RUNS 5
+#define BUFFER_BLOCKS 4096
+#define GROUPS (1u << 18)
+
+// everything below uses the AES (and carry-less multiplication) instructions (see aes_crypto.h)
+AES_TARGET_BEGIN
+
+// the kernel as a function of its own, so both are measured the same way
+#define KERNEL(name, kernel, n) \
+	static block_t name(const uint8_t* buffer, uint8_t* out, uint64_t groups) \
+	{ \
+		block_t x[COLM_RHO_MAX_LANES], sum = ZERO_BLOCK(), w = ZERO_BLOCK(); \
+		uint64_t g, offset = 0; \
+		uint8_t j; \
+		for (g = 0; g < groups; g++) \
+		{ \
+			for (j = 0; j < (n); j++) \
+			{ \
+				x[j] = LOAD_BLOCK(buffer + (offset + j) * BLOCKSIZE); \
+			} \
+			kernel(x, &w, (n)); \
+			for (j = 0; j < (n); j++) \
+			{ \
+				sum = XOR_BLOCK(sum, x[j]); \
+			} \
+			offset = (offset + (n)) % (BUFFER_BLOCKS - COLM_RHO_MAX_LANES); \
+		} \
+		STORE_BLOCK(out, w); \
+		return sum; \
+	}
+
+KERNEL(chain8, rho_chain, 8)
+KERNEL(lookahead8, rho_lookahead, 8)
+KERNEL(chain16, rho_chain, 16)
+KERNEL(lookahead16, rho_lookahead, 16)
+
+static double measure(block_t (*kernel)(const uint8_t*, uint8_t*, uint64_t), const uint8_t* buffer, uint8_t n, uint8_t* result)
+{
+	uint64_t best = UINT64_MAX;
+	uint64_t start, cycles;
+	uint8_t w[BLOCKSIZE];
+	int run;
+
+	for (run = 0; run < RUNS; run++)
+	{
+		start = bench_now();
+		STORE_BLOCK(result, kernel(buffer, w, GROUPS));
+		cycles = bench_now() - start;
+		if (cycles < best)
+		{
+			best = cycles;
+		}
+	}
+
+	memcpy(result + BLOCKSIZE, w, BLOCKSIZE);
+	return (double)best / (double)(GROUPS * n);
+}
+
+AES_TARGET_END
+
+int main(void)
+{
+	static uint8_t buffer[BUFFER_BLOCKS * BLOCKSIZE];
+	uint8_t result_chain[2 * BLOCKSIZE], result_lookahead[2 * BLOCKSIZE];
+	double chain, lookahead;
+
+	bench_init();
+	bench_fill(buffer, sizeof(buffer));
+
+	printf("# %s\n", AES_BACKEND_NAME);
+	printf("blocks per group,same result,chain,lookahead (%s per block)\n", bench_unit());
+
+	chain = measure(chain8, buffer, 8, result_chain);
+	lookahead = measure(lookahead8, buffer, 8, result_lookahead);
+	printf("8,%s,%.2f,%.2f\n", memcmp(result_chain, result_lookahead, sizeof(result_chain)) == 0 ? "yes" : "NO", chain, lookahead);
+
+	chain = measure(chain16, buffer, 16, result_chain);
+	lookahead = measure(lookahead16, buffer, 16, result_lookahead);
+	printf("16,%s,%.2f,%.2f\n", memcmp(result_chain, result_lookahead, sizeof(result_chain)) == 0 ? "yes" : "NO", chain, lookahead);
+
+	return 0;
+}
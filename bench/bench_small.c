@@ -0,0 +1,146 @@
+/*
+ * Latency of short messages: nanoseconds (and cycles, see bench_common.h) per message for the sizes around the short message kernels
+ * (up to COLM_SHORT_LEN = 64 bytes), with and without 16 bytes of associated data, best of 5 runs.
+ * The nonce of every call is taken from the result of the call before it, so the calls do not overlap and the time is the latency of
+ * one message, not the throughput of many independent ones (for that see bench/bench_batch.c).
+ *
+ * Build:
+ *   cc -O3 -Isrc bench/bench_small.c src/colm_parallel.c src/colm_dispatch.c src/colm_ad_cache.c src/colm_vaes.c -o bench_small
+ * (on ARM with -march=armv8-a+crypto, without colm_vaes.c and together with the AES key schedule)
+ * Usage: bench_small [backend]
+ */
+
+#include "colm.h"
+#include "bench_common.h"
+
+#define RUNS 5
+#define ITERATIONS 200000
+
+static const uint64_t sizes[] = { 0, 1, 8, 15, 16, 17, 24, 32, 33, 48, 56, 63, 64, 65, 80, 96, 128 };
+
+enum { COLM0_ENC, COLM0_DEC, COLM127_ENC, COLM127_DEC, OPERATIONS };
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ns per message, *units: the same in cycles (or ns)
+static double measure(const colm_key_ctx* ctx, int operation, uint8_t* message, uint64_t len, uint8_t* ad, uint64_t ad_len, uint8_t* ciphertext, uint8_t* out, uint8_t* tags, double* units)
+{
+	uint64_t best_ns = UINT64_MAX, best_units = UINT64_MAX;
+	uint64_t start_ns, start, ns, cycles, c_len, out_len, tag_len, i;
+	uint64_t npub = 0;
+	int8_t status = 0;
+	int run;
+
+	// the ciphertext to decrypt (npub 0 stays 0 as long as the decryption succeeds)
+	tag_len = 0;
+	if (operation == COLM0_DEC)
+	{
+		colm0_encrypt_ctx(ctx, message, len, ad, ad_len, 0, &c_len, ciphertext);
+	}
+	else if (operation == COLM127_DEC)
+	{
+		colm127_encrypt_ctx(ctx, message, len, ad, ad_len, 0, &c_len, ciphertext, &tag_len, tags);
+	}
+
+	for (run = 0; run < RUNS; run++)
+	{
+		start_ns = now_ns();
+		start = bench_now();
+		for (i = 0; i < ITERATIONS; i++)
+		{
+			switch (operation)
+			{
+				case COLM0_ENC:
+					colm0_encrypt_ctx(ctx, message, len, ad, ad_len, npub, &c_len, ciphertext);
+					npub = ciphertext[c_len - 1]; // last byte of the tag, depends on the whole message
+					break;
+				case COLM0_DEC:
+					status |= colm0_decrypt_ctx(ctx, ciphertext, len + BLOCKSIZE, ad, ad_len, npub, &out_len, out);
+					npub = (uint64_t)status;
+					break;
+				case COLM127_ENC:
+					tag_len = 0;
+					colm127_encrypt_ctx(ctx, message, len, ad, ad_len, npub, &c_len, ciphertext, &tag_len, tags);
+					npub = ciphertext[c_len - 1];
+					break;
+				case COLM127_DEC:
+					status |= colm127_decrypt_ctx(ctx, ciphertext, len + BLOCKSIZE, ad, ad_len, npub, tag_len, tags, &out_len, out);
+					npub = (uint64_t)status;
+					break;
+			}
+		}
+		cycles = bench_now() - start;
+		ns = now_ns() - start_ns;
+		if (ns < best_ns)
+		{
+			best_ns = ns;
+		}
+		if (cycles < best_units)
+		{
+			best_units = cycles;
+		}
+	}
+
+	if (status != 0)
+	{
+		fprintf(stderr, "decryption failed (%d)\n", status);
+	}
+
+	*units = (double)best_units / ITERATIONS;
+	return (double)best_ns / ITERATIONS;
+}
+
+int main(int argc, char** argv)
+{
+	const uint8_t key_bytes[BLOCKSIZE] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+	block_t key = LOAD_KEY(key_bytes);
+	colm_key_ctx ctx;
+	uint8_t message[256], ad[BLOCKSIZE], ciphertext[256 + BLOCKSIZE], out[256], tags[2 * BLOCKSIZE];
+	double ns[OPERATIONS], units[OPERATIONS];
+	uint64_t ad_len;
+	size_t s;
+	int operation;
+
+	if (argc > 1 && colm_backend_select(argv[1]) != 0)
+	{
+		fprintf(stderr, "backend %s not available\n", argv[1]);
+		return 1;
+	}
+
+	bench_init();
+	bench_fill(message, sizeof(message));
+	bench_fill(ad, sizeof(ad));
+	if (colm_key_ctx_init(&ctx, key) != 0)
+	{
+		fprintf(stderr, "no AES instructions on this CPU\n");
+		return 1;
+	}
+
+	printf("# backend: %s\n", colm_backend_name());
+	printf("bytes,ad,colm0_encrypt,colm0_decrypt,colm127_encrypt,colm127_decrypt (ns per message),same in %s\n", bench_unit());
+
+	for (ad_len = 0; ad_len <= BLOCKSIZE; ad_len += BLOCKSIZE)
+	{
+		for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+		{
+			for (operation = 0; operation < OPERATIONS; operation++)
+			{
+				ns[operation] = measure(&ctx, operation, message, sizes[s], ad, ad_len, ciphertext, out, tags, &units[operation]);
+			}
+
+			printf("%llu,%llu,%.1f,%.1f,%.1f,%.1f,%.0f,%.0f,%.0f,%.0f\n", (unsigned long long)sizes[s], (unsigned long long)ad_len,
+			       ns[COLM0_ENC], ns[COLM0_DEC], ns[COLM127_ENC], ns[COLM127_DEC],
+			       units[COLM0_ENC], units[COLM0_DEC], units[COLM127_ENC], units[COLM127_DEC]);
+		}
+	}
+
+	colm_key_ctx_free(&ctx);
+
+	return 0;
+}
@@ -0,0 +1,274 @@
+/*
+ * Sweep over message and associated data lengths for all variants: COLM0 / COLM127, encryption / decryption and three implementations:
+ *   reference    src/colm.c, the key schedule is part of every call
+ *   library      colm0_encrypt etc. of colm.h (the selected backend), also with the key schedule in every call
+ *   library_ctx  colm0_encrypt_ctx etc. with a prepared key context
+ * Every measurement does warmup runs first and reports the median (and min / max) of the runs, per message and per byte of the message,
+ * in the unit of bench_common.h (PMU cycles, otherwise rdtsc / CNTVCT ticks). The output is CSV (default) or JSON for plotting.
+ * Before the timing the ciphertexts and tags of the reference and the library are compared.
+ *
+ * Build:
+ *   cc -O3 -Isrc bench/bench_sweep.c bench/bench_ref.c src/colm_parallel.c src/colm_dispatch.c src/colm_ad_cache.c src/colm_vaes.c -o bench_sweep
+ * (on ARM with -march=armv8-a+crypto, without colm_vaes.c and together with the AES key schedule)
+ * Usage: bench_sweep [-f csv|json] [-r runs] [-w warmup runs] [-m max message length] [-a ad lengths, comma separated] [-b backend]
+ */
+
+#include <getopt.h>
+#include "colm.h"
+#include "bench_common.h"
+#include "bench_ref.h"
+
+#define MAX_RUNS 101
+#define MAX_AD_LENGTHS 16
+
+static const uint64_t sizes[] = { 0, 1, 15, 16, 17, 64, 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304, 16777216, 67108864 };
+
+enum { COLM0_ENC, COLM0_DEC, COLM127_ENC, COLM127_DEC, OPERATIONS };
+enum { REFERENCE, LIBRARY, LIBRARY_CTX, IMPLEMENTATIONS };
+
+static const char* operation_names[OPERATIONS] = { "encrypt", "decrypt", "encrypt", "decrypt" };
+static const char* variant_names[OPERATIONS] = { "colm0", "colm0", "colm127", "colm127" };
+static const char* implementation_names[IMPLEMENTATIONS] = { "reference", "library", "library_ctx" };
+
+typedef struct bench_buffers
+{
+	uint8_t* message;
+	uint8_t* ad;
+	uint8_t* ciphertext;    // valid COLM0 ciphertext of the message for the decryptions
+	uint8_t* ciphertext127; // same for COLM127, with tags
+	uint8_t* tags;
+	uint8_t* out;           // ciphertext of the encryptions, plaintext of the decryptions
+	uint8_t* out_tags;
+	uint64_t tag_len;
+} bench_buffers;
+
+static const uint8_t key_bytes[BLOCKSIZE] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+
+static int8_t run_once(const colm_key_ctx* ctx, block_t key, int implementation, int operation, bench_buffers* b, uint64_t len, uint64_t ad_len)
+{
+	uint64_t out_len, tag_len = 0;
+
+	switch (implementation * OPERATIONS + operation)
+	{
+		case REFERENCE * OPERATIONS + COLM0_ENC: return ref_colm0_encrypt(b->message, len, b->ad, ad_len, 1, key, &out_len, b->out);
+		case REFERENCE * OPERATIONS + COLM0_DEC: return ref_colm0_decrypt(b->ciphertext, len + BLOCKSIZE, b->ad, ad_len, 1, key, &out_len, b->out);
+		case REFERENCE * OPERATIONS + COLM127_ENC: return ref_colm127_encrypt(b->message, len, b->ad, ad_len, 1, key, &out_len, b->out, &tag_len, b->out_tags);
+		case REFERENCE * OPERATIONS + COLM127_DEC: return ref_colm127_decrypt(b->ciphertext127, len + BLOCKSIZE, b->ad, ad_len, 1, key, b->tag_len, b->tags, &out_len, b->out);
+		case LIBRARY * OPERATIONS + COLM0_ENC: return colm0_encrypt(b->message, len, b->ad, ad_len, 1, key, &out_len, b->out);
+		case LIBRARY * OPERATIONS + COLM0_DEC: return colm0_decrypt(b->ciphertext, len + BLOCKSIZE, b->ad, ad_len, 1, key, &out_len, b->out);
+		case LIBRARY * OPERATIONS + COLM127_ENC: return colm127_encrypt(b->message, len, b->ad, ad_len, 1, key, &out_len, b->out, &tag_len, b->out_tags);
+		case LIBRARY * OPERATIONS + COLM127_DEC: return colm127_decrypt(b->ciphertext127, len + BLOCKSIZE, b->ad, ad_len, 1, key, b->tag_len, b->tags, &out_len, b->out);
+		case LIBRARY_CTX * OPERATIONS + COLM0_ENC: return colm0_encrypt_ctx(ctx, b->message, len, b->ad, ad_len, 1, &out_len, b->out);
+		case LIBRARY_CTX * OPERATIONS + COLM0_DEC: return colm0_decrypt_ctx(ctx, b->ciphertext, len + BLOCKSIZE, b->ad, ad_len, 1, &out_len, b->out);
+		case LIBRARY_CTX * OPERATIONS + COLM127_ENC: return colm127_encrypt_ctx(ctx, b->message, len, b->ad, ad_len, 1, &out_len, b->out, &tag_len, b->out_tags);
+		default: return colm127_decrypt_ctx(ctx, b->ciphertext127, len + BLOCKSIZE, b->ad, ad_len, 1, b->tag_len, b->tags, &out_len, b->out);
+	}
+}
+
+static int compare_u64(const void* a, const void* b)
+{
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return x < y ? -1 : x > y;
+}
+
+// reference and library have to agree before they are compared, the ciphertexts (and tags) of the library stay in b for the decryptions
+static int check_outputs(block_t key, bench_buffers* b, uint64_t len, uint64_t ad_len)
+{
+	uint64_t c_len, ref_tag_len = 0;
+	int ok;
+
+	ref_colm0_encrypt(b->message, len, b->ad, ad_len, 1, key, &c_len, b->out);
+	colm0_encrypt(b->message, len, b->ad, ad_len, 1, key, &c_len, b->ciphertext);
+	ok = memcmp(b->out, b->ciphertext, c_len) == 0;
+
+	ref_colm127_encrypt(b->message, len, b->ad, ad_len, 1, key, &c_len, b->out, &ref_tag_len, b->out_tags);
+	b->tag_len = 0;
+	colm127_encrypt(b->message, len, b->ad, ad_len, 1, key, &c_len, b->ciphertext127, &b->tag_len, b->tags);
+	ok = ok && memcmp(b->out, b->ciphertext127, c_len) == 0 && ref_tag_len == b->tag_len && memcmp(b->out_tags, b->tags, b->tag_len) == 0;
+
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	block_t key = LOAD_KEY(key_bytes);
+	colm_key_ctx ctx;
+	bench_buffers b;
+	uint64_t max_len = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+	uint64_t ad_lengths[MAX_AD_LENGTHS] = { 0, 16, 1024 };
+	uint64_t samples[MAX_RUNS];
+	uint64_t max_ad = 0, iterations, start, len, ad_len, i;
+	int ad_count = 3, runs = 7, warmup = 1, json = 0, first = 1;
+	int option, run, implementation, operation, a;
+	size_t s;
+	int8_t status;
+	char* list;
+
+	while ((option = getopt(argc, argv, "f:r:w:m:a:b:")) != -1)
+	{
+		switch (option)
+		{
+			case 'f':
+				json = strcmp(optarg, "json") == 0;
+				break;
+			case 'r':
+				runs = atoi(optarg);
+				break;
+			case 'w':
+				warmup = atoi(optarg);
+				break;
+			case 'm':
+				max_len = strtoull(optarg, NULL, 0);
+				break;
+			case 'a':
+				ad_count = 0;
+				for (list = strtok(optarg, ","); list != NULL && ad_count < MAX_AD_LENGTHS; list = strtok(NULL, ","))
+				{
+					ad_lengths[ad_count++] = strtoull(list, NULL, 0);
+				}
+				break;
+			case 'b':
+				if (colm_backend_select(optarg) != 0)
+				{
+					fprintf(stderr, "backend %s not available\n", optarg);
+					return 1;
+				}
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-f csv|json] [-r runs] [-w warmup runs] [-m max message length] [-a ad lengths] [-b backend]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (runs < 1 || runs > MAX_RUNS || warmup < 0 || ad_count == 0)
+	{
+		fprintf(stderr, "invalid parameters (1 - %d runs)\n", MAX_RUNS);
+		return 1;
+	}
+
+	for (a = 0; a < ad_count; a++)
+	{
+		max_ad = ad_lengths[a] > max_ad ? ad_lengths[a] : max_ad;
+	}
+
+	b.message = malloc(max_len + 1);
+	b.ad = malloc(max_ad + 1);
+	b.ciphertext = malloc(max_len + BLOCKSIZE);
+	b.ciphertext127 = malloc(max_len + BLOCKSIZE);
+	b.out = malloc(max_len + BLOCKSIZE);
+	b.tags = malloc(max_len / 127 + 2 * BLOCKSIZE);
+	b.out_tags = malloc(max_len / 127 + 2 * BLOCKSIZE);
+	if (b.message == NULL || b.ad == NULL || b.ciphertext == NULL || b.ciphertext127 == NULL || b.out == NULL || b.tags == NULL || b.out_tags == NULL)
+	{
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	bench_init();
+	bench_fill(b.message, max_len + 1);
+	bench_fill(b.ad, max_ad + 1);
+	if (colm_key_ctx_init(&ctx, key) != 0)
+	{
+		fprintf(stderr, "no AES instructions on this CPU\n");
+		return 1;
+	}
+
+	if (json)
+	{
+		printf("{\n\"backend\": \"%s\",\n\"unit\": \"%s\",\n\"runs\": %d,\n\"results\": [\n", colm_backend_name(), bench_unit(), runs);
+	}
+	else
+	{
+		printf("# backend: %s, median of %d runs\n", colm_backend_name(), runs);
+		printf("variant,operation,implementation,message_len,ad_len,iterations,median,min,max,median_per_byte (%s)\n", bench_unit());
+	}
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && sizes[s] <= max_len; s++)
+	{
+		len = sizes[s];
+		// about 4 MiB per run (at least one message)
+		iterations = (1u << 22) / (len + 64);
+		iterations = iterations == 0 ? 1 : iterations;
+
+		for (a = 0; a < ad_count; a++)
+		{
+			ad_len = ad_lengths[a];
+			if (!check_outputs(key, &b, len, ad_len))
+			{
+				fprintf(stderr, "reference and library differ (message %llu, ad %llu bytes)\n", (unsigned long long)len, (unsigned long long)ad_len);
+				return 1;
+			}
+
+			for (operation = 0; operation < OPERATIONS; operation++)
+			{
+				for (implementation = 0; implementation < IMPLEMENTATIONS; implementation++)
+				{
+					status = 0;
+					for (run = -warmup; run < runs; run++)
+					{
+						start = bench_now();
+						for (i = 0; i < iterations; i++)
+						{
+							status |= run_once(&ctx, key, implementation, operation, &b, len, ad_len);
+						}
+						if (run >= 0)
+						{
+							samples[run] = bench_now() - start;
+						}
+					}
+					if (status != 0)
+					{
+						fprintf(stderr, "%s %s (%s) failed: %d\n", variant_names[operation], operation_names[operation], implementation_names[implementation], status);
+					}
+
+					qsort(samples, runs, sizeof(samples[0]), compare_u64);
+
+					if (json)
+					{
+						printf("%s{\"variant\": \"%s\", \"operation\": \"%s\", \"implementation\": \"%s\", \"message_len\": %llu, \"ad_len\": %llu, \"iterations\": %llu, "
+						       "\"median\": %.2f, \"min\": %.2f, \"max\": %.2f, \"median_per_byte\": ",
+						       first ? "" : ",\n", variant_names[operation], operation_names[operation], implementation_names[implementation],
+						       (unsigned long long)len, (unsigned long long)ad_len, (unsigned long long)iterations,
+						       (double)samples[runs / 2] / iterations, (double)samples[0] / iterations, (double)samples[runs - 1] / iterations);
+						if (len > 0)
+						{
+							printf("%.4f}", (double)samples[runs / 2] / (iterations * len));
+						}
+						else
+						{
+							printf("null}");
+						}
+					}
+					else
+					{
+						printf("%s,%s,%s,%llu,%llu,%llu,%.2f,%.2f,%.2f,", variant_names[operation], operation_names[operation], implementation_names[implementation],
+						       (unsigned long long)len, (unsigned long long)ad_len, (unsigned long long)iterations,
+						       (double)samples[runs / 2] / iterations, (double)samples[0] / iterations, (double)samples[runs - 1] / iterations);
+						if (len > 0)
+						{
+							printf("%.4f", (double)samples[runs / 2] / (iterations * len));
+						}
+						printf("\n");
+					}
+					first = 0;
+					fflush(stdout);
+				}
+			}
+		}
+	}
+
+	if (json)
+	{
+		printf("\n]\n}\n");
+	}
+
+	colm_key_ctx_free(&ctx);
+	free(b.message);
+	free(b.ad);
+	free(b.ciphertext);
+	free(b.ciphertext127);
+	free(b.out);
+	free(b.tags);
+	free(b.out_tags);
+
+	return 0;
+}
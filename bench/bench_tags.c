@@ -0,0 +1,120 @@
+/*
+ * Cost of the intermediate tags: COLM127 against COLM0 for each pipeline width, in cycles per byte (best of 5 runs)
+ * and the overhead of COLM127 in percent.
+ * The VAES backend runs COLM0 16 blocks at a time but COLM127 pipelined, pass the name of a backend (e.g. aes-ni) to compare
+ * the same loops.
+ *
+ * Build:
+ *   cc -O3 -Isrc bench/bench_tags.c src/colm_parallel.c src/colm_dispatch.c src/colm_ad_cache.c src/colm_vaes.c -o bench_tags
+ * (on ARM with -march=armv8-a+crypto, without colm_vaes.c and together with the AES key schedule)
+ * Usage: bench_tags [backend]
+ */
+
+#include "colm.h"
+#include "bench_common.h"
+
+#define RUNS 5
+
+static const uint8_t widths[] = { 3, 4, 6, 8 };
+static const uint64_t sizes[] = { 2048, 16384, 65536, 1048576 };
+
+enum { COLM0_ENC, COLM0_DEC, COLM127_ENC, COLM127_DEC, OPERATIONS };
+
+static double measure(const colm_key_ctx* ctx, int operation, uint8_t* in, uint64_t len, uint8_t* out, uint8_t* tags, uint64_t tag_len)
+{
+	uint64_t iterations = bench_iterations(len);
+	uint64_t best = UINT64_MAX;
+	uint64_t start, cycles, out_len, tl, i;
+	int run;
+
+	for (run = 0; run < RUNS; run++)
+	{
+		start = bench_now();
+		for (i = 0; i < iterations; i++)
+		{
+			switch (operation)
+			{
+				case COLM0_ENC:
+					colm0_encrypt_ctx(ctx, in, len, NULL, 0, 0, &out_len, out);
+					break;
+				case COLM0_DEC:
+					colm0_decrypt_ctx(ctx, in, len + BLOCKSIZE, NULL, 0, 0, &out_len, out);
+					break;
+				case COLM127_ENC:
+					tl = 0;
+					colm127_encrypt_ctx(ctx, in, len, NULL, 0, 0, &out_len, out, &tl, tags);
+					break;
+				case COLM127_DEC:
+					colm127_decrypt_ctx(ctx, in, len + BLOCKSIZE, NULL, 0, 0, tag_len, tags, &out_len, out);
+					break;
+			}
+		}
+		cycles = bench_now() - start;
+		if (cycles < best)
+		{
+			best = cycles;
+		}
+	}
+
+	return (double)best / (double)(iterations * len);
+}
+
+int main(int argc, char** argv)
+{
+	const uint8_t key_bytes[BLOCKSIZE] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+	block_t key = LOAD_KEY(key_bytes);
+	colm_key_ctx ctx;
+	uint64_t max_len = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+	uint8_t* message = malloc(max_len);
+	uint8_t* ciphertext = malloc(max_len + BLOCKSIZE);
+	uint8_t* tags = malloc(max_len / 127 + 2 * BLOCKSIZE);
+	double result[OPERATIONS];
+	uint64_t c_len, tag_len;
+	size_t w, s;
+	int operation;
+
+	if (argc > 1 && colm_backend_select(argv[1]) != 0)
+	{
+		fprintf(stderr, "backend %s not available\n", argv[1]);
+		return 1;
+	}
+
+	bench_init();
+	bench_fill(message, max_len);
+	if (colm_key_ctx_init(&ctx, key) != 0)
+	{
+		fprintf(stderr, "no AES instructions on this CPU\n");
+		return 1;
+	}
+
+	printf("# backend: %s\n", colm_backend_name());
+	printf("width,bytes,colm0_encrypt,colm127_encrypt,overhead,colm0_decrypt,colm127_decrypt,overhead (%s per byte, %%)\n", bench_unit());
+
+	for (w = 0; w < sizeof(widths); w++)
+	{
+		colm_key_ctx_set_pipeline_width(&ctx, widths[w]);
+
+		for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+		{
+			// COLM127 decrypts a valid ciphertext (it stops at the first invalid intermediate tag), COLM0 random data
+			tag_len = 0;
+			colm127_encrypt_ctx(&ctx, message, sizes[s], NULL, 0, 0, &c_len, ciphertext, &tag_len, tags);
+
+			for (operation = 0; operation < OPERATIONS; operation++)
+			{
+				result[operation] = measure(&ctx, operation, operation == COLM127_DEC ? ciphertext : message, sizes[s], operation == COLM127_DEC ? message : ciphertext, tags, tag_len);
+			}
+
+			printf("%u,%llu,%.3f,%.3f,%+.1f,%.3f,%.3f,%+.1f\n", widths[w], (unsigned long long)sizes[s],
+			       result[COLM0_ENC], result[COLM127_ENC], 100.0 * (result[COLM127_ENC] / result[COLM0_ENC] - 1.0),
+			       result[COLM0_DEC], result[COLM127_DEC], 100.0 * (result[COLM127_DEC] / result[COLM0_DEC] - 1.0));
+		}
+	}
+
+	colm_key_ctx_free(&ctx);
+	free(message);
+	free(ciphertext);
+	free(tags);
+
+	return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * Scaling of the multi-threaded functions (colm_thread.c) with the number of threads in MB/s (wall clock, best of 5 runs).
+ *
+ * Build:
+ *   cc -O3 -Isrc bench/bench_threads.c src/colm_parallel.c src/colm_dispatch.c src/colm_ad_cache.c src/colm_vaes.c src/colm_stream.c src/colm_seek.c src/colm_thread.c -o bench_threads -lpthread
+ * (on ARM with -march=armv8-a+crypto, without colm_vaes.c and together with the AES key schedule)
+ *
+ * Usage: bench_threads [max threads] (default: number of online CPUs)
+ */
+
+#include "colm.h"
+#include "bench_common.h"
+
+#define RUNS 5
+
+static const uint64_t sizes[] = { 1 << 20, 16 << 20, 64 << 20 };
+
+enum { COLM0_ENC, COLM0_DEC, COLM127_ENC, COLM127_DEC, OPERATIONS };
+
+static uint64_t wall_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static double measure(colm_thread_pool* pool, const colm_key_ctx* ctx, int operation, uint8_t* in, uint64_t len, uint8_t* out, uint8_t* ad, uint8_t* tags, uint64_t tag_len)
+{
+	uint64_t iterations = (256ull << 20) / len;
+	uint64_t best = UINT64_MAX;
+	uint64_t start, ns, out_len, tl, i;
+	int run;
+
+	if (iterations < 2)
+	{
+		iterations = 2;
+	}
+
+	for (run = 0; run < RUNS; run++)
+	{
+		start = wall_ns();
+		for (i = 0; i < iterations; i++)
+		{
+			switch (operation)
+			{
+				case COLM0_ENC:
+					colm0_encrypt_threaded(pool, ctx, in, len, ad, 0, 0, &out_len, out);
+					break;
+				case COLM0_DEC:
+					colm0_decrypt_threaded(pool, ctx, in, len + BLOCKSIZE, ad, 0, 0, &out_len, out);
+					break;
+				case COLM127_ENC:
+					tl = 0;
+					colm127_encrypt_threaded(pool, ctx, in, len, ad, 0, 0, &out_len, out, &tl, tags);
+					break;
+				case COLM127_DEC:
+					colm127_decrypt_threaded(pool, ctx, in, len + BLOCKSIZE, ad, 0, 0, tag_len, tags, &out_len, out);
+					break;
+			}
+		}
+		ns = wall_ns() - start;
+		if (ns < best)
+		{
+			best = ns;
+		}
+	}
+
+	return (double)(iterations * len) * 1000.0 / (double)best;
+}
+
+int main(int argc, char** argv)
+{
+	const uint8_t key_bytes[BLOCKSIZE] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int max_threads = argc > 1 ? atoi(argv[1]) : (int)cpus;
+	uint64_t max_len = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+	uint8_t* message = malloc(max_len);
+	uint8_t* ciphertext = malloc(max_len + BLOCKSIZE);
+	uint8_t* tags = malloc(max_len / 127 + 2 * BLOCKSIZE);
+	uint8_t ad[BLOCKSIZE] = { 0 };
+	double result[OPERATIONS];
+	colm_key_ctx ctx;
+	colm_thread_pool* pool;
+	uint64_t c_len, tag_len;
+	int threads, operation;
+	size_t s;
+
+	if (max_threads < 1 || max_threads > COLM_MAX_THREADS)
+	{
+		max_threads = max_threads < 1 ? 1 : COLM_MAX_THREADS;
+	}
+
+	if (colm_key_ctx_init(&ctx, LOAD_KEY(key_bytes)) != 0)
+	{
+		fprintf(stderr, "no AES instructions on this CPU\n");
+		return 1;
+	}
+
+	bench_fill(message, max_len);
+
+	printf("# backend: %s, %ld cpus\n", colm_backend_name(), cpus);
+	printf("threads,bytes,colm0_encrypt,colm0_decrypt,colm127_encrypt,colm127_decrypt (MB/s)\n");
+
+	// 1, 2, 4, ... and max_threads
+	for (threads = 1; ; threads *= 2)
+	{
+		if (threads > max_threads)
+		{
+			threads = max_threads;
+		}
+
+		pool = colm_thread_pool_create((uint8_t)threads);
+		if (pool == NULL)
+		{
+			fprintf(stderr, "could not create a pool with %d threads\n", threads);
+			return 1;
+		}
+
+		for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+		{
+			// COLM127 needs valid intermediate tags, otherwise the decryption stops at the first one
+			tag_len = 0;
+			colm127_encrypt_threaded(pool, &ctx, message, sizes[s], ad, 0, 0, &c_len, ciphertext, &tag_len, tags);
+
+			for (operation = 0; operation < OPERATIONS; operation++)
+			{
+				result[operation] = measure(pool, &ctx, operation, operation == COLM127_DEC ? ciphertext : message, sizes[s], operation == COLM127_DEC ? message : ciphertext, ad, tags, tag_len);
+			}
+
+			printf("%d,%llu,%.0f,%.0f,%.0f,%.0f\n", colm_thread_pool_size(pool), (unsigned long long)sizes[s], result[COLM0_ENC], result[COLM0_DEC], result[COLM127_ENC], result[COLM127_DEC]);
+		}
+
+		colm_thread_pool_free(pool);
+
+		if (threads == max_threads)
+		{
+			break;
+		}
+	}
+
+	colm_key_ctx_free(&ctx);
+	free(message);
+	free(ciphertext);
+	free(tags);
+
+	return 0;
+}
@@ -0,0 +1,215 @@
+/*
+ * AES Building blocks for ARMv8 (NEON + crypto extension).
+ * They perform AES ECB encryption
+ */
+
+#ifndef AES_CRYPTO_ARM
+#define AES_CRYPTO_ARM
+
+#include "arm_neon.h"
+#define AES_NEXT_ROUND_KEY(k, rcon) aes_next_round_key(k, rcon)
+#define AES_BACKEND_NAME "armv8-crypto"
+
+// nothing to do, the crypto extension is enabled for the whole build
+#define AES_TARGET
+#define AES_TARGET_BEGIN
+#define AES_TARGET_END
+
+typedef uint8x16_t block_t;
+
+/*
+ * Blocks are kept in memory byte order, which is the byte order of the AES instructions. The galois field arithmetic works on the two
+ * 64 bit halves as (little endian) integers, the first one is the upper and the second one the lower half of the field element
+ * (same as aes_crypto_x86.h). So loads, stores and the AES calls need no conversion.
+ */
+#define SWAP_BLOCK(block) (block)
+#define LOAD_BLOCK(ptr) vld1q_u8(ptr)
+#define STORE_BLOCK(ptr, block) vst1q_u8(ptr, block)
+#define LOAD_KEY(ptr) vld1q_u8(ptr) // keys are used as they are
+
+#define XOR_BLOCK(a, b) veorq_u8(a, b)
+#define ZERO_BLOCK() vdupq_n_u8(0)
+#define EQUALS(a, b) (vaddlvq_u8(veorq_u8(a, b)) == 0)
+
+// nonce block as expected by mac() (npub in the lower, param in the upper 64 bit)
+#define NONCE_BLOCK(npub, param) vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(npub), vcreate_u64(param)))
+
+// perform galois multiplication with 2
+static inline uint8x16_t gf_mul2(uint8x16_t x)
+{
+	uint64x2_t carry = vreinterpretq_u64_s64(vshrq_n_s64(vreinterpretq_s64_u8(x), 63)); // all ones if the top bit of the half is set
+	carry = vextq_u64(carry, carry, 1); // the lower half carries into the upper half and vice versa
+	carry = vandq_u64(carry, (uint64x2_t){ 1, 0x87 }); // overflow of the upper half is reduced with 0x87
+	return vreinterpretq_u8_u64(veorq_u64(vshlq_n_u64(vreinterpretq_u64_u8(x), 1), carry));
+}
+
+// perform galois multiplication with 2^k (1 <= k <= 56, a constant): the k bits shifted out of the upper half are reduced by a carry-less multiplication with 0x87
+static inline uint8x16_t gf_mul2k(uint8x16_t x, const int k)
+{
+	uint64x2_t halves = vreinterpretq_u64_u8(x); // the upper half in lane 0
+	uint64x2_t carry = vshlq_u64(halves, vdupq_n_s64(k - 64)); // top k bits of both halves
+	poly128_t reduced = vmull_p64((poly64_t)vgetq_lane_u64(carry, 0), (poly64_t)0x87);
+	carry = vcombine_u64(vget_high_u64(carry), vget_low_u64(vreinterpretq_u64_p128(reduced))); // the lower half carries into the upper half
+	return vreinterpretq_u8_u64(veorq_u64(vshlq_u64(halves, vdupq_n_s64(k)), carry));
+}
+
+#define AES_ENCRYPT(block, keys) do { \
+                                    for (uint8_t i = 0; i < 9; i++) \
+                                    { \
+                                        block = vaesmcq_u8(vaeseq_u8(block, keys[i])); \
+                                    } \
+                                    block = vaeseq_u8(block, keys[9]); \
+	                                block = veorq_u8(block, keys[10]); \
+								} while (0)
+
+#define AES_DECRYPT(block, keys) do { \
+                                    block = vaesdq_u8(block, keys[10]); \
+                                    for (uint8_t i = 9; i >= 1; i--) \
+                                    { \
+                                        block = vaesdq_u8(vaesimcq_u8(block), keys[i]); \
+                                    } \
+                                    block = veorq_u8(block, keys[0]); \
+								} while (0)
+
+#define AES_ENCRYPT3(block1, block2, block3, keys) do { \
+                                                    for (uint8_t i = 0; i < 9; i++) \
+                                                    { \
+                                                        block1 = vaesmcq_u8(vaeseq_u8(block1, keys[i])); \
+                                                        block2 = vaesmcq_u8(vaeseq_u8(block2, keys[i])); \
+                                                        block3 = vaesmcq_u8(vaeseq_u8(block3, keys[i])); \
+                                                    } \
+                                                    block1 = vaeseq_u8(block1, keys[9]); \
+	                                                block1 = veorq_u8(block1, keys[10]); \
+                                                    block2 = vaeseq_u8(block2, keys[9]); \
+	                                                block2 = veorq_u8(block2, keys[10]); \
+                                                    block3 = vaeseq_u8(block3, keys[9]); \
+	                                                block3 = veorq_u8(block3, keys[10]); \
+												  } while (0)
+
+#define AES_DECRYPT3(block1, block2, block3, keys) do { \
+                                                 	block1 = vaesdq_u8(block1, keys[10]); \
+													block2 = vaesdq_u8(block2, keys[10]); \
+													block3 = vaesdq_u8(block3, keys[10]); \
+                                                    for (uint8_t i = 9; i >= 1; i--) \
+                                                    { \
+                                                        block1 = vaesdq_u8(vaesimcq_u8(block1), keys[i]); \
+                                                        block2 = vaesdq_u8(vaesimcq_u8(block2), keys[i]); \
+                                                        block3 = vaesdq_u8(vaesimcq_u8(block3), keys[i]); \
+                                                    } \
+                                                    block1 = veorq_u8(block1, keys[0]); \
+                                                    block2 = veorq_u8(block2, keys[0]); \
+                                                    block3 = veorq_u8(block3, keys[0]); \
+												  } while (0)
+
+/*
+ * N-wide versions of AES_ENCRYPT3/AES_DECRYPT3. blocks is an array with (at least) n blocks.
+ * n should be a compile time constant, then the lane loops get unrolled and all blocks stay in registers.
+ */
+#define AES_ENCRYPTN(blocks, n, keys) do { \
+										for (uint8_t i = 0; i < 9; i++) \
+										{ \
+											UNROLL_LANES \
+											for (uint8_t lane = 0; lane < (n); lane++) \
+											{ \
+												blocks[lane] = vaesmcq_u8(vaeseq_u8(blocks[lane], keys[i])); \
+											} \
+										} \
+										UNROLL_LANES \
+										for (uint8_t lane = 0; lane < (n); lane++) \
+										{ \
+											blocks[lane] = vaeseq_u8(blocks[lane], keys[9]); \
+											blocks[lane] = veorq_u8(blocks[lane], keys[10]); \
+										} \
+									} while (0)
+
+#define AES_DECRYPTN(blocks, n, keys) do { \
+										UNROLL_LANES \
+										for (uint8_t lane = 0; lane < (n); lane++) \
+										{ \
+											blocks[lane] = vaesdq_u8(blocks[lane], keys[10]); \
+										} \
+										for (uint8_t i = 9; i >= 1; i--) \
+										{ \
+											UNROLL_LANES \
+											for (uint8_t lane = 0; lane < (n); lane++) \
+											{ \
+												blocks[lane] = vaesdq_u8(vaesimcq_u8(blocks[lane]), keys[i]); \
+											} \
+										} \
+										UNROLL_LANES \
+										for (uint8_t lane = 0; lane < (n); lane++) \
+										{ \
+											blocks[lane] = veorq_u8(blocks[lane], keys[0]); \
+										} \
+									} while (0)
+
+
+// same as AES_ENCRYPTN / AES_DECRYPTN, but every block has its own round keys (keys[lane] points to the 11 round keys of the block)
+#define AES_ENCRYPTN_KEYS(blocks, n, keys) do { \
+											for (uint8_t i = 0; i < 9; i++) \
+											{ \
+												UNROLL_LANES \
+												for (uint8_t lane = 0; lane < (n); lane++) \
+												{ \
+													blocks[lane] = vaesmcq_u8(vaeseq_u8(blocks[lane], keys[lane][i])); \
+												} \
+											} \
+											UNROLL_LANES \
+											for (uint8_t lane = 0; lane < (n); lane++) \
+											{ \
+												blocks[lane] = vaeseq_u8(blocks[lane], keys[lane][9]); \
+												blocks[lane] = veorq_u8(blocks[lane], keys[lane][10]); \
+											} \
+										} while (0)
+
+#define AES_DECRYPTN_KEYS(blocks, n, keys) do { \
+											UNROLL_LANES \
+											for (uint8_t lane = 0; lane < (n); lane++) \
+											{ \
+												blocks[lane] = vaesdq_u8(blocks[lane], keys[lane][10]); \
+											} \
+											for (uint8_t i = 9; i >= 1; i--) \
+											{ \
+												UNROLL_LANES \
+												for (uint8_t lane = 0; lane < (n); lane++) \
+												{ \
+													blocks[lane] = vaesdq_u8(vaesimcq_u8(blocks[lane]), keys[lane][i]); \
+												} \
+											} \
+											UNROLL_LANES \
+											for (uint8_t lane = 0; lane < (n); lane++) \
+											{ \
+												blocks[lane] = veorq_u8(blocks[lane], keys[lane][0]); \
+											} \
+										} while (0)
+
+
+#define AES_SET_ENCRYPTION_KEYS(key, encryption_keys) do { \
+                                                            encryption_keys[0] = key; \
+                                                            encryption_keys[1] = AES_NEXT_ROUND_KEY(key, 0x01); \
+                                                            encryption_keys[2] = AES_NEXT_ROUND_KEY(key, 0x02); \
+                                                            encryption_keys[3] = AES_NEXT_ROUND_KEY(key, 0x04); \
+                                                            encryption_keys[4] = AES_NEXT_ROUND_KEY(key, 0x08); \
+                                                            encryption_keys[5] = AES_NEXT_ROUND_KEY(key, 0x10); \
+                                                            encryption_keys[6] = AES_NEXT_ROUND_KEY(key, 0x20); \
+                                                            encryption_keys[7] = AES_NEXT_ROUND_KEY(key, 0x40); \
+                                                            encryption_keys[8] = AES_NEXT_ROUND_KEY(key, 0x80); \
+                                                            encryption_keys[9] = AES_NEXT_ROUND_KEY(key, 0x1b); \
+                                                            encryption_keys[10] = AES_NEXT_ROUND_KEY(key, 0x36); \
+                                                        } while(0)
+
+#define AES_SET_DECRYPTION_KEYS(encryption_keys, decryption_keys) do { \
+                                                                decryption_keys[0] = encryption_keys[0]; \
+                                                                decryption_keys[1] = vaesimcq_u8(encryption_keys[1]); \
+                                                                decryption_keys[2] = vaesimcq_u8(encryption_keys[2]); \
+                                                                decryption_keys[3] = vaesimcq_u8(encryption_keys[3]); \
+                                                                decryption_keys[4] = vaesimcq_u8(encryption_keys[4]); \
+                                                                decryption_keys[5] = vaesimcq_u8(encryption_keys[5]); \
+                                                                decryption_keys[6] = vaesimcq_u8(encryption_keys[6]); \
+                                                                decryption_keys[7] = vaesimcq_u8(encryption_keys[7]); \
+                                                                decryption_keys[8] = vaesimcq_u8(encryption_keys[8]); \
+                                                                decryption_keys[9] = vaesimcq_u8(encryption_keys[9]); \
+                                                                decryption_keys[10] = encryption_keys[10]; \
+                                                            } while (0)
+
+#endif
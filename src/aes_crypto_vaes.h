@@ -0,0 +1,122 @@
+/*
+ * Wide AES building blocks for x86-64 with VAES and AVX-512.
+ * One 512 bit register holds 4 blocks, every AES instruction works on all of them at once.
+ * The blocks are in the same representation as in aes_crypto_x86.h, so the wide and the 128 bit code can be mixed freely.
+ */
+
+#ifndef AES_CRYPTO_VAES
+#define AES_CRYPTO_VAES
+
+#include "aes_crypto.h"
+
+#define VAES_BACKEND_NAME "vaes-avx512"
+
+// like AES_TARGET in aes_crypto_x86.h: only the code in between may use VAES / AVX-512 (checked by colm_dispatch.c)
+#define VAES_TARGET __attribute__((target("aes,pclmul,vaes,avx512f")))
+#if defined(__clang__)
+#define VAES_TARGET_BEGIN _Pragma("clang attribute push (__attribute__((target(\"aes,pclmul,vaes,avx512f\"))), apply_to = function)")
+#define VAES_TARGET_END _Pragma("clang attribute pop")
+#else
+#define VAES_TARGET_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"aes,pclmul,vaes,avx512f\")")
+#define VAES_TARGET_END _Pragma("GCC pop_options")
+#endif
+
+typedef __m512i wide_block_t;
+
+#define WIDE_LANES 4 // blocks per wide register
+
+#define WIDE_LOAD(ptr) _mm512_loadu_si512((const void*)(ptr))
+#define WIDE_STORE(ptr, wide) _mm512_storeu_si512((void*)(ptr), wide)
+#define WIDE_XOR(a, b) _mm512_xor_si512(a, b)
+#define WIDE_ZERO() _mm512_setzero_si512()
+#define WIDE_BROADCAST(block) _mm512_broadcast_i32x4(block)
+
+// lane has to be a constant (0 - 3)
+#define WIDE_EXTRACT(wide, lane) _mm512_extracti32x4_epi32(wide, lane)
+#define WIDE_INSERT(wide, block, lane) _mm512_inserti32x4(wide, block, lane)
+
+// wide register from 4 blocks (b0 in the first lane)
+static inline VAES_TARGET __m512i wide_set(__m128i b0, __m128i b1, __m128i b2, __m128i b3)
+{
+	return _mm512_inserti32x4(_mm512_inserti32x4(_mm512_inserti32x4(_mm512_castsi128_si512(b0), b1, 1), b2, 2), b3, 3);
+}
+
+// xor of all 4 blocks of a wide register
+static inline VAES_TARGET __m128i wide_fold(__m512i x)
+{
+	__m256i half = _mm256_xor_si256(_mm512_castsi512_si256(x), _mm512_extracti64x4_epi64(x, 1));
+	return _mm_xor_si128(_mm256_castsi256_si128(half), _mm256_extracti128_si256(half, 1));
+}
+
+/*
+ * Galois multiplication of every block with 2^n (n doublings at once, 1 <= n <= 57).
+ * The n bits shifted out of the upper half are reduced with 0x87 = x^7 + x^2 + x + 1 into the lower half,
+ * for n <= 57 the product of those bits with 0x87 still fits into 64 bit.
+ */
+static inline VAES_TARGET __m512i wide_gf_mul_pow2(__m512i x, const int n)
+{
+	const __m128i left = _mm_cvtsi32_si128(n), right = _mm_cvtsi32_si128(64 - n);
+	__m512i carry = _mm512_srl_epi64(x, right);
+	__m512i reduced;
+
+	carry = _mm512_shuffle_epi32(carry, _MM_PERM_BADC); // the lower half carries into the upper half and vice versa
+	reduced = _mm512_xor_si512(_mm512_xor_si512(carry, _mm512_slli_epi64(carry, 1)), _mm512_xor_si512(_mm512_slli_epi64(carry, 2), _mm512_slli_epi64(carry, 7)));
+	carry = _mm512_mask_blend_epi64(0xAA, carry, reduced); // the odd 64 bit words are the lower halves
+
+	return _mm512_xor_si512(_mm512_sll_epi64(x, left), carry);
+}
+
+/*
+ * blocks is an array of n wide registers (4 * n blocks), wide_keys the round keys broadcasted to all lanes (WIDE_BROADCAST).
+ * Same round key layout as AES_ENCRYPTN/AES_DECRYPTN.
+ */
+#define AES_ENCRYPT_WIDE(blocks, n, wide_keys) do { \
+													UNROLL_LANES \
+													for (uint8_t lane = 0; lane < (n); lane++) \
+													{ \
+														blocks[lane] = _mm512_xor_si512(blocks[lane], wide_keys[0]); \
+													} \
+													for (uint8_t i = 1; i < 10; i++) \
+													{ \
+														UNROLL_LANES \
+														for (uint8_t lane = 0; lane < (n); lane++) \
+														{ \
+															blocks[lane] = _mm512_aesenc_epi128(blocks[lane], wide_keys[i]); \
+														} \
+													} \
+													UNROLL_LANES \
+													for (uint8_t lane = 0; lane < (n); lane++) \
+													{ \
+														blocks[lane] = _mm512_aesenclast_epi128(blocks[lane], wide_keys[10]); \
+													} \
+												} while (0)
+
+#define AES_DECRYPT_WIDE(blocks, n, wide_keys) do { \
+													UNROLL_LANES \
+													for (uint8_t lane = 0; lane < (n); lane++) \
+													{ \
+														blocks[lane] = _mm512_xor_si512(blocks[lane], wide_keys[10]); \
+													} \
+													for (uint8_t i = 9; i >= 1; i--) \
+													{ \
+														UNROLL_LANES \
+														for (uint8_t lane = 0; lane < (n); lane++) \
+														{ \
+															blocks[lane] = _mm512_aesdec_epi128(blocks[lane], wide_keys[i]); \
+														} \
+													} \
+													UNROLL_LANES \
+													for (uint8_t lane = 0; lane < (n); lane++) \
+													{ \
+														blocks[lane] = _mm512_aesdeclast_epi128(blocks[lane], wide_keys[0]); \
+													} \
+												} while (0)
+
+#define WIDE_SET_KEYS(keys, wide_keys) do { \
+											for (uint8_t i = 0; i < 11; i++) \
+											{ \
+												wide_keys[i] = WIDE_BROADCAST(keys[i]); \
+											} \
+										} while (0)
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * AES Building blocks for x86-64 (AES-NI).
+ * They perform AES ECB encryption
+ */
+
+#ifndef AES_CRYPTO_X86
+#define AES_CRYPTO_X86
+
+#include <immintrin.h>
+#define AES_BACKEND_NAME "aes-ni"
+
+/*
+ * The AES (and carry-less multiplication) instructions are enabled only for the code between AES_TARGET_BEGIN and AES_TARGET_END (and functions marked with AES_TARGET),
+ * so the rest of the binary still runs on CPUs without AES-NI. colm_dispatch.c checks the CPU before any of this code is used.
+ */
+#define AES_TARGET __attribute__((target("aes,pclmul")))
+#if defined(__clang__)
+#define AES_TARGET_BEGIN _Pragma("clang attribute push (__attribute__((target(\"aes,pclmul\"))), apply_to = function)")
+#define AES_TARGET_END _Pragma("clang attribute pop")
+#else
+#define AES_TARGET_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"aes,pclmul\")")
+#define AES_TARGET_END _Pragma("GCC pop_options")
+#endif
+
+typedef __m128i block_t;
+
+/*
+ * Blocks are kept in memory byte order. The galois field arithmetic treats the first 64 bit lane as the upper and the second lane as the lower
+ * half of the field element (the same layout as aes_crypto_neon.h). So no conversion is needed at all.
+ */
+#define SWAP_BLOCK(block) (block)
+#define LOAD_BLOCK(ptr) _mm_loadu_si128((const __m128i*)(ptr))
+#define STORE_BLOCK(ptr, block) _mm_storeu_si128((__m128i*)(ptr), block)
+#define LOAD_KEY(ptr) _mm_loadu_si128((const __m128i*)(ptr))
+
+#define XOR_BLOCK(a, b) _mm_xor_si128(a, b)
+#define ZERO_BLOCK() _mm_setzero_si128()
+#define EQUALS(a, b) (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xFFFF)
+
+// nonce block as expected by mac() (npub in the lower, param in the upper 64 bit)
+#define NONCE_BLOCK(npub, param) _mm_set_epi64x((long long)(param), (long long)(npub))
+
+// perform galois multiplication with 2
+static inline __m128i gf_mul2(__m128i x)
+{
+	__m128i carry = _mm_srli_epi64(x, 63); // top bit of both halves
+	carry = _mm_shuffle_epi32(carry, _MM_SHUFFLE(1, 0, 3, 2)); // the lower half carries into the upper half and vice versa
+	carry = _mm_and_si128(_mm_sub_epi64(_mm_setzero_si128(), carry), _mm_set_epi64x(0x87, 1)); // overflow of the upper half is reduced with 0x87
+	return _mm_xor_si128(_mm_slli_epi64(x, 1), carry);
+}
+
+// perform galois multiplication with 2^k (1 <= k <= 56, a constant): the k bits shifted out of the upper half are reduced by a carry-less multiplication with 0x87
+static inline AES_TARGET __m128i gf_mul2k(__m128i x, const int k)
+{
+	__m128i carry = _mm_srli_epi64(x, 64 - k); // top k bits of both halves
+	__m128i reduced = _mm_clmulepi64_si128(carry, _mm_cvtsi32_si128(0x87), 0x00);
+	carry = _mm_unpacklo_epi64(_mm_unpackhi_epi64(carry, carry), reduced); // the lower half carries into the upper half
+	return _mm_xor_si128(_mm_slli_epi64(x, k), carry);
+}
+
+#define AES_ENCRYPT(block, keys) do { \
+									block = _mm_xor_si128(block, keys[0]); \
+									for (uint8_t i = 1; i < 10; i++) \
+									{ \
+										block = _mm_aesenc_si128(block, keys[i]); \
+									} \
+									block = _mm_aesenclast_si128(block, keys[10]); \
+								} while (0)
+
+#define AES_DECRYPT(block, keys) do { \
+									block = _mm_xor_si128(block, keys[10]); \
+									for (uint8_t i = 9; i >= 1; i--) \
+									{ \
+										block = _mm_aesdec_si128(block, keys[i]); \
+									} \
+									block = _mm_aesdeclast_si128(block, keys[0]); \
+								} while (0)
+
+#define AES_ENCRYPT3(block1, block2, block3, keys) do { \
+													block1 = _mm_xor_si128(block1, keys[0]); \
+													block2 = _mm_xor_si128(block2, keys[0]); \
+													block3 = _mm_xor_si128(block3, keys[0]); \
+													for (uint8_t i = 1; i < 10; i++) \
+													{ \
+														block1 = _mm_aesenc_si128(block1, keys[i]); \
+														block2 = _mm_aesenc_si128(block2, keys[i]); \
+														block3 = _mm_aesenc_si128(block3, keys[i]); \
+													} \
+													block1 = _mm_aesenclast_si128(block1, keys[10]); \
+													block2 = _mm_aesenclast_si128(block2, keys[10]); \
+													block3 = _mm_aesenclast_si128(block3, keys[10]); \
+												} while (0)
+
+#define AES_DECRYPT3(block1, block2, block3, keys) do { \
+													block1 = _mm_xor_si128(block1, keys[10]); \
+													block2 = _mm_xor_si128(block2, keys[10]); \
+													block3 = _mm_xor_si128(block3, keys[10]); \
+													for (uint8_t i = 9; i >= 1; i--) \
+													{ \
+														block1 = _mm_aesdec_si128(block1, keys[i]); \
+														block2 = _mm_aesdec_si128(block2, keys[i]); \
+														block3 = _mm_aesdec_si128(block3, keys[i]); \
+													} \
+													block1 = _mm_aesdeclast_si128(block1, keys[0]); \
+													block2 = _mm_aesdeclast_si128(block2, keys[0]); \
+													block3 = _mm_aesdeclast_si128(block3, keys[0]); \
+												} while (0)
+
+/*
+ * N-wide versions of AES_ENCRYPT3/AES_DECRYPT3. blocks is an array with (at least) n blocks.
+ * n should be a compile time constant, then the lane loops get unrolled and all blocks stay in registers.
+ */
+#define AES_ENCRYPTN(blocks, n, keys) do { \
+										UNROLL_LANES \
+										for (uint8_t lane = 0; lane < (n); lane++) \
+										{ \
+											blocks[lane] = _mm_xor_si128(blocks[lane], keys[0]); \
+										} \
+										for (uint8_t i = 1; i < 10; i++) \
+										{ \
+											UNROLL_LANES \
+											for (uint8_t lane = 0; lane < (n); lane++) \
+											{ \
+												blocks[lane] = _mm_aesenc_si128(blocks[lane], keys[i]); \
+											} \
+										} \
+										UNROLL_LANES \
+										for (uint8_t lane = 0; lane < (n); lane++) \
+										{ \
+											blocks[lane] = _mm_aesenclast_si128(blocks[lane], keys[10]); \
+										} \
+									} while (0)
+
+#define AES_DECRYPTN(blocks, n, keys) do { \
+										UNROLL_LANES \
+										for (uint8_t lane = 0; lane < (n); lane++) \
+										{ \
+											blocks[lane] = _mm_xor_si128(blocks[lane], keys[10]); \
+										} \
+										for (uint8_t i = 9; i >= 1; i--) \
+										{ \
+											UNROLL_LANES \
+											for (uint8_t lane = 0; lane < (n); lane++) \
+											{ \
+												blocks[lane] = _mm_aesdec_si128(blocks[lane], keys[i]); \
+											} \
+										} \
+										UNROLL_LANES \
+										for (uint8_t lane = 0; lane < (n); lane++) \
+										{ \
+											blocks[lane] = _mm_aesdeclast_si128(blocks[lane], keys[0]); \
+										} \
+									} while (0)
+
+
+// same as AES_ENCRYPTN / AES_DECRYPTN, but every block has its own round keys (keys[lane] points to the 11 round keys of the block)
+#define AES_ENCRYPTN_KEYS(blocks, n, keys) do { \
+											UNROLL_LANES \
+											for (uint8_t lane = 0; lane < (n); lane++) \
+											{ \
+												blocks[lane] = _mm_xor_si128(blocks[lane], keys[lane][0]); \
+											} \
+											for (uint8_t i = 1; i < 10; i++) \
+											{ \
+												UNROLL_LANES \
+												for (uint8_t lane = 0; lane < (n); lane++) \
+												{ \
+													blocks[lane] = _mm_aesenc_si128(blocks[lane], keys[lane][i]); \
+												} \
+											} \
+											UNROLL_LANES \
+											for (uint8_t lane = 0; lane < (n); lane++) \
+											{ \
+												blocks[lane] = _mm_aesenclast_si128(blocks[lane], keys[lane][10]); \
+											} \
+										} while (0)
+
+#define AES_DECRYPTN_KEYS(blocks, n, keys) do { \
+											UNROLL_LANES \
+											for (uint8_t lane = 0; lane < (n); lane++) \
+											{ \
+												blocks[lane] = _mm_xor_si128(blocks[lane], keys[lane][10]); \
+											} \
+											for (uint8_t i = 9; i >= 1; i--) \
+											{ \
+												UNROLL_LANES \
+												for (uint8_t lane = 0; lane < (n); lane++) \
+												{ \
+													blocks[lane] = _mm_aesdec_si128(blocks[lane], keys[lane][i]); \
+												} \
+											} \
+											UNROLL_LANES \
+											for (uint8_t lane = 0; lane < (n); lane++) \
+											{ \
+												blocks[lane] = _mm_aesdeclast_si128(blocks[lane], keys[lane][0]); \
+											} \
+										} while (0)
+
+
+// one step of the AES-128 key schedule, assist is the result of aeskeygenassist for the previous round key
+static inline AES_TARGET __m128i aes_next_round_key(__m128i key, __m128i assist)
+{
+	assist = _mm_shuffle_epi32(assist, _MM_SHUFFLE(3, 3, 3, 3));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	return _mm_xor_si128(key, assist);
+}
+
+// the round constant has to be an immediate
+#define AES_NEXT_ROUND_KEY(k, rcon) aes_next_round_key(k, _mm_aeskeygenassist_si128(k, rcon))
+
+#define AES_SET_ENCRYPTION_KEYS(key, encryption_keys) do { \
+                                                            encryption_keys[0] = key; \
+                                                            encryption_keys[1] = AES_NEXT_ROUND_KEY(encryption_keys[0], 0x01); \
+                                                            encryption_keys[2] = AES_NEXT_ROUND_KEY(encryption_keys[1], 0x02); \
+                                                            encryption_keys[3] = AES_NEXT_ROUND_KEY(encryption_keys[2], 0x04); \
+                                                            encryption_keys[4] = AES_NEXT_ROUND_KEY(encryption_keys[3], 0x08); \
+                                                            encryption_keys[5] = AES_NEXT_ROUND_KEY(encryption_keys[4], 0x10); \
+                                                            encryption_keys[6] = AES_NEXT_ROUND_KEY(encryption_keys[5], 0x20); \
+                                                            encryption_keys[7] = AES_NEXT_ROUND_KEY(encryption_keys[6], 0x40); \
+                                                            encryption_keys[8] = AES_NEXT_ROUND_KEY(encryption_keys[7], 0x80); \
+                                                            encryption_keys[9] = AES_NEXT_ROUND_KEY(encryption_keys[8], 0x1b); \
+                                                            encryption_keys[10] = AES_NEXT_ROUND_KEY(encryption_keys[9], 0x36); \
+                                                        } while(0)
+
+// same layout as on ARM: the inner round keys get the inverse mix columns, AES_DECRYPT runs through them backwards
+#define AES_SET_DECRYPTION_KEYS(encryption_keys, decryption_keys) do { \
+                                                                decryption_keys[0] = encryption_keys[0]; \
+                                                                decryption_keys[1] = _mm_aesimc_si128(encryption_keys[1]); \
+                                                                decryption_keys[2] = _mm_aesimc_si128(encryption_keys[2]); \
+                                                                decryption_keys[3] = _mm_aesimc_si128(encryption_keys[3]); \
+                                                                decryption_keys[4] = _mm_aesimc_si128(encryption_keys[4]); \
+                                                                decryption_keys[5] = _mm_aesimc_si128(encryption_keys[5]); \
+                                                                decryption_keys[6] = _mm_aesimc_si128(encryption_keys[6]); \
+                                                                decryption_keys[7] = _mm_aesimc_si128(encryption_keys[7]); \
+                                                                decryption_keys[8] = _mm_aesimc_si128(encryption_keys[8]); \
+                                                                decryption_keys[9] = _mm_aesimc_si128(encryption_keys[9]); \
+                                                                decryption_keys[10] = encryption_keys[10]; \
+                                                            } while (0)
+
+#endif
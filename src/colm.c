@@ -7,51 +7,40 @@
 
 #include "colm.h"
 
-
-#define EQUALS(a, b) (vaddlvq_u8(veorq_u8(a, b)) == 0)
+// everything below uses the AES instructions (see aes_crypto.h)
+AES_TARGET_BEGIN
 
 
 #define RHO_INPLACE(x, st, w_new) do { \
-									w_new = veorq_u8(gf_mul2(st), x); \
-									x = veorq_u8(w_new, st); \
+									w_new = XOR_BLOCK(gf_mul2(st), x); \
+									x = XOR_BLOCK(w_new, st); \
 									st = w_new; \
 								} while(0)
 
 #define RHO_INVERSE_INPLACE(y, st, w_new) do { \
 											w_new = gf_mul2(st); \
-											st = veorq_u8(st, y); \
-											y = veorq_u8(w_new, st); \
+											st = XOR_BLOCK(st, y); \
+											y = XOR_BLOCK(w_new, st); \
 										} while(0)
 
-#define LOAD_BLOCK(ptr) vrev64q_u8(vld1q_u8(ptr)) // load and change endianness
-#define STORE_BLOCK(ptr, block) vst1q_u8(ptr, vrev64q_u8(block))
-
-uint8x16_t gf_mul2(uint8x16_t x)
-{
-	uint8x16_t temp = vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(x), 7));
-	uint8x16_t x64 = vshlq_n_u8(x, 1); // multiply by two
-	x64 = vorrq_u8(x64, vandq_u8(vextq_u8(temp, zero_vector, 1), ((uint8x16_t){1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0}))); // handle overflow bit from lower bytes to higher bytes
-	return veorq_u8(x64, vandq_u8(vdupq_laneq_u8(temp, 0), (uint8x16_t){0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x87}));
-}
-
-uint8x16_t gf_mul3(uint8x16_t x)
+block_t gf_mul3(block_t x)
 {
-	return veorq_u8(gf_mul2(x), x);
+	return XOR_BLOCK(gf_mul2(x), x);
 }
 
-uint8x16_t gf_mul7(uint8x16_t x)
+block_t gf_mul7(block_t x)
 {
-	uint8x16_t tmp = gf_mul2(x);
-	return veorq_u8(veorq_u8(gf_mul2(tmp), tmp), x);
+	block_t tmp = gf_mul2(x);
+	return XOR_BLOCK(XOR_BLOCK(gf_mul2(tmp), tmp), x);
 }
 
-uint8x16_t mac(uint8x16_t npub_param, uint8_t* associated_data, const uint64_t data_len, uint8x16_t L, uint8x16_t* aes_round_keys)
+block_t mac(block_t npub_param, uint8_t* associated_data, const uint64_t data_len, block_t L, block_t* aes_round_keys)
 {
 	uint8_t* in = associated_data;
 	uint64_t len = data_len;
 	uint8_t buf[16] = { 0 };
-	uint8x16_t block, v, delta = gf_mul3(L);
-	v = veorq_u8(vrev64q_u8(npub_param), delta);
+	block_t block, v, delta = gf_mul3(L);
+	v = XOR_BLOCK(SWAP_BLOCK(npub_param), delta);
 	AES_ENCRYPT(v, aes_round_keys);
 
 	while (len >= BLOCKSIZE) {
@@ -59,11 +48,11 @@ uint8x16_t mac(uint8x16_t npub_param, uint8_t* associated_data, const uint64_t d
 
 		delta = gf_mul2(delta);
 
-		block = veorq_u8(block, delta);
+		block = XOR_BLOCK(block, delta);
 
 		AES_ENCRYPT(block, aes_round_keys);
 		
-		v = veorq_u8(v, block);
+		v = XOR_BLOCK(v, block);
 
 		in += BLOCKSIZE;
 		len -= BLOCKSIZE;
@@ -74,10 +63,10 @@ uint8x16_t mac(uint8x16_t npub_param, uint8_t* associated_data, const uint64_t d
 		memcpy(buf, in, len);
 		buf[len] ^= 0x80; /* padding */
 		block = LOAD_BLOCK(buf);
-		block = veorq_u8(delta, block);
+		block = XOR_BLOCK(delta, block);
 
 		AES_ENCRYPT(block, aes_round_keys);
-		v = veorq_u8(v, block);
+		v = XOR_BLOCK(v, block);
 	}
 
 	return v;
@@ -87,14 +76,14 @@ uint8x16_t mac(uint8x16_t npub_param, uint8_t* associated_data, const uint64_t d
 
 /* ----------------------- COLM 0 ------------------------- */
 
-int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8x16_t key, uint64_t* c_len, uint8_t* ciphertext)
+int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t* c_len, uint8_t* ciphertext)
 {
-	uint8x16_t checksum = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-	uint8x16_t w, w_tmp;
-	uint8x16_t block;
-	uint8x16_t aes_round_keys[11];
-	uint8x16_t delta_m, delta_c;
-	uint8x16_t L = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+	block_t checksum = ZERO_BLOCK();
+	block_t w, w_tmp;
+	block_t block;
+	block_t aes_round_keys[11];
+	block_t delta_m, delta_c;
+	block_t L = ZERO_BLOCK();
 
 	const uint8_t* in = message;
 	uint8_t* out = ciphertext;
@@ -107,7 +96,7 @@ int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated
 	
 	AES_ENCRYPT(L, aes_round_keys);
 
-	w = mac(vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(npub), ((uint64x1_t){0x0000800000000000}))), associated_data, data_len, L, aes_round_keys);
+	w = mac(NONCE_BLOCK(npub, 0x0000800000000000), associated_data, data_len, L, aes_round_keys);
 	
 
 	delta_m = L;
@@ -121,9 +110,9 @@ int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated
 
 		block = LOAD_BLOCK(in);
 		
-		checksum = veorq_u8(checksum, block);
+		checksum = XOR_BLOCK(checksum, block);
 		
-		block = veorq_u8(block, delta_m);
+		block = XOR_BLOCK(block, delta_m);
 
 		AES_ENCRYPT(block, aes_round_keys);
 
@@ -133,7 +122,7 @@ int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated
 
 		AES_ENCRYPT(block, aes_round_keys);
 
-		block = veorq_u8(block, delta_c);
+		block = XOR_BLOCK(block, delta_c);
 
 		STORE_BLOCK(out, block);
 
@@ -158,9 +147,9 @@ int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated
 
 	block = LOAD_BLOCK(buf);//vld1q_u8(buf);
 
-	block = checksum = veorq_u8(checksum, block);
+	block = checksum = XOR_BLOCK(checksum, block);
 	
-	block = veorq_u8(block, delta_m);
+	block = XOR_BLOCK(block, delta_m);
 
 	AES_ENCRYPT(block, aes_round_keys);
 
@@ -168,7 +157,7 @@ int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated
 
 	AES_ENCRYPT(block, aes_round_keys);
 
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 
 	STORE_BLOCK(out, block);
 
@@ -184,13 +173,13 @@ int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated
 	delta_m = gf_mul2(delta_m);
 	delta_c = gf_mul2(delta_c);
 
-	block = veorq_u8(delta_m, checksum);
+	block = XOR_BLOCK(delta_m, checksum);
 	AES_ENCRYPT(block, aes_round_keys);
 
 	RHO_INPLACE(block, w, w_tmp);
 
 	AES_ENCRYPT(block, aes_round_keys);
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 
 	STORE_BLOCK((uint8_t*)buf, block);
 	memcpy(out, buf, remaining);
@@ -198,15 +187,15 @@ int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated
 	return 0;
 }
 
-int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8x16_t key, uint64_t* m_len, uint8_t* message)
+int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t* m_len, uint8_t* message)
 {
-	uint8x16_t checksum = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-	uint8x16_t w, w_tmp;
-	uint8x16_t block;
-	uint8x16_t encryption_keys[11];
-	uint8x16_t decryption_keys[11];
-	uint8x16_t delta_m, delta_c;
-	uint8x16_t L = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+	block_t checksum = ZERO_BLOCK();
+	block_t w, w_tmp;
+	block_t block;
+	block_t encryption_keys[11];
+	block_t decryption_keys[11];
+	block_t delta_m, delta_c;
+	block_t L = ZERO_BLOCK();
 
 	const uint8_t* in = ciphertext;
 	uint8_t* out = message;
@@ -227,7 +216,7 @@ int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data
 	delta_m = L;
 	delta_c = gf_mul3(gf_mul3(L));
 
-	w = mac(vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(npub), ((uint64x1_t){0x0000800000000000}))), associated_data, data_len, L, encryption_keys);
+	w = mac(NONCE_BLOCK(npub, 0x0000800000000000), associated_data, data_len, L, encryption_keys);
 
 
 	while (remaining > BLOCKSIZE) {
@@ -235,7 +224,7 @@ int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data
 
 		block = LOAD_BLOCK(in);
 
-		block = veorq_u8(block, delta_c);
+		block = XOR_BLOCK(block, delta_c);
 
 		AES_DECRYPT(block, decryption_keys);
 		
@@ -245,9 +234,9 @@ int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data
 
 		AES_DECRYPT(block, decryption_keys);
 		
-		block = veorq_u8(block, delta_m);
+		block = XOR_BLOCK(block, delta_m);
 		
-		checksum = veorq_u8(checksum, block);
+		checksum = XOR_BLOCK(checksum, block);
 		
 		STORE_BLOCK(out, block);
 
@@ -268,17 +257,17 @@ int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data
 	}
 
 	block = LOAD_BLOCK(in);
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 	AES_DECRYPT(block, decryption_keys);
 
 	/* (X,W') = rho^-1(block, W) */
 	RHO_INVERSE_INPLACE(block, w, w_tmp);
 
 	AES_DECRYPT(block, decryption_keys);
-	block = veorq_u8(block, delta_m);
+	block = XOR_BLOCK(block, delta_m);
 	/* block now contains M[l] = M[l+1] */
 	
-	checksum = veorq_u8(checksum, block);
+	checksum = XOR_BLOCK(checksum, block);
 	/* checksum now contains M*[l] */
 	in += BLOCKSIZE;
 	
@@ -293,14 +282,14 @@ int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data
 	delta_m = gf_mul2(delta_m);
 	delta_c = gf_mul2(delta_c);
 
-	block = veorq_u8(delta_m, block);
+	block = XOR_BLOCK(delta_m, block);
 	AES_ENCRYPT(block, encryption_keys);
 	
 	/* (Y,W') = rho(block, W) */
 	RHO_INPLACE(block, w, w_tmp);
 
 	AES_ENCRYPT(block, encryption_keys);
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 	/* block now contains C'[l+1] */
 
 	STORE_BLOCK(buf, block);
@@ -329,15 +318,15 @@ int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data
 
 /* ------------------ COLM 127 ------------------- */
 
-int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8x16_t key, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags)
+int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags)
 {
 
-	uint8x16_t checksum = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-	uint8x16_t w, w_tmp;
-	uint8x16_t block;
-	uint8x16_t aes_round_keys[11];
-	uint8x16_t delta_m, delta_c;
-	uint8x16_t L = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+	block_t checksum = ZERO_BLOCK();
+	block_t w, w_tmp;
+	block_t block;
+	block_t aes_round_keys[11];
+	block_t delta_m, delta_c;
+	block_t L = ZERO_BLOCK();
 
 	const uint8_t* in = message;
 	uint8_t* out = ciphertext;
@@ -354,7 +343,7 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 	delta_m = L; 
 	delta_c = gf_mul3(gf_mul3(L));
 
-	w = mac(vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(npub), ((uint64x1_t){0x007F800000000000}))), associated_data, data_len, L, aes_round_keys);
+	w = mac(NONCE_BLOCK(npub, 0x007F800000000000), associated_data, data_len, L, aes_round_keys);
 	
 	while(remaining > BLOCKSIZE)
 	{
@@ -363,9 +352,9 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 
 		block = LOAD_BLOCK(in);
 		
-		checksum = veorq_u8(checksum, block);
+		checksum = XOR_BLOCK(checksum, block);
 
-		block = veorq_u8(block, delta_m);
+		block = XOR_BLOCK(block, delta_m);
 
 		AES_ENCRYPT(block, aes_round_keys);
 
@@ -375,9 +364,9 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 		if (iteration_counter % 127 == 0)
 		{
 			delta_c = gf_mul2(delta_c);
-			uint8x16_t tag = w;
+			block_t tag = w;
 			AES_ENCRYPT(tag, aes_round_keys);
-			tag = veorq_u8(tag, delta_c);
+			tag = XOR_BLOCK(tag, delta_c);
 			STORE_BLOCK(tag_out, tag);
 			tag_out += BLOCKSIZE;
 			*tag_len += BLOCKSIZE;
@@ -385,7 +374,7 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 
 		AES_ENCRYPT(block, aes_round_keys);
 		
-		block = veorq_u8(block, delta_c);
+		block = XOR_BLOCK(block, delta_c);
 
 		STORE_BLOCK(out, block);
 
@@ -411,9 +400,9 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 
 	block = LOAD_BLOCK(buf);//vld1q_u8(buf);
 
-	block = checksum = veorq_u8(checksum, block);
+	block = checksum = XOR_BLOCK(checksum, block);
 	
-	block = veorq_u8(block, delta_m);
+	block = XOR_BLOCK(block, delta_m);
 
 	AES_ENCRYPT(block, aes_round_keys);
 
@@ -421,7 +410,7 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 
 	AES_ENCRYPT(block, aes_round_keys);
 
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 
 	STORE_BLOCK(out, block);
 
@@ -431,9 +420,9 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 	if (iteration_counter % 127 == 0)
 	{
 		delta_c = gf_mul2(delta_c);
-		uint8x16_t tag = w;
-		AES_ENCRYPT(w, aes_round_keys);
-		tag = veorq_u8(tag, delta_c);
+		block_t tag = w;
+		AES_ENCRYPT(tag, aes_round_keys);
+		tag = XOR_BLOCK(tag, delta_c);
 		STORE_BLOCK(tag_out, tag);
 		tag_out += BLOCKSIZE;
 		*tag_len += BLOCKSIZE;
@@ -448,13 +437,13 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 	delta_m = gf_mul2(delta_m);
 	delta_c = gf_mul2(delta_c);
 
-	block = veorq_u8(delta_m, checksum);
+	block = XOR_BLOCK(delta_m, checksum);
 	AES_ENCRYPT(block, aes_round_keys);
 
 	RHO_INPLACE(block, w, w_tmp);
 
 	AES_ENCRYPT(block, aes_round_keys);
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 
 	STORE_BLOCK((uint8_t*)buf, block);
 	memcpy(out, buf, remaining);
@@ -462,16 +451,16 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 	return 0;
 }
 
-int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8x16_t key, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message)
+int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message)
 {
 
-	uint8x16_t checksum = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-	uint8x16_t w, w_tmp;
-	uint8x16_t block;
-	uint8x16_t encryption_keys[11];
-	uint8x16_t decryption_keys[11];
-	uint8x16_t delta_m, delta_c;
-	uint8x16_t L = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+	block_t checksum = ZERO_BLOCK();
+	block_t w, w_tmp;
+	block_t block;
+	block_t encryption_keys[11];
+	block_t decryption_keys[11];
+	block_t delta_m, delta_c;
+	block_t L = ZERO_BLOCK();
 
 	const uint8_t* in = ciphertext;
 	uint8_t* out = message;
@@ -497,7 +486,7 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 	delta_m = L;
 	delta_c = gf_mul3(gf_mul3(L));
 
-	w = mac(vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(npub), ((uint64x1_t){0x007F800000000000}))), associated_data, data_len, L, encryption_keys);
+	w = mac(NONCE_BLOCK(npub, 0x007F800000000000), associated_data, data_len, L, encryption_keys);
 	
 	while (remaining > BLOCKSIZE) {
 		itag = iteration_counter % 127;
@@ -511,7 +500,7 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 			delta_c = gf_mul2(delta_c);
 		}
 
-		block = veorq_u8(block, delta_c);
+		block = XOR_BLOCK(block, delta_c);
 
 		AES_DECRYPT(block, decryption_keys);
 		
@@ -521,8 +510,8 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 		if (itag == 0)
 		{	
 			
-			uint8x16_t tag = LOAD_BLOCK(tag_in);
-			tag = veorq_u8(tag, delta_c);
+			block_t tag = LOAD_BLOCK(tag_in);
+			tag = XOR_BLOCK(tag, delta_c);
 			AES_DECRYPT(tag, decryption_keys);
 			if (!EQUALS(tag, w))
 			{
@@ -533,9 +522,9 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 
 		AES_DECRYPT(block, decryption_keys);
 		
-		block = veorq_u8(block, delta_m);
+		block = XOR_BLOCK(block, delta_m);
 		
-		checksum = veorq_u8(checksum, block);
+		checksum = XOR_BLOCK(checksum, block);
 		
 		STORE_BLOCK(out, block);
 
@@ -555,17 +544,17 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 	}
 
 	block = LOAD_BLOCK(in);
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 	AES_DECRYPT(block, decryption_keys);
 
 	/* (X,W') = rho^-1(block, W) */
 	RHO_INVERSE_INPLACE(block, w, w_tmp);
 
 	AES_DECRYPT(block, decryption_keys);
-	block = veorq_u8(block, delta_m);
+	block = XOR_BLOCK(block, delta_m);
 	/* block now contains M[l] = M[l+1] */
 	
-	checksum = veorq_u8(checksum, block);
+	checksum = XOR_BLOCK(checksum, block);
 	/* checksum now contains M*[l] */
 	in += BLOCKSIZE;
 	
@@ -580,8 +569,8 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 	if (iteration_counter % 127 == 0)
 	{		
 		delta_c = gf_mul2(delta_c);
-		uint8x16_t tag = LOAD_BLOCK(tag_in);
-		tag = veorq_u8(tag, delta_c);
+		block_t tag = LOAD_BLOCK(tag_in);
+		tag = XOR_BLOCK(tag, delta_c);
 		AES_DECRYPT(tag, decryption_keys);
 		if (!EQUALS(tag, w))
 		{
@@ -594,14 +583,14 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 	delta_m = gf_mul2(delta_m);
 	delta_c = gf_mul2(delta_c);
 
-	block = veorq_u8(delta_m, block);
+	block = XOR_BLOCK(delta_m, block);
 	AES_ENCRYPT(block, encryption_keys);
 	
 	/* (Y,W') = rho(block, W) */
 	RHO_INPLACE(block, w, w_tmp);
 
 	AES_ENCRYPT(block, encryption_keys);
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 	/* block now contains C'[l+1] */
 
 	STORE_BLOCK(buf, block);
@@ -623,3 +612,5 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 
 	return 0;
 }
+
+AES_TARGET_END
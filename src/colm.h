@@ -5,13 +5,307 @@
 #include <string.h>
 
 
-uint8x16_t mac(uint8x16_t npub_param, uint8_t* associated_data, const uint64_t data_len, uint8x16_t L, uint8x16_t* aes_round_keys);
+/*
+ * Number of blocks the pipelined implementation processes at once.
+ * 3 matches the AES pipeline of the Cortex-A cores this implementation was written for, newer cores can keep 6 - 8 AES rounds in flight.
+ * Supported values are 3, 4, 6 and 8. The width can also be changed per key context (colm_key_ctx_set_pipeline_width).
+ */
+#ifndef COLM_PIPELINE_WIDTH
+#define COLM_PIPELINE_WIDTH 3
+#endif
+
+#if COLM_PIPELINE_WIDTH != 3 && COLM_PIPELINE_WIDTH != 4 && COLM_PIPELINE_WIDTH != 6 && COLM_PIPELINE_WIDTH != 8
+#error "COLM_PIPELINE_WIDTH has to be 3, 4, 6 or 8"
+#endif
+
+#define COLM_MAX_PIPELINE_WIDTH 8
+
+// number of deltas of the first blocks of a message kept in the key context (enough for 16 lanes of the VAES implementation)
+#define COLM_DELTA_WINDOW 16
+
+
+/*
+ * Key context
+ * Holds everything that only depends on the key. It is prepared once by colm_key_ctx_init and can then be used for any number of messages.
+ */
+typedef struct colm_key_ctx
+{
+	block_t aes_encryption_keys[11];
+	block_t aes_decryption_keys[11];
+	block_t L;           // L = E_K(0), initial delta_m
+	block_t delta_ad;    // 3 * L, initial delta of the MAC
+	block_t delta_c;     // 3 * 3 * L, initial delta_c
+	block_t delta_m_window[COLM_DELTA_WINDOW];  // L * 2^1 ... L * 2^16, delta_m of the first blocks
+	block_t delta_c_window[COLM_DELTA_WINDOW];  // same for delta_c
+	block_t delta_ad_window[COLM_DELTA_WINDOW]; // same for the delta of the MAC
+	uint8_t pipeline_width; // number of blocks processed at once by the pipelined loops
+} colm_key_ctx;
+
+
+// chaining state of a message between two of its blocks
+typedef struct colm_state
+{
+	block_t w;           // rho state, starts with the MAC of nonce and associated data
+	block_t checksum;    // xor of the message blocks
+	block_t delta_m, delta_c;
+} colm_state;
+
+
+int8_t colm_key_ctx_init(colm_key_ctx* ctx, block_t key);
+void colm_key_ctx_free(colm_key_ctx* ctx);
+int8_t colm_key_ctx_set_pipeline_width(colm_key_ctx* ctx, uint8_t width);
+
+/*
+ * The implementation is selected at load time depending on the CPU (colm_dispatch.c).
+ * If the CPU has no AES instructions all functions return -6.
+ */
+const char* colm_backend_name(void); // "vaes-avx512", "aes-ni", "armv8-crypto" or "none"
+int8_t colm_backend_select(const char* name); // force an implementation, e.g. "aes-ni" on a VAES machine (-6 if the CPU can't run it)
+
+/*
+ * Counters of the hot paths per phase, to see where the time goes on real traffic (src/colm_stats.h).
+ * They are only collected if the library is built with -DCOLM_STATS, otherwise the loops contain no trace of them and
+ * colm_stats_snapshot / colm_stats_reset return -1. The counters belong to the calling thread (the work of a colm_thread pool is counted
+ * in its workers). cycles are time stamp counter ticks (rdtsc / CNTVCT_EL0), reading the counter between the phases of every group costs
+ * a little and the out-of-order overlap of two phases is counted for the later one. Short messages (up to COLM_SHORT_LEN) have no tail,
+ * their last block and tag are lanes of the two layers.
+ */
+#define COLM_PHASE_MAC 0    // nonce and associated data (with colm0_encrypt_ctx also the first layer of the blocks that run along)
+#define COLM_PHASE_LAYER1 1 // first AES layer of the pipelined groups
+#define COLM_PHASE_RHO 2    // rho / rho^-1 of the groups (and the check of the intermediate tags)
+#define COLM_PHASE_LAYER2 3 // second AES layer and the stores
+#define COLM_PHASE_TAIL 4   // blocks after the last group, last block, checksum and tag
+#define COLM_PHASES 5
+#define COLM_STATS_STATUSES 9
+
+typedef struct colm_stats
+{
+	uint64_t cycles[COLM_PHASES];
+	uint64_t blocks[COLM_PHASES];
+	uint64_t failures[COLM_STATS_STATUSES]; // failures[i]: decryptions and verifications (*_ctx, *_verify, *_cached) that returned -i
+} colm_stats;
+
+int8_t colm_stats_snapshot(colm_stats* stats); // copy of the counters of the calling thread
+int8_t colm_stats_reset(void);
+
+
+block_t mac(block_t npub_param, uint8_t* associated_data, const uint64_t data_len, block_t L, block_t* aes_round_keys);
+
+
+/*
+ * In-place: the output may be the input buffer (ciphertext == message and message == ciphertext), also for the *_ctx, tau, cached, threaded,
+ * batch and scatter / gather versions below. The ciphertext is 16 bytes (the tag) longer than the message, so an in-place encryption needs
+ * this slack behind the message. Buffers that overlap at different positions are not supported, neither is colm127_encrypt_inband in place.
+ * An in-place decryption overwrites the ciphertext even if the verification fails.
+ */
+int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t* c_len, uint8_t* c);
+int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t* m_len, uint8_t* message);
+
+int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags);
+int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message);
+
+// same as above, but with a prepared key context (only provided by the pipelined implementation, dispatched at runtime)
+int8_t colm0_encrypt_ctx(const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* c);
+int8_t colm0_decrypt_ctx(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* m_len, uint8_t* message);
+
+int8_t colm127_encrypt_ctx(const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags);
+int8_t colm127_decrypt_ctx(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message);
+
+/*
+ * COLM with an intermediate tag after every tau. block (COLM127 is tau = 127, tau = 0 is COLM0 without intermediate tags).
+ * A smaller tau finds a modification earlier and costs one AES call per tau blocks, tau is part of the nonce block so the outputs of
+ * different intervals are unrelated. The tags array needs 16 bytes per tau blocks (blocks / tau tags, the last block counts).
+ */
+int8_t colm_tau_encrypt_ctx(const colm_key_ctx* ctx, uint16_t tau, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags);
+int8_t colm_tau_decrypt_ctx(const colm_key_ctx* ctx, uint16_t tau, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message);
+
+/*
+ * Verification only: checks the tag (and the intermediate tags) of a ciphertext like the decryption, but stores no plaintext.
+ * Returns the status code the decryption would return (0 => valid, -1 also if tag_len holds fewer intermediate tags than the length needs).
+ * Meant for integrity checks of stored data, where the plaintext is not needed.
+ */
+int8_t colm0_verify(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub);
+int8_t colm127_verify(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t tag_len, uint8_t* tags);
+
+
+/*
+ * Associated data cache (colm_ad_cache.c).
+ * The part of the MAC that only depends on the associated data is calculated once, so messages with the same associated data
+ * (e.g. a fixed protocol header) skip all of its AES calls. The cache holds the associated data or a fixed prefix of it,
+ * the associated data of a *_cached call is the cached data followed by suffix (suffix_len may be 0).
+ * The output is the same as of the functions above. -7 => the cache was created for another key context
+ */
+typedef struct colm_ad_cache colm_ad_cache;
+
+colm_ad_cache* colm_ad_cache_create(const colm_key_ctx* ctx, const uint8_t* associated_data, uint64_t data_len); // NULL on error
+void colm_ad_cache_free(colm_ad_cache* cache);
+
+int8_t colm0_encrypt_cached(const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, const colm_ad_cache* cache, const uint8_t* suffix, uint64_t suffix_len, uint64_t npub, uint64_t* c_len, uint8_t* c);
+int8_t colm0_decrypt_cached(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, const colm_ad_cache* cache, const uint8_t* suffix, uint64_t suffix_len, uint64_t npub, uint64_t* m_len, uint8_t* message);
+
+int8_t colm127_encrypt_cached(const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, const colm_ad_cache* cache, const uint8_t* suffix, uint64_t suffix_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags);
+int8_t colm127_decrypt_cached(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, const colm_ad_cache* cache, const uint8_t* suffix, uint64_t suffix_len, uint64_t npub, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message);
+
+
+/*
+ * COLM127 with the intermediate tags inside the ciphertext (colm_inband.c), every tag directly follows the block it belongs to.
+ * The ciphertext has colm127_inband_len(message_len) bytes, colm127_tags_len is the size of the tags array of the functions above.
+ */
+uint64_t colm127_inband_len(uint64_t message_len);
+uint64_t colm127_tags_len(uint64_t message_len);
+
+int8_t colm127_encrypt_inband(const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext);
+int8_t colm127_decrypt_inband(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* m_len, uint8_t* message);
+
+
+/*
+ * Streaming versions (colm_stream.c) for messages that are not in memory at once.
+ * init takes nonce and associated data, update any number of chunks of any length and final finishes the message.
+ * update outputs all full blocks it can (multiples of 16 bytes, at most len + 15), the last block (and the tag of a ciphertext) are held back until final.
+ * The outputs of all calls together are the same as the output of the one-shot functions, *c_len / *m_len / *tag_len are set to the bytes written by the call.
+ * The decryption releases the plaintext before final has checked the tag (like colm0_decrypt writes it before the check), it must not be used if final fails.
+ */
+typedef struct colm_stream
+{
+	const colm_key_ctx* ctx;
+	colm_state state;
+	uint64_t until_tag;         // blocks until the next intermediate tag (COLM127)
+	uint8_t tag_interval;       // 127 for COLM127, 0 for COLM0
+	uint8_t buffered;           // bytes in buf
+	uint8_t buf[2 * BLOCKSIZE]; // held back: the last block (and the tag of a ciphertext)
+} colm_stream;
+
+int8_t colm0_encrypt_init(colm_stream* st, const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub);
+int8_t colm0_encrypt_update(colm_stream* st, const uint8_t* message, uint64_t len, uint8_t* ciphertext, uint64_t* c_len);
+int8_t colm0_encrypt_final(colm_stream* st, uint8_t* ciphertext, uint64_t* c_len); // at most 32 bytes
+
+int8_t colm0_decrypt_init(colm_stream* st, const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub);
+int8_t colm0_decrypt_update(colm_stream* st, const uint8_t* ciphertext, uint64_t len, uint8_t* message, uint64_t* m_len);
+int8_t colm0_decrypt_final(colm_stream* st, uint8_t* message, uint64_t* m_len); // at most 16 bytes, result of the verification
+
+int8_t colm127_encrypt_init(colm_stream* st, const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub);
+int8_t colm127_encrypt_update(colm_stream* st, const uint8_t* message, uint64_t len, uint8_t* ciphertext, uint64_t* c_len, uint8_t* tags, uint64_t* tag_len);
+int8_t colm127_encrypt_final(colm_stream* st, uint8_t* ciphertext, uint64_t* c_len, uint8_t* tags, uint64_t* tag_len); // at most 32 bytes and one tag
+
+/*
+ * Streaming COLM127 decryption that only releases verified plaintext.
+ * The plaintext of a segment (127 blocks) stays in the window of the stream until the intermediate tag at its end has been checked,
+ * update then outputs the whole segment (so message needs room for len + COLM_STREAM_WINDOW bytes), final the rest after the end tag.
+ * The tags are passed to update in order, each one with or before the chunk that completes its segment (e.g. the tags colm127_encrypt_update
+ * returned together with the chunk), at most COLM_STREAM_TAGS ahead.
+ * After an error every call returns it again: -5 => intermediate tag invalid, -8 => the tags are out of step with the ciphertext.
+ */
+#define COLM_STREAM_WINDOW (127 * BLOCKSIZE)
+#define COLM_STREAM_TAGS 4
+
+typedef struct colm127_decrypt_stream
+{
+	colm_stream stream;
+	int8_t status;                               // first error, the stream stops there
+	uint8_t tags_queued;
+	uint8_t tags[COLM_STREAM_TAGS * BLOCKSIZE];  // received, but their segment is not complete yet
+	uint16_t window_len;
+	uint8_t window[COLM_STREAM_WINDOW];          // plaintext of the current segment, not verified yet
+} colm127_decrypt_stream;
+
+int8_t colm127_decrypt_init(colm127_decrypt_stream* st, const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub);
+int8_t colm127_decrypt_update(colm127_decrypt_stream* st, const uint8_t* ciphertext, uint64_t len, const uint8_t* tags, uint64_t tag_len, uint8_t* message, uint64_t* m_len);
+int8_t colm127_decrypt_final(colm127_decrypt_stream* st, const uint8_t* tags, uint64_t tag_len, uint8_t* message, uint64_t* m_len); // at most COLM_STREAM_WINDOW bytes
+
+/*
+ * Scatter / gather versions (colm_iovec.c) for data that is held in several buffers, e.g. the buffer chain of a network packet.
+ * Message, ciphertext and associated data are arrays of fragments of any length (also 0), their concatenation is the buffer of the
+ * one-shot functions and the output is the same. Only blocks across the border of a fragment are copied, the rest is processed in place.
+ * The output fragments need room for *c_len / *m_len bytes in total (-1 if not), the intermediate tags of COLM127 go to one array as before.
+ * colm_iovec has the members of struct iovec (sys/uio.h).
+ */
+typedef struct colm_iovec
+{
+	void* iov_base;
+	size_t iov_len;
+} colm_iovec;
+
+int8_t colm0_encryptv(const colm_key_ctx* ctx, const colm_iovec* message, size_t message_count, const colm_iovec* associated_data, size_t data_count, uint64_t npub,
+                      uint64_t* c_len, const colm_iovec* ciphertext, size_t c_count);
+int8_t colm0_decryptv(const colm_key_ctx* ctx, const colm_iovec* ciphertext, size_t c_count, const colm_iovec* associated_data, size_t data_count, uint64_t npub,
+                      uint64_t* m_len, const colm_iovec* message, size_t message_count);
+
+int8_t colm127_encryptv(const colm_key_ctx* ctx, const colm_iovec* message, size_t message_count, const colm_iovec* associated_data, size_t data_count, uint64_t npub,
+                        uint64_t* c_len, const colm_iovec* ciphertext, size_t c_count, uint64_t* tag_len, uint8_t* tags);
+int8_t colm127_decryptv(const colm_key_ctx* ctx, const colm_iovec* ciphertext, size_t c_count, const colm_iovec* associated_data, size_t data_count, uint64_t npub,
+                        uint64_t tag_len, uint8_t* tags, uint64_t* m_len, const colm_iovec* message, size_t message_count);
+
+/*
+ * Random access decryption of COLM127 (colm_seek.c): the segments first .. first + count - 1 (127 blocks each) of a ciphertext of len bytes.
+ * segments is the ciphertext of these segments (count * COLM_STREAM_WINDOW bytes, starting at byte first * COLM_STREAM_WINDOW), tags all intermediate tags.
+ * index is the segment index of the object (tag_len bytes, one block per intermediate tag), it holds the state each segment starts with,
+ * encrypted together with the MAC of nonce and associated data. colm127_segment_index creates it from the tags of a colm127_encrypt*
+ * output (or of a ciphertext that passed colm127_decrypt), store it next to the object. Only the first segment needs no index (NULL).
+ * Every segment is checked against its own intermediate tag, so a segment, tag or index block of another object (other nonce or associated
+ * data under the same key) or another position is rejected (-5). What a range read does not check: the end tag and everything behind the
+ * range (a truncated or modified rest of the object), and objects encrypted with the same nonce and associated data can't be told apart.
+ * The segment with the last block of the message can't be decrypted this way (-1), -5 => intermediate tag invalid (the segments before it are valid).
+ */
+int8_t colm127_segment_index(const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub, const uint8_t* tags, uint64_t tag_len, uint8_t* index);
+int8_t colm127_decrypt_segments(const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t len, const uint8_t* tags, uint64_t tag_len,
+                                const uint8_t* index, uint64_t first, uint64_t count, const uint8_t* segments, uint8_t* message);
+
+
+
+/*
+ * Multi-threaded versions for large messages (colm_thread.c, needs pthreads).
+ * The message is split into one segment per thread, the output is the same as of the functions above.
+ * Messages with less than COLM_THREAD_MIN_BLOCKS blocks per thread use fewer threads or only the calling one.
+ * A pool is used by one message at a time, concurrent calls with the same pool run single threaded.
+ */
+#define COLM_MAX_THREADS 64
+#ifndef COLM_THREAD_MIN_BLOCKS
+#define COLM_THREAD_MIN_BLOCKS 4096 // 64 KiB
+#endif
+
+typedef struct colm_thread_pool colm_thread_pool;
+
+colm_thread_pool* colm_thread_pool_create(uint8_t threads); // threads including the calling thread (1 - COLM_MAX_THREADS), NULL on error
+void colm_thread_pool_free(colm_thread_pool* pool);
+uint8_t colm_thread_pool_size(const colm_thread_pool* pool); // threads actually started
+
+int8_t colm0_encrypt_threaded(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* c);
+int8_t colm0_decrypt_threaded(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* m_len, uint8_t* message);
+
+int8_t colm127_encrypt_threaded(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags);
+int8_t colm127_decrypt_threaded(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message);
+// same, -5 => *failed_segment is the index of the first 127 block segment with an invalid intermediate tag (all segments are checked in parallel)
+int8_t colm127_decrypt_threaded_report(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message, uint64_t* failed_segment);
+
+
+
+/*
+ * Batch versions for many small, independent messages (colm_batch.c).
+ * Up to COLM_BATCH_LANES messages are processed at the same time, their blocks share the AES pipeline.
+ * Every message gets the same output and status code as from the single message functions, the return value is the number of messages with status != 0.
+ * The messages of one batch may use different keys (ctx of the message), ctx of the call is used for the messages without one and may be NULL if all have their own.
+ */
+#define COLM_BATCH_LANES 8
 
+typedef struct colm_batch_msg
+{
+	uint8_t* in;                // message (encryption) or ciphertext (decryption)
+	uint64_t in_len;
+	uint8_t* associated_data;
+	uint64_t data_len;
+	uint64_t npub;
+	uint8_t* out;               // ciphertext (in_len + 16 bytes) or message (in_len - 16 bytes)
+	uint64_t out_len;           // set by the call
+	uint8_t* tags;              // COLM127 only: intermediate tags
+	uint64_t tag_len;           // COLM127 only: set by the encryption, input of the decryption
+	int8_t status;              // set by the call
+	const colm_key_ctx* ctx;    // key of the message, NULL: ctx of the call
+} colm_batch_msg;
 
-int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8x16_t key, uint64_t* c_len, uint8_t* c);
-int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8x16_t key, uint64_t* m_len, uint8_t* message);
+size_t colm0_encrypt_batch(const colm_key_ctx* ctx, colm_batch_msg* msgs, size_t count);
+size_t colm0_decrypt_batch(const colm_key_ctx* ctx, colm_batch_msg* msgs, size_t count);
 
-int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8x16_t key, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags);
-int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8x16_t key, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message);
+size_t colm127_encrypt_batch(const colm_key_ctx* ctx, colm_batch_msg* msgs, size_t count);
+size_t colm127_decrypt_batch(const colm_key_ctx* ctx, colm_batch_msg* msgs, size_t count);
 
 #endif
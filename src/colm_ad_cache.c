@@ -0,0 +1,158 @@
+/*
+ * Associated data cache.
+ *
+ * The MAC of the associated data is v = E(nonce ^ 3L) ^ E(AD_1 ^ delta_1) ^ E(AD_2 ^ delta_2) ^ ...
+ * Only the first block depends on the nonce, the sum over the associated data blocks and their deltas only on the key and the data.
+ * A cache holds this sum for a fixed associated data (e.g. a protocol header that is sent with every record), so a message with it
+ * only needs the AES call of the nonce block.
+ *
+ * The cached data can also be the fixed prefix of the associated data. The full blocks of the prefix are summed up, the bytes of an
+ * incomplete last block are kept and continued with the suffix of the message (so the suffix needs no alignment).
+ */
+
+#include "colm.h"
+#include "colm_backend.h"
+#include "colm_ad_queue.h"
+
+struct colm_ad_cache
+{
+	const colm_key_ctx* ctx; // the sum is only valid for the key of this context
+	block_t sum;             // xor of the encryptions of the full blocks
+	block_t complete;        // sum including the padded tail: the whole contribution if there is no suffix
+	block_t delta;           // delta of the last full block
+	uint8_t tail[BLOCKSIZE]; // bytes after the last full block
+	uint8_t tail_len;
+};
+
+// everything below uses the AES instructions (see aes_crypto.h)
+AES_TARGET_BEGIN
+
+/*
+ * Prepares the cache for the associated data (or a prefix of it) under the key of ctx.
+ * ctx has to stay valid as long as the cache is used. NULL => no memory or no AES instructions
+ */
+colm_ad_cache* colm_ad_cache_create(const colm_key_ctx* ctx, const uint8_t* associated_data, uint64_t data_len)
+{
+	colm_ad_cache* cache;
+	const block_t* aes_round_keys = ctx->aes_encryption_keys;
+	uint64_t blocks = data_len / BLOCKSIZE;
+	uint8_t buf[BLOCKSIZE] = { 0 };
+	ad_queue q = { .sum = ZERO_BLOCK() };
+
+	if (colm_backend_active() == NULL)
+	{
+		return NULL;
+	}
+
+	cache = calloc(1, sizeof(colm_ad_cache));
+	if (cache == NULL)
+	{
+		return NULL;
+	}
+
+	cache->ctx = ctx;
+	cache->delta = ctx->delta_ad;
+	queue_blocks(&q, associated_data, blocks, &cache->delta, aes_round_keys);
+	queue_flush(&q, aes_round_keys);
+	cache->sum = q.sum;
+
+	cache->tail_len = (uint8_t)(data_len - blocks * BLOCKSIZE);
+	memcpy(cache->tail, associated_data + blocks * BLOCKSIZE, cache->tail_len);
+
+	if (cache->tail_len > 0)
+	{
+		memcpy(buf, cache->tail, cache->tail_len);
+		buf[cache->tail_len] ^= 0x80; /* padding */
+		queue_push(&q, XOR_BLOCK(LOAD_BLOCK(buf), gf_mul7(cache->delta)), aes_round_keys);
+		queue_flush(&q, aes_round_keys);
+	}
+	cache->complete = q.sum;
+
+	return cache;
+}
+
+void colm_ad_cache_free(colm_ad_cache* cache)
+{
+	volatile uint8_t* p = (volatile uint8_t*)cache;
+	size_t i;
+
+	if (cache == NULL)
+	{
+		return;
+	}
+
+	// the sum depends on the key
+	for (i = 0; i < sizeof(colm_ad_cache); i++)
+	{
+		p[i] = 0;
+	}
+	free(cache);
+}
+
+/*
+ * w = MAC of the nonce and the associated data cached data || suffix, the same value mac() returns for the whole associated data.
+ * For a short suffix the nonce block, the block completing the cached tail and the padded last block share one AES call.
+ */
+int8_t colm_ad_cache_mac(const colm_key_ctx* ctx, const colm_ad_cache* cache, block_t npub_param, const uint8_t* suffix, uint64_t suffix_len, block_t* w)
+{
+	const block_t* aes_round_keys = ctx->aes_encryption_keys;
+	block_t nonce = XOR_BLOCK(SWAP_BLOCK(npub_param), ctx->delta_ad);
+	block_t delta = cache->delta;
+	ad_queue q = { .sum = cache->sum };
+	uint8_t buf[BLOCKSIZE];
+	uint8_t tail_len = cache->tail_len;
+	uint8_t missing = BLOCKSIZE - tail_len;
+
+	if (cache->ctx != ctx)
+	{
+		// -7 => the cache belongs to another key context
+		return -7;
+	}
+
+	if (suffix_len == 0)
+	{
+		// the same associated data as cached: only the nonce block is left
+		AES_ENCRYPT(nonce, aes_round_keys);
+		*w = XOR_BLOCK(cache->complete, nonce);
+		return 0;
+	}
+
+	queue_push(&q, nonce, aes_round_keys);
+	memcpy(buf, cache->tail, BLOCKSIZE);
+
+	// complete the cached tail with the first bytes of the suffix
+	if (tail_len > 0 && suffix_len >= missing)
+	{
+		memcpy(buf + tail_len, suffix, missing);
+		delta = gf_mul2(delta);
+		queue_push(&q, XOR_BLOCK(LOAD_BLOCK(buf), delta), aes_round_keys);
+		suffix += missing;
+		suffix_len -= missing;
+		tail_len = 0;
+		memset(buf, 0, BLOCKSIZE);
+	}
+
+	// then the suffix is block aligned
+	if (tail_len == 0)
+	{
+		queue_blocks(&q, suffix, suffix_len / BLOCKSIZE, &delta, aes_round_keys);
+		suffix += suffix_len - suffix_len % BLOCKSIZE;
+		suffix_len %= BLOCKSIZE;
+	}
+
+	// last block partial (cached tail and / or rest of the suffix, less than a block together)
+	if (tail_len + suffix_len > 0)
+	{
+		memcpy(buf + tail_len, suffix, suffix_len);
+		buf[tail_len + suffix_len] ^= 0x80; /* padding */
+		delta = gf_mul7(delta);
+		queue_push(&q, XOR_BLOCK(LOAD_BLOCK(buf), delta), aes_round_keys);
+	}
+
+	queue_flush(&q, aes_round_keys);
+
+	*w = q.sum;
+	return 0;
+}
+
+AES_TARGET_END
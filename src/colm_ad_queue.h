@@ -0,0 +1,66 @@
+/*
+ * Queue of the associated data blocks of the MAC, for the functions that collect the blocks themselves
+ * (the cache of colm_ad_cache.c, the fragments of colm_iovec.c) instead of reading one buffer like mac() of the backends.
+ */
+
+#ifndef COLM_AD_QUEUE
+#define COLM_AD_QUEUE
+
+#include "colm_backend.h"
+
+// the queue calls the AES instructions directly (see aes_crypto.h)
+AES_TARGET_BEGIN
+
+// the MAC is the xor of independent encryptions: the blocks are collected and encrypted QUEUE_WIDTH at a time
+// (the AES call always has the full width, a compile time constant keeps the blocks in registers, unused lanes are ignored)
+#define QUEUE_WIDTH 4
+
+typedef struct ad_queue
+{
+	block_t blocks[QUEUE_WIDTH];
+	block_t sum;
+	uint8_t filled;
+} ad_queue;
+
+PIPELINED void queue_flush(ad_queue* q, const block_t* aes_round_keys)
+{
+	uint8_t j;
+
+	if (q->filled == 0)
+	{
+		return;
+	}
+
+	AES_ENCRYPTN(q->blocks, QUEUE_WIDTH, aes_round_keys);
+
+	for (j = 0; j < q->filled; j++)
+	{
+		q->sum = XOR_BLOCK(q->sum, q->blocks[j]);
+	}
+	q->filled = 0;
+}
+
+PIPELINED void queue_push(ad_queue* q, block_t block, const block_t* aes_round_keys)
+{
+	q->blocks[q->filled++] = block;
+
+	if (q->filled == QUEUE_WIDTH)
+	{
+		queue_flush(q, aes_round_keys);
+	}
+}
+
+// queues E(block ^ delta) of the full blocks, delta is advanced block by block as in mac() of colm_parallel.c
+PIPELINED void queue_blocks(ad_queue* q, const uint8_t* in, uint64_t blocks, block_t* delta, const block_t* aes_round_keys)
+{
+	for (; blocks > 0; blocks--)
+	{
+		*delta = gf_mul2(*delta);
+		queue_push(q, XOR_BLOCK(LOAD_BLOCK(in), *delta), aes_round_keys);
+		in += BLOCKSIZE;
+	}
+}
+
+AES_TARGET_END
+
+#endif
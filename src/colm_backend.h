@@ -0,0 +1,105 @@
+#ifndef COLM_BACKEND
+#define COLM_BACKEND
+
+#include "colm.h"
+#include "colm_stats.h"
+
+/*
+ * Function table of one COLM implementation.
+ * colm_dispatch.c selects the fastest table the CPU supports when the library is loaded, the public *_ctx functions just forward to it.
+ * All functions have to work in place (out == in, see colm.h): a block of the input is read before the output at its position is written
+ * and never read again afterwards (loading a whole group before storing it is fine).
+ */
+typedef struct colm_backend
+{
+	const char* name;
+	int8_t (*key_ctx_init)(colm_key_ctx* ctx, block_t key);
+	// w = MAC of nonce and associated data, the encryptions and decryptions start from it (so it can also come from an AD cache)
+	block_t (*mac)(const colm_key_ctx* ctx, block_t npub_param, uint8_t* associated_data, uint64_t data_len);
+	int8_t (*colm0_encrypt)(const colm_key_ctx* ctx, block_t w, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext);
+	// message == NULL => nothing is stored, only the status is returned (colm0_verify / colm127_verify), same for colm_tau_decrypt
+	int8_t (*colm0_decrypt)(const colm_key_ctx* ctx, block_t w, uint8_t* ciphertext, uint64_t len, uint64_t* m_len, uint8_t* message);
+	// optional: MAC and colm0_encrypt in one pass (colm0_encrypt(ctx, mac(...), ...) if NULL)
+	int8_t (*colm0_encrypt_mac)(const colm_key_ctx* ctx, block_t npub_param, uint8_t* associated_data, uint64_t data_len, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext);
+	int8_t (*colm_tau_encrypt)(const colm_key_ctx* ctx, block_t w, uint16_t tau, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags);
+	int8_t (*colm_tau_decrypt)(const colm_key_ctx* ctx, block_t w, uint16_t tau, uint8_t* ciphertext, uint64_t len, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message);
+	// full blocks before the last block of a message, without intermediate tags (streaming API, colm_stream.c)
+	void (*encrypt_blocks)(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, uint64_t full_blocks);
+	// out == NULL => only the state is advanced, no plaintext is stored
+	void (*decrypt_blocks)(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, uint64_t full_blocks);
+} colm_backend;
+
+// parameter of the nonce block (NONCE_BLOCK) of the two instantiations
+#define COLM0_PARAM 0x0000800000000000
+#define COLM127_PARAM 0x007F800000000000
+// any other interval: tau is in the top 16 bits (COLM_TAU_PARAM(127) == COLM127_PARAM)
+#define COLM_TAU_PARAM(tau) (((uint64_t)(tau) << 48) | COLM0_PARAM)
+
+// (Y, W') = rho(X, W) and (X, W') = rho^-1(Y, W) of the COLM spec, st holds W
+#define RHO_INPLACE(x, st, w_new) do { \
+									w_new = XOR_BLOCK(gf_mul2(st), x); \
+									x = XOR_BLOCK(w_new, st); \
+									st = w_new; \
+								} while(0)
+
+#define RHO_INVERSE_INPLACE(y, st, w_new) do { \
+											w_new = gf_mul2(st); \
+											st = XOR_BLOCK(st, y); \
+											y = XOR_BLOCK(w_new, st); \
+										} while(0)
+
+// the pipelined functions are instantiated once for every supported pipeline width (see CALL_WITH_PIPELINE_WIDTH)
+// so the width is a compile time constant inside of them and the lane loops can be unrolled
+#define PIPELINED static inline __attribute__((always_inline))
+
+#define CALL_WITH_PIPELINE_WIDTH(width, function, ...) do { \
+															switch (width) \
+															{ \
+																case 4: return function(__VA_ARGS__, 4); \
+																case 6: return function(__VA_ARGS__, 6); \
+																case 8: return function(__VA_ARGS__, 8); \
+																default: return function(__VA_ARGS__, 3); \
+															} \
+														} while (0)
+
+// galois multiplications of colm_parallel.c, shared with the other backends
+block_t gf_mul3(block_t x);
+block_t gf_mul7(block_t x);
+block_t gf_mul(block_t a, block_t b);
+block_t gf_pow2(uint64_t n);
+block_t gf_mul_pow2(block_t x, uint64_t n); // x * 2^n, e.g. the delta of block n
+
+// messages of up to COLM_SHORT_LEN bytes with one AES batch per layer instead of a chain of blocks (colm_parallel.c), shared with the other backends
+#define COLM_SHORT_BLOCKS 4
+#define COLM_SHORT_LEN (COLM_SHORT_BLOCKS * BLOCKSIZE)
+#define COLM_SHORT_AD_BLOCKS 2 // associated data that colm0_encrypt_mac_short takes into the first batch
+#define COLM_SHORT_AD_LEN (COLM_SHORT_AD_BLOCKS * BLOCKSIZE)
+int8_t colm0_encrypt_short(const colm_key_ctx* ctx, block_t w, const uint8_t* message, uint64_t message_len, uint8_t* ciphertext);
+int8_t colm0_encrypt_mac_short(const colm_key_ctx* ctx, block_t npub_param, const uint8_t* associated_data, uint64_t data_len, const uint8_t* message, uint64_t message_len, uint8_t* ciphertext);
+int8_t colm0_decrypt_short(const colm_key_ctx* ctx, block_t w, const uint8_t* ciphertext, uint64_t len, uint8_t* message); // len >= BLOCKSIZE, message == NULL => nothing is stored
+
+// MAC of nonce, cached associated data and suffix (colm_ad_cache.c), -7 => cache of another key context
+int8_t colm_ad_cache_mac(const colm_key_ctx* ctx, const colm_ad_cache* cache, block_t npub_param, const uint8_t* suffix, uint64_t suffix_len, block_t* w);
+
+// single blocks of a message with a colm_state (colm_stream.c): the block before an intermediate tag and the last block with the tag
+void colm_encrypt_tag_block(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, uint8_t* tag);
+int8_t colm_decrypt_tag_block(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, const uint8_t* tag); // -5 => intermediate tag invalid
+void colm_encrypt_last(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t remaining, uint8_t* out, uint8_t* tag, uint8_t* end);
+int8_t colm_decrypt_last(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, const uint8_t* tag, const uint8_t* end, uint8_t remaining, uint8_t* out);
+
+// random access to the 127 block segments of COLM127 (colm_seek.c), also used by the threaded decryption
+void colm127_segment_start(const colm_key_ctx* ctx, block_t w, const uint8_t* tags, uint64_t first, colm_state* st);
+int8_t colm127_segments_decrypt(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, const uint8_t* tags, uint64_t first, uint64_t count, uint64_t* failed);
+
+// backend selected by colm_dispatch.c, NULL if the CPU has no AES instructions
+const colm_backend* colm_backend_active(void);
+
+// pipelined AES implementation (colm_parallel.c), needs the AES instructions of the CPU
+extern const colm_backend colm_backend_pipelined;
+
+#if defined(AES_CRYPTO_X86)
+// COLM0 16 blocks at a time (colm_vaes.c), needs VAES and AVX-512
+extern const colm_backend colm_backend_vaes;
+#endif
+
+#endif
@@ -0,0 +1,796 @@
+/*
+ * Batch API: many independent (short) messages in one call.
+ *
+ * A single short message can't keep the AES unit busy, every block waits for the previous one (rho chain).
+ * Here up to COLM_BATCH_LANES messages are processed side by side, one per lane, and the blocks of all lanes share the AES calls:
+ *  - the MAC blocks (nonce and associated data) of all new messages are independent and just fill the AES calls,
+ *  - the message blocks of all lanes go through the layers together, the lanes process as many blocks as the shortest of them has left,
+ *  - the intermediate tags and the last blocks of the lanes that reached them are processed together as well.
+ * A lane whose message is done takes the next message of the batch right away.
+ * Every lane brings its own key context, so the messages of a batch can use different keys (AES_ENCRYPTN_KEYS / AES_DECRYPTN_KEYS).
+ * Every message gets the same output and status code as from the single message functions.
+ */
+
+#include "colm.h"
+#include "colm_backend.h"
+
+// everything below uses the AES instructions (see aes_crypto.h)
+AES_TARGET_BEGIN
+
+typedef struct batch_lane
+{
+	colm_batch_msg* msg;    // NULL if the lane is free
+	const colm_key_ctx* ctx; // key of the message (round keys and deltas)
+	const uint8_t* in;
+	uint8_t* out;
+	uint8_t* tags;          // next intermediate tag
+	uint64_t remaining;     // bytes of the message left
+	uint64_t until_tag;     // blocks until the next intermediate tag (COLM127)
+	block_t w, checksum, delta_m, delta_c;
+} batch_lane;
+
+// like CALL_WITH_PIPELINE_WIDTH: the lane functions are instantiated for every number of lanes
+#define CALL_WITH_LANES(n, function, ...) do { \
+												switch (n) \
+												{ \
+													case 1: function(__VA_ARGS__, 1); break; \
+													case 2: function(__VA_ARGS__, 2); break; \
+													case 3: function(__VA_ARGS__, 3); break; \
+													case 4: function(__VA_ARGS__, 4); break; \
+													case 5: function(__VA_ARGS__, 5); break; \
+													case 6: function(__VA_ARGS__, 6); break; \
+													case 7: function(__VA_ARGS__, 7); break; \
+													default: function(__VA_ARGS__, 8); break; \
+												} \
+											} while (0)
+
+#if COLM_BATCH_LANES != 8
+#error "CALL_WITH_LANES expects COLM_BATCH_LANES to be 8"
+#endif
+
+// keys[lane] are the round keys of every block, if all messages of the batch use the same key (shared) the round keys stay in registers
+#define LANES_ENCRYPT(blocks, n, keys, shared) do { \
+													if (shared) AES_ENCRYPTN(blocks, n, (keys)[0]); \
+													else AES_ENCRYPTN_KEYS(blocks, n, keys); \
+												} while (0)
+
+#define LANES_DECRYPT(blocks, n, keys, shared) do { \
+													if (shared) AES_DECRYPTN(blocks, n, (keys)[0]); \
+													else AES_DECRYPTN_KEYS(blocks, n, keys); \
+												} while (0)
+
+
+static inline void lane_done(batch_lane* l, int8_t status)
+{
+	l->msg->status = status;
+	l->msg = NULL;
+}
+
+// number of blocks before the last block of the message
+static inline uint64_t lane_blocks(const batch_lane* l)
+{
+	return l->remaining > BLOCKSIZE ? (l->remaining - 1) / BLOCKSIZE : 0;
+}
+
+// returns 0 if the message can't be processed (status already set)
+static uint8_t lane_start(batch_lane* l, colm_batch_msg* msg, const colm_key_ctx* ctx, uint8_t tag_interval, uint8_t decrypt)
+{
+	if (decrypt)
+	{
+		if (msg->in_len < BLOCKSIZE)
+		{
+			// -1 => invalid size of ciphertext
+			msg->status = -1;
+			return 0;
+		}
+		l->remaining = msg->out_len = msg->in_len - BLOCKSIZE;
+
+		if (tag_interval && msg->tag_len / BLOCKSIZE < (lane_blocks(l) + 1) / tag_interval)
+		{
+			// -1 => not all intermediate tags there
+			msg->status = -1;
+			return 0;
+		}
+	}
+	else
+	{
+		l->remaining = msg->in_len;
+		msg->out_len = msg->in_len + BLOCKSIZE;
+		msg->tag_len = 0;
+	}
+
+	l->msg = msg;
+	l->ctx = msg->ctx != NULL ? msg->ctx : ctx;
+	l->in = msg->in;
+	l->out = msg->out;
+	l->tags = msg->tags;
+	l->until_tag = tag_interval ? tag_interval : UINT64_MAX;
+	l->w = ZERO_BLOCK();
+	l->checksum = ZERO_BLOCK();
+	l->delta_m = l->ctx->L;
+	l->delta_c = l->ctx->delta_c;
+
+	return 1;
+}
+
+
+
+/* ----------------------- MAC ------------------------- */
+
+typedef struct mac_queue
+{
+	block_t blocks[COLM_BATCH_LANES];
+	batch_lane* lanes[COLM_BATCH_LANES];
+	const block_t* keys[COLM_BATCH_LANES];
+	uint8_t filled;
+	uint8_t shared;
+} mac_queue;
+
+// the MAC is the xor of independent encryptions, so the blocks of all lanes are encrypted in any order
+static inline void mac_push(mac_queue* q, batch_lane* l, block_t block)
+{
+	uint8_t j;
+
+	q->blocks[q->filled] = block;
+	q->keys[q->filled] = l->ctx->aes_encryption_keys;
+	q->lanes[q->filled++] = l;
+
+	if (q->filled == COLM_BATCH_LANES)
+	{
+		LANES_ENCRYPT(q->blocks, COLM_BATCH_LANES, q->keys, q->shared);
+
+		UNROLL_LANES
+		for (j = 0; j < COLM_BATCH_LANES; j++)
+		{
+			q->lanes[j]->w = XOR_BLOCK(q->lanes[j]->w, q->blocks[j]);
+		}
+		q->filled = 0;
+	}
+}
+
+// same as mac_with_delta in colm_parallel.c for n lanes at once, the result is stored in w
+static void mac_lanes(batch_lane** lanes, uint8_t n, uint8_t tag_interval, uint8_t shared)
+{
+	uint64_t param = tag_interval ? COLM127_PARAM : COLM0_PARAM;
+	uint8_t buf[BLOCKSIZE];
+	mac_queue q;
+	block_t delta;
+	const uint8_t* ad;
+	uint64_t len;
+	uint8_t i, j;
+
+	q.filled = 0;
+	q.shared = shared;
+
+	for (j = 0; j < n; j++)
+	{
+		batch_lane* l = lanes[j];
+
+		ad = l->msg->associated_data;
+		len = l->msg->data_len;
+		delta = l->ctx->delta_ad;
+
+		mac_push(&q, l, XOR_BLOCK(SWAP_BLOCK(NONCE_BLOCK(l->msg->npub, param)), delta));
+
+		while (len >= BLOCKSIZE)
+		{
+			delta = gf_mul2(delta);
+			mac_push(&q, l, XOR_BLOCK(LOAD_BLOCK(ad), delta));
+			ad += BLOCKSIZE;
+			len -= BLOCKSIZE;
+		}
+
+		if (len > 0)
+		{
+			delta = gf_mul7(delta);
+			memset(buf, 0, BLOCKSIZE);
+			memcpy(buf, ad, len);
+			buf[len] ^= 0x80; /* padding */
+			mac_push(&q, l, XOR_BLOCK(LOAD_BLOCK(buf), delta));
+		}
+	}
+
+	if (q.filled > 0)
+	{
+		LANES_ENCRYPT(q.blocks, q.filled, q.keys, q.shared);
+
+		for (i = 0; i < q.filled; i++)
+		{
+			q.lanes[i]->w = XOR_BLOCK(q.lanes[i]->w, q.blocks[i]);
+		}
+	}
+}
+
+
+
+/* ----------------------- MESSAGE BLOCKS ------------------------- */
+
+/*
+ * The next k blocks of n lanes, the intermediate tag of a lane can only be due after the last of them.
+ * The second layer of a block and the first layer of the next block are independent and go through the same AES call (2 * n blocks).
+ */
+PIPELINED void encrypt_lanes(batch_lane** lanes, uint64_t k, const uint8_t shared, const uint8_t n)
+{
+	const block_t* keys[2 * COLM_BATCH_LANES];
+	block_t blocks[2 * COLM_BATCH_LANES], w[COLM_BATCH_LANES], checksum[COLM_BATCH_LANES], delta_m[COLM_BATCH_LANES], delta_c[COLM_BATCH_LANES];
+	block_t block, w_tmp;
+	const uint8_t* in[COLM_BATCH_LANES];
+	uint8_t* out[COLM_BATCH_LANES];
+	uint64_t i, until_tag[COLM_BATCH_LANES];
+	uint8_t j;
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		w[j] = lanes[j]->w;
+		checksum[j] = lanes[j]->checksum;
+		delta_m[j] = lanes[j]->delta_m;
+		delta_c[j] = lanes[j]->delta_c;
+		until_tag[j] = lanes[j]->until_tag;
+		in[j] = lanes[j]->in;
+		out[j] = lanes[j]->out;
+		keys[j] = keys[n + j] = lanes[j]->ctx->aes_encryption_keys;
+
+		// first layer of the first block
+		delta_m[j] = gf_mul2(delta_m[j]);
+		block = LOAD_BLOCK(in[j]);
+		checksum[j] = XOR_BLOCK(checksum[j], block);
+		blocks[n + j] = XOR_BLOCK(block, delta_m[j]);
+	}
+
+	LANES_ENCRYPT((blocks + n), n, (keys + n), shared);
+
+	for (i = 0; i < k; i++)
+	{
+		UNROLL_LANES
+		for (j = 0; j < n; j++)
+		{
+			blocks[j] = blocks[n + j];
+			RHO_INPLACE(blocks[j], w[j], w_tmp);
+		}
+
+		if (i + 1 < k)
+		{
+			UNROLL_LANES
+			for (j = 0; j < n; j++)
+			{
+				delta_m[j] = gf_mul2(delta_m[j]);
+				block = LOAD_BLOCK(in[j] + (i + 1) * BLOCKSIZE);
+				checksum[j] = XOR_BLOCK(checksum[j], block);
+				blocks[n + j] = XOR_BLOCK(block, delta_m[j]);
+			}
+
+			LANES_ENCRYPT(blocks, 2 * n, keys, shared);
+		}
+		else
+		{
+			LANES_ENCRYPT(blocks, n, keys, shared);
+		}
+
+		UNROLL_LANES
+		for (j = 0; j < n; j++)
+		{
+			delta_c[j] = gf_mul2(delta_c[j]);
+
+			// the tag after the block shares its (once more doubled) delta_c with it
+			if (i + 1 == until_tag[j]) delta_c[j] = gf_mul2(delta_c[j]);
+
+			STORE_BLOCK(out[j] + i * BLOCKSIZE, XOR_BLOCK(blocks[j], delta_c[j]));
+		}
+	}
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		lanes[j]->w = w[j];
+		lanes[j]->checksum = checksum[j];
+		lanes[j]->delta_m = delta_m[j];
+		lanes[j]->delta_c = delta_c[j];
+		lanes[j]->until_tag -= k;
+		lanes[j]->in += k * BLOCKSIZE;
+		lanes[j]->out += k * BLOCKSIZE;
+		lanes[j]->remaining -= k * BLOCKSIZE;
+	}
+}
+
+PIPELINED void decrypt_lanes(batch_lane** lanes, uint64_t k, const uint8_t shared, const uint8_t n)
+{
+	const block_t* keys[2 * COLM_BATCH_LANES];
+	block_t blocks[2 * COLM_BATCH_LANES], w[COLM_BATCH_LANES], checksum[COLM_BATCH_LANES], delta_m[COLM_BATCH_LANES], delta_c[COLM_BATCH_LANES];
+	block_t block, w_tmp;
+	const uint8_t* in[COLM_BATCH_LANES];
+	uint8_t* out[COLM_BATCH_LANES];
+	uint64_t i, until_tag[COLM_BATCH_LANES];
+	uint8_t j;
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		w[j] = lanes[j]->w;
+		checksum[j] = lanes[j]->checksum;
+		delta_m[j] = lanes[j]->delta_m;
+		delta_c[j] = lanes[j]->delta_c;
+		until_tag[j] = lanes[j]->until_tag;
+		in[j] = lanes[j]->in;
+		out[j] = lanes[j]->out;
+		keys[j] = keys[n + j] = lanes[j]->ctx->aes_decryption_keys;
+
+		// first layer of the first block, the block before an intermediate tag shares the tags delta_c
+		delta_c[j] = gf_mul2(delta_c[j]);
+		if (until_tag[j] == 1) delta_c[j] = gf_mul2(delta_c[j]);
+		blocks[n + j] = XOR_BLOCK(LOAD_BLOCK(in[j]), delta_c[j]);
+	}
+
+	LANES_DECRYPT((blocks + n), n, (keys + n), shared);
+
+	for (i = 0; i < k; i++)
+	{
+		UNROLL_LANES
+		for (j = 0; j < n; j++)
+		{
+			blocks[j] = blocks[n + j];
+			RHO_INVERSE_INPLACE(blocks[j], w[j], w_tmp);
+		}
+
+		if (i + 1 < k)
+		{
+			UNROLL_LANES
+			for (j = 0; j < n; j++)
+			{
+				delta_c[j] = gf_mul2(delta_c[j]);
+				if (i + 2 == until_tag[j]) delta_c[j] = gf_mul2(delta_c[j]);
+				blocks[n + j] = XOR_BLOCK(LOAD_BLOCK(in[j] + (i + 1) * BLOCKSIZE), delta_c[j]);
+			}
+
+			LANES_DECRYPT(blocks, 2 * n, keys, shared);
+		}
+		else
+		{
+			LANES_DECRYPT(blocks, n, keys, shared);
+		}
+
+		UNROLL_LANES
+		for (j = 0; j < n; j++)
+		{
+			delta_m[j] = gf_mul2(delta_m[j]);
+			block = XOR_BLOCK(blocks[j], delta_m[j]);
+			checksum[j] = XOR_BLOCK(checksum[j], block);
+			STORE_BLOCK(out[j] + i * BLOCKSIZE, block);
+		}
+	}
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		lanes[j]->w = w[j];
+		lanes[j]->checksum = checksum[j];
+		lanes[j]->delta_m = delta_m[j];
+		lanes[j]->delta_c = delta_c[j];
+		lanes[j]->until_tag -= k;
+		lanes[j]->in += k * BLOCKSIZE;
+		lanes[j]->out += k * BLOCKSIZE;
+		lanes[j]->remaining -= k * BLOCKSIZE;
+	}
+}
+
+static void encrypt_lanes_n(batch_lane** lanes, uint64_t k, uint8_t shared, uint8_t n)
+{
+	if (shared)
+	{
+		CALL_WITH_LANES(n, encrypt_lanes, lanes, k, 1);
+	}
+	else
+	{
+		CALL_WITH_LANES(n, encrypt_lanes, lanes, k, 0);
+	}
+}
+
+static void decrypt_lanes_n(batch_lane** lanes, uint64_t k, uint8_t shared, uint8_t n)
+{
+	if (shared)
+	{
+		CALL_WITH_LANES(n, decrypt_lanes, lanes, k, 1);
+	}
+	else
+	{
+		CALL_WITH_LANES(n, decrypt_lanes, lanes, k, 0);
+	}
+}
+
+
+
+/* ----------------------- INTERMEDIATE TAGS ------------------------- */
+
+// tags of the lanes whose until_tag has reached 0, decryption: lanes with a wrong tag are done (-5), returns their number
+static size_t intermediate_tags(batch_lane** lanes, uint8_t n, uint8_t tag_interval, uint8_t decrypt, uint8_t shared)
+{
+	block_t blocks[COLM_BATCH_LANES];
+	batch_lane* tagged[COLM_BATCH_LANES];
+	const block_t* keys[COLM_BATCH_LANES];
+	size_t failed = 0;
+	uint8_t count = 0, j;
+
+	for (j = 0; j < n; j++)
+	{
+		if (lanes[j]->msg != NULL && lanes[j]->until_tag == 0)
+		{
+			tagged[count] = lanes[j];
+			keys[count] = decrypt ? lanes[j]->ctx->aes_decryption_keys : lanes[j]->ctx->aes_encryption_keys;
+			blocks[count++] = decrypt ? XOR_BLOCK(LOAD_BLOCK(lanes[j]->tags), lanes[j]->delta_c) : lanes[j]->w;
+			lanes[j]->until_tag = tag_interval;
+		}
+	}
+
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	if (decrypt)
+	{
+		LANES_DECRYPT(blocks, count, keys, shared);
+	}
+	else
+	{
+		LANES_ENCRYPT(blocks, count, keys, shared);
+	}
+
+	for (j = 0; j < count; j++)
+	{
+		batch_lane* l = tagged[j];
+
+		if (!decrypt)
+		{
+			STORE_BLOCK(l->tags, XOR_BLOCK(blocks[j], l->delta_c));
+			l->msg->tag_len += BLOCKSIZE;
+		}
+		else if (!EQUALS(blocks[j], l->w))
+		{
+			lane_done(l, -5);
+			failed++;
+			continue;
+		}
+		l->tags += BLOCKSIZE;
+	}
+
+	return failed;
+}
+
+
+
+/* ----------------------- LAST BLOCKS ------------------------- */
+
+// last block and tag of n lanes (same as the end of colm127_encrypt in colm_parallel.c)
+static void encrypt_final(batch_lane** lanes, uint8_t n, uint8_t tag_interval, uint8_t shared)
+{
+	const block_t* keys[COLM_BATCH_LANES];
+	block_t blocks[COLM_BATCH_LANES], w_tmp;
+	uint8_t buf[BLOCKSIZE];
+	uint8_t j;
+
+	for (j = 0; j < n; j++)
+	{
+		batch_lane* l = lanes[j];
+
+		keys[j] = l->ctx->aes_encryption_keys;
+		memset(buf, 0, BLOCKSIZE);
+		memcpy(buf, l->in, l->remaining);
+		l->delta_m = gf_mul7(l->delta_m);
+		l->delta_c = gf_mul7(l->delta_c);
+
+		// pad if nessesary
+		if (l->remaining < BLOCKSIZE) {
+			buf[l->remaining] = 0x80;
+			l->delta_m = gf_mul7(l->delta_m);
+			l->delta_c = gf_mul7(l->delta_c);
+		}
+
+		l->checksum = XOR_BLOCK(l->checksum, LOAD_BLOCK(buf));
+		blocks[j] = XOR_BLOCK(l->checksum, l->delta_m);
+	}
+
+	LANES_ENCRYPT(blocks, n, keys, shared);
+
+	for (j = 0; j < n; j++)
+	{
+		RHO_INPLACE(blocks[j], lanes[j]->w, w_tmp);
+	}
+
+	LANES_ENCRYPT(blocks, n, keys, shared);
+
+	for (j = 0; j < n; j++)
+	{
+		batch_lane* l = lanes[j];
+
+		STORE_BLOCK(l->out, XOR_BLOCK(blocks[j], l->delta_c));
+		l->out += BLOCKSIZE;
+
+		if (--l->until_tag == 0) l->delta_c = gf_mul2(l->delta_c);
+	}
+
+	intermediate_tags(lanes, n, tag_interval, 0, shared);
+
+	// the tag (shortened to the length of the last block, nothing for an empty message)
+	for (j = 0; j < n; j++)
+	{
+		batch_lane* l = lanes[j];
+
+		l->delta_m = gf_mul2(l->delta_m);
+		l->delta_c = gf_mul2(l->delta_c);
+		blocks[j] = XOR_BLOCK(l->delta_m, l->checksum);
+	}
+
+	LANES_ENCRYPT(blocks, n, keys, shared);
+
+	for (j = 0; j < n; j++)
+	{
+		RHO_INPLACE(blocks[j], lanes[j]->w, w_tmp);
+	}
+
+	LANES_ENCRYPT(blocks, n, keys, shared);
+
+	for (j = 0; j < n; j++)
+	{
+		batch_lane* l = lanes[j];
+
+		STORE_BLOCK(buf, XOR_BLOCK(blocks[j], l->delta_c));
+		memcpy(l->out, buf, l->remaining);
+		lane_done(l, 0);
+	}
+}
+
+// last block and tag verification of n lanes (same as the end of colm127_decrypt in colm_parallel.c), returns the number of failed lanes
+static size_t decrypt_final(batch_lane** lanes, uint8_t n, uint8_t tag_interval, uint8_t shared)
+{
+	const block_t* encryption_keys[COLM_BATCH_LANES];
+	const block_t* decryption_keys[COLM_BATCH_LANES];
+	block_t blocks[COLM_BATCH_LANES], last[COLM_BATCH_LANES], w_tmp;
+	uint8_t buf[BLOCKSIZE];
+	size_t failed;
+	uint32_t i;
+	uint8_t j;
+
+	for (j = 0; j < n; j++)
+	{
+		batch_lane* l = lanes[j];
+
+		encryption_keys[j] = l->ctx->aes_encryption_keys;
+		decryption_keys[j] = l->ctx->aes_decryption_keys;
+		l->delta_m = gf_mul7(l->delta_m);
+		l->delta_c = gf_mul7(l->delta_c);
+
+		if (l->remaining < BLOCKSIZE) {
+			l->delta_m = gf_mul7(l->delta_m);
+			l->delta_c = gf_mul7(l->delta_c);
+		}
+
+		blocks[j] = XOR_BLOCK(LOAD_BLOCK(l->in), l->delta_c);
+	}
+
+	LANES_DECRYPT(blocks, n, decryption_keys, shared);
+
+	for (j = 0; j < n; j++)
+	{
+		RHO_INVERSE_INPLACE(blocks[j], lanes[j]->w, w_tmp);
+	}
+
+	LANES_DECRYPT(blocks, n, decryption_keys, shared);
+
+	for (j = 0; j < n; j++)
+	{
+		batch_lane* l = lanes[j];
+
+		last[j] = XOR_BLOCK(blocks[j], l->delta_m);
+		l->checksum = XOR_BLOCK(l->checksum, last[j]);
+		STORE_BLOCK(buf, l->checksum);
+		memcpy(l->out, buf, l->remaining);
+		l->in += BLOCKSIZE;
+
+		if (--l->until_tag == 0) l->delta_c = gf_mul2(l->delta_c);
+	}
+
+	failed = intermediate_tags(lanes, n, tag_interval, 1, shared);
+
+	// recompute the tag from the last message block
+	for (j = 0; j < n; j++)
+	{
+		batch_lane* l = lanes[j];
+
+		l->delta_m = gf_mul2(l->delta_m);
+		l->delta_c = gf_mul2(l->delta_c);
+		blocks[j] = XOR_BLOCK(l->delta_m, last[j]);
+	}
+
+	LANES_ENCRYPT(blocks, n, encryption_keys, shared);
+
+	for (j = 0; j < n; j++)
+	{
+		RHO_INPLACE(blocks[j], lanes[j]->w, w_tmp);
+	}
+
+	LANES_ENCRYPT(blocks, n, encryption_keys, shared);
+
+	for (j = 0; j < n; j++)
+	{
+		batch_lane* l = lanes[j];
+
+		// failed at an intermediate tag
+		if (l->msg == NULL)
+		{
+			continue;
+		}
+
+		// verify the end tag (same as colm 0)
+		STORE_BLOCK(buf, XOR_BLOCK(blocks[j], l->delta_c));
+		if (memcmp(l->in, buf, l->remaining) != 0)
+		{
+			lane_done(l, -2);
+			failed++;
+			continue;
+		}
+
+		if (l->remaining < BLOCKSIZE)
+		{
+			STORE_BLOCK(buf, l->checksum);
+			if (buf[l->remaining] != 0x80)
+			{
+				lane_done(l, -3);
+				failed++;
+				continue;
+			}
+			for (i = l->remaining + 1; i < BLOCKSIZE; i++)
+			{
+				if (buf[i] != 0)
+				{
+					break;
+				}
+			}
+			if (i < BLOCKSIZE)
+			{
+				lane_done(l, -4);
+				failed++;
+				continue;
+			}
+		}
+
+		lane_done(l, 0);
+	}
+
+	return failed;
+}
+
+
+
+/* ----------------------- BATCH ------------------------- */
+
+static size_t run_batch(const colm_key_ctx* ctx, colm_batch_msg* msgs, size_t count, uint8_t tag_interval, uint8_t decrypt)
+{
+	batch_lane lanes[COLM_BATCH_LANES];
+	batch_lane* active[COLM_BATCH_LANES];
+	batch_lane* group[COLM_BATCH_LANES];
+	size_t next = 0, failed = 0;
+	uint64_t k;
+	uint8_t n, g, i, shared = 1;
+
+	// -6 => no AES instructions, every message fails
+	if (colm_backend_active() == NULL)
+	{
+		for (k = 0; k < count; k++)
+		{
+			msgs[k].status = -6;
+		}
+		return count;
+	}
+
+	for (i = 0; i < COLM_BATCH_LANES; i++)
+	{
+		lanes[i].msg = NULL;
+	}
+
+	// all messages with the key of the call?
+	for (k = 0; k < count && shared; k++)
+	{
+		shared = msgs[k].ctx == NULL || msgs[k].ctx == ctx;
+	}
+
+	for (;;)
+	{
+		// free lanes take the next messages and start with their MAC
+		g = 0;
+		for (i = 0; i < COLM_BATCH_LANES; i++)
+		{
+			while (lanes[i].msg == NULL && next < count)
+			{
+				if (lane_start(&lanes[i], &msgs[next++], ctx, tag_interval, decrypt))
+				{
+					group[g++] = &lanes[i];
+				}
+				else
+				{
+					failed++;
+				}
+			}
+		}
+		if (g > 0)
+		{
+			mac_lanes(group, g, tag_interval, shared);
+		}
+
+		n = 0;
+		k = UINT64_MAX;
+		for (i = 0; i < COLM_BATCH_LANES; i++)
+		{
+			if (lanes[i].msg != NULL)
+			{
+				active[n++] = &lanes[i];
+				k = lane_blocks(&lanes[i]) < k ? lane_blocks(&lanes[i]) : k;
+				k = lanes[i].until_tag < k ? lanes[i].until_tag : k;
+			}
+		}
+		if (n == 0)
+		{
+			break;
+		}
+
+		// all lanes process as many blocks as the shortest one has left before its last block or its next intermediate tag
+		if (k > 0 && decrypt)
+		{
+			decrypt_lanes_n(active, k, shared, n);
+		}
+		else if (k > 0)
+		{
+			encrypt_lanes_n(active, k, shared, n);
+		}
+
+		failed += intermediate_tags(active, n, tag_interval, decrypt, shared);
+
+		// lanes at their last block
+		g = 0;
+		for (i = 0; i < n; i++)
+		{
+			if (active[i]->msg != NULL && active[i]->remaining <= BLOCKSIZE)
+			{
+				group[g++] = active[i];
+			}
+		}
+		if (g > 0)
+		{
+			if (decrypt)
+			{
+				failed += decrypt_final(group, g, tag_interval, shared);
+			}
+			else
+			{
+				encrypt_final(group, g, tag_interval, shared);
+			}
+		}
+	}
+
+	return failed;
+}
+
+
+
+/* ----------------------- PUBLIC API ------------------------- */
+
+size_t colm0_encrypt_batch(const colm_key_ctx* ctx, colm_batch_msg* msgs, size_t count)
+{
+	return run_batch(ctx, msgs, count, 0, 0);
+}
+
+size_t colm0_decrypt_batch(const colm_key_ctx* ctx, colm_batch_msg* msgs, size_t count)
+{
+	return run_batch(ctx, msgs, count, 0, 1);
+}
+
+size_t colm127_encrypt_batch(const colm_key_ctx* ctx, colm_batch_msg* msgs, size_t count)
+{
+	return run_batch(ctx, msgs, count, 127, 0);
+}
+
+size_t colm127_decrypt_batch(const colm_key_ctx* ctx, colm_batch_msg* msgs, size_t count)
+{
+	return run_batch(ctx, msgs, count, 127, 1);
+}
+
+AES_TARGET_END
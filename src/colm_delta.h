@@ -0,0 +1,90 @@
+/*
+ * Deltas of the lanes of a pipelined group: lane j of the group after delta gets delta * 2^(j + 1).
+ *
+ * Doubling the delta once per block makes the deltas of a group a chain of width dependent doublings. Here every lane keeps its own
+ * delta and all lanes move forward by 2^width at once (gf_mul2k), so there is no chain between the lanes any more.
+ * The deltas of the first blocks of a message only depend on the key and are taken from the window of the key context.
+ */
+
+#ifndef COLM_DELTA
+#define COLM_DELTA
+
+#include "colm_backend.h"
+
+/*
+ * The deltas of the next width blocks after delta. At the start of a message window is the window of the key context
+ * (delta * 2^1 ... delta * 2^COLM_DELTA_WINDOW) and the deltas are copied from it, otherwise NULL.
+ */
+PIPELINED void lane_deltas(block_t delta, const block_t* window, block_t* deltas, const uint8_t width)
+{
+	uint8_t j;
+
+	if (window != NULL)
+	{
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			deltas[j] = window[j];
+		}
+	}
+	else
+	{
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			deltas[j] = gf_mul2k(delta, j + 1);
+		}
+	}
+}
+
+// window of the key context if delta is the one before the first block (2^i != 1 for any message length), else NULL
+#define DELTA_WINDOW(delta, start, window) (EQUALS(delta, start) ? (window) : NULL)
+
+// the deltas of the group after the current one
+PIPELINED void lane_deltas_next(block_t* deltas, const uint8_t width)
+{
+	uint8_t j;
+
+	UNROLL_LANES
+	for (j = 0; j < width; j++)
+	{
+		deltas[j] = gf_mul2k(deltas[j], width);
+	}
+}
+
+/*
+ * The intermediate tag after lane itag shares the once more doubled delta of that lane, all blocks after it are doubled once more as well.
+ * Returns the delta of the tag and doubles the lanes from itag on, lane_deltas_tag_done doubles the other lanes once they were used,
+ * so all lanes are in step again for lane_deltas_next.
+ */
+PIPELINED block_t lane_deltas_tag(block_t* deltas, const uint8_t itag, const uint8_t width)
+{
+	uint8_t j;
+
+	UNROLL_LANES
+	for (j = 0; j < width; j++)
+	{
+		if (j >= itag)
+		{
+			deltas[j] = gf_mul2(deltas[j]);
+		}
+	}
+
+	return deltas[itag];
+}
+
+PIPELINED void lane_deltas_tag_done(block_t* deltas, const uint8_t itag, const uint8_t width)
+{
+	uint8_t j;
+
+	UNROLL_LANES
+	for (j = 0; j < width; j++)
+	{
+		if (j < itag)
+		{
+			deltas[j] = gf_mul2(deltas[j]);
+		}
+	}
+}
+
+#endif
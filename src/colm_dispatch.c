@@ -0,0 +1,402 @@
+/*
+ * Runtime selection of the COLM implementation.
+ * The CPU is checked once when the library is loaded, afterwards every call goes through the function table of the selected backend.
+ * Nothing in here uses the AES instructions, so this file is safe to run on any CPU.
+ */
+
+#include "colm.h"
+#include "colm_backend.h"
+
+
+/* ----------------------- NO BACKEND ------------------------- */
+
+// used if the CPU has no AES instructions, every call fails with -6
+
+static int8_t unsupported_key_ctx_init(colm_key_ctx* ctx, block_t key)
+{
+	(void)ctx; (void)key;
+	return -6;
+}
+
+// the result is never used, the encryption and decryption fail anyway
+static block_t unsupported_mac(const colm_key_ctx* ctx, block_t npub_param, uint8_t* associated_data, uint64_t data_len)
+{
+	(void)ctx; (void)npub_param; (void)associated_data; (void)data_len;
+	return ZERO_BLOCK();
+}
+
+static int8_t unsupported_colm0(const colm_key_ctx* ctx, block_t w, uint8_t* in, uint64_t in_len, uint64_t* out_len, uint8_t* out)
+{
+	(void)ctx; (void)w; (void)in; (void)in_len; (void)out_len; (void)out;
+	return -6;
+}
+
+static int8_t unsupported_colm_tau_encrypt(const colm_key_ctx* ctx, block_t w, uint16_t tau, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags)
+{
+	(void)ctx; (void)w; (void)tau; (void)message; (void)message_len; (void)c_len; (void)ciphertext; (void)tag_len; (void)tags;
+	return -6;
+}
+
+static int8_t unsupported_colm_tau_decrypt(const colm_key_ctx* ctx, block_t w, uint16_t tau, uint8_t* ciphertext, uint64_t len, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message)
+{
+	(void)ctx; (void)w; (void)tau; (void)ciphertext; (void)len; (void)tag_len; (void)tags; (void)m_len; (void)message;
+	return -6;
+}
+
+static void unsupported_blocks(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, uint64_t full_blocks)
+{
+	(void)ctx; (void)st; (void)in; (void)out; (void)full_blocks;
+}
+
+static const colm_backend colm_backend_unsupported = {
+	.name = "none",
+	.key_ctx_init = unsupported_key_ctx_init,
+	.mac = unsupported_mac,
+	.colm0_encrypt = unsupported_colm0,
+	.colm0_decrypt = unsupported_colm0,
+	.colm_tau_encrypt = unsupported_colm_tau_encrypt,
+	.colm_tau_decrypt = unsupported_colm_tau_decrypt,
+	.encrypt_blocks = unsupported_blocks,
+	.decrypt_blocks = unsupported_blocks,
+};
+
+
+
+/* ----------------------- SELECTION ------------------------- */
+
+static const colm_backend* active_backend;
+
+static int cpu_has_aes(void)
+{
+#if defined(AES_CRYPTO_ARM)
+	// the ARM build is compiled for the crypto extension as a whole, so it can't run without it anyway
+	return 1;
+#else
+	__builtin_cpu_init(); // needed when called from a constructor
+	return __builtin_cpu_supports("aes") && __builtin_cpu_supports("pclmul");
+#endif
+}
+
+#if defined(AES_CRYPTO_X86)
+static int cpu_has_vaes(void)
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("aes") && __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("vaes") && __builtin_cpu_supports("avx512f");
+}
+#endif
+
+// all implementations, the fastest first
+static const struct
+{
+	const colm_backend* backend;
+	int (*supported)(void);
+} backends[] = {
+#if defined(AES_CRYPTO_X86)
+	{ &colm_backend_vaes, cpu_has_vaes },
+#endif
+	{ &colm_backend_pipelined, cpu_has_aes },
+};
+
+#define BACKEND_COUNT (sizeof(backends) / sizeof(backends[0]))
+
+static const colm_backend* select_backend(void)
+{
+	size_t i;
+
+	for (i = 0; i < BACKEND_COUNT; i++)
+	{
+		if (backends[i].supported())
+		{
+			return backends[i].backend;
+		}
+	}
+
+	return &colm_backend_unsupported;
+}
+
+// runs when the library is loaded
+__attribute__((constructor)) static void colm_dispatch_init(void)
+{
+	active_backend = select_backend();
+}
+
+// in case we are called before the constructor ran (e.g. from another constructor)
+static inline const colm_backend* backend(void)
+{
+	if (active_backend == NULL)
+	{
+		active_backend = select_backend();
+	}
+
+	return active_backend;
+}
+
+/*
+ * Use a specific implementation instead of the fastest one (e.g. to compare them).
+ * Not thread safe, call it before using the library. -6 => unknown or not supported by the CPU
+ */
+int8_t colm_backend_select(const char* name)
+{
+	size_t i;
+
+	for (i = 0; i < BACKEND_COUNT; i++)
+	{
+		if (strcmp(backends[i].backend->name, name) == 0 && backends[i].supported())
+		{
+			active_backend = backends[i].backend;
+			return 0;
+		}
+	}
+
+	return -6;
+}
+
+const char* colm_backend_name(void)
+{
+	return backend()->name;
+}
+
+// for the parts of the library that use the backend functions directly (colm_thread.c, colm_stream.c)
+const colm_backend* colm_backend_active(void)
+{
+	const colm_backend* b = backend();
+	return b == &colm_backend_unsupported ? NULL : b;
+}
+
+
+
+/* ----------------------- STATISTICS ------------------------- */
+
+#ifdef COLM_STATS
+__thread colm_stats colm_stats_thread;
+
+int8_t colm_stats_snapshot(colm_stats* stats)
+{
+	*stats = colm_stats_thread;
+	return 0;
+}
+
+int8_t colm_stats_reset(void)
+{
+	memset(&colm_stats_thread, 0, sizeof(colm_stats_thread));
+	return 0;
+}
+#else
+// built without -DCOLM_STATS: nothing is collected
+int8_t colm_stats_snapshot(colm_stats* stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	return -1;
+}
+
+int8_t colm_stats_reset(void)
+{
+	return -1;
+}
+#endif
+
+
+
+/* ----------------------- PUBLIC API ------------------------- */
+
+int8_t colm_key_ctx_init(colm_key_ctx* ctx, block_t key)
+{
+	return backend()->key_ctx_init(ctx, key);
+}
+
+int8_t colm0_encrypt_ctx(const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext)
+{
+	const colm_backend* b = backend();
+
+	if (b->colm0_encrypt_mac != NULL)
+	{
+		return b->colm0_encrypt_mac(ctx, NONCE_BLOCK(npub, COLM0_PARAM), associated_data, data_len, message, message_len, c_len, ciphertext);
+	}
+	return b->colm0_encrypt(ctx, b->mac(ctx, NONCE_BLOCK(npub, COLM0_PARAM), associated_data, data_len), message, message_len, c_len, ciphertext);
+}
+
+int8_t colm0_decrypt_ctx(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* m_len, uint8_t* message)
+{
+	const colm_backend* b = backend();
+	return COLM_STATS_RESULT(b->colm0_decrypt(ctx, b->mac(ctx, NONCE_BLOCK(npub, COLM0_PARAM), associated_data, data_len), ciphertext, len, m_len, message));
+}
+
+int8_t colm127_encrypt_ctx(const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags)
+{
+	const colm_backend* b = backend();
+	return b->colm_tau_encrypt(ctx, b->mac(ctx, NONCE_BLOCK(npub, COLM127_PARAM), associated_data, data_len), 127, message, message_len, c_len, ciphertext, tag_len, tags);
+}
+
+int8_t colm127_decrypt_ctx(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message)
+{
+	const colm_backend* b = backend();
+	return COLM_STATS_RESULT(b->colm_tau_decrypt(ctx, b->mac(ctx, NONCE_BLOCK(npub, COLM127_PARAM), associated_data, data_len), 127, ciphertext, len, tag_len, tags, m_len, message));
+}
+
+// any other interval, tau = 0 is COLM0 (no intermediate tags)
+int8_t colm_tau_encrypt_ctx(const colm_key_ctx* ctx, uint16_t tau, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags)
+{
+	const colm_backend* b = backend();
+
+	if (tau == 0)
+	{
+		*tag_len = 0;
+		return colm0_encrypt_ctx(ctx, message, message_len, associated_data, data_len, npub, c_len, ciphertext);
+	}
+
+	return b->colm_tau_encrypt(ctx, b->mac(ctx, NONCE_BLOCK(npub, COLM_TAU_PARAM(tau)), associated_data, data_len), tau, message, message_len, c_len, ciphertext, tag_len, tags);
+}
+
+int8_t colm_tau_decrypt_ctx(const colm_key_ctx* ctx, uint16_t tau, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message)
+{
+	const colm_backend* b = backend();
+
+	if (tau == 0)
+	{
+		return colm0_decrypt_ctx(ctx, ciphertext, len, associated_data, data_len, npub, m_len, message);
+	}
+
+	return COLM_STATS_RESULT(b->colm_tau_decrypt(ctx, b->mac(ctx, NONCE_BLOCK(npub, COLM_TAU_PARAM(tau)), associated_data, data_len), tau, ciphertext, len, tag_len, tags, m_len, message));
+}
+
+
+// the decryptions without message: the loops only advance rho state and checksum, no plaintext is stored
+int8_t colm0_verify(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub)
+{
+	const colm_backend* b = backend();
+	uint64_t m_len;
+
+	return COLM_STATS_RESULT(b->colm0_decrypt(ctx, b->mac(ctx, NONCE_BLOCK(npub, COLM0_PARAM), associated_data, data_len), ciphertext, len, &m_len, NULL));
+}
+
+int8_t colm127_verify(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t tag_len, uint8_t* tags)
+{
+	const colm_backend* b = backend();
+	uint64_t m_len;
+
+	return COLM_STATS_RESULT(b->colm_tau_decrypt(ctx, b->mac(ctx, NONCE_BLOCK(npub, COLM127_PARAM), associated_data, data_len), 127, ciphertext, len, tag_len, tags, &m_len, NULL));
+}
+
+/*
+ * Associated data cache: the MAC is put together from the cache (colm_ad_cache.c) and the suffix, the rest is the same as above.
+ * The cache functions use the AES instructions, so nothing is done without a backend.
+ */
+
+int8_t colm0_encrypt_cached(const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, const colm_ad_cache* cache, const uint8_t* suffix, uint64_t suffix_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext)
+{
+	const colm_backend* b = backend();
+	block_t w;
+	int8_t result;
+
+	if (b == &colm_backend_unsupported)
+	{
+		return -6;
+	}
+
+	result = colm_ad_cache_mac(ctx, cache, NONCE_BLOCK(npub, COLM0_PARAM), suffix, suffix_len, &w);
+	return result != 0 ? result : b->colm0_encrypt(ctx, w, message, message_len, c_len, ciphertext);
+}
+
+int8_t colm0_decrypt_cached(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, const colm_ad_cache* cache, const uint8_t* suffix, uint64_t suffix_len, uint64_t npub, uint64_t* m_len, uint8_t* message)
+{
+	const colm_backend* b = backend();
+	block_t w;
+	int8_t result;
+
+	if (b == &colm_backend_unsupported)
+	{
+		return -6;
+	}
+
+	result = colm_ad_cache_mac(ctx, cache, NONCE_BLOCK(npub, COLM0_PARAM), suffix, suffix_len, &w);
+	return COLM_STATS_RESULT(result != 0 ? result : b->colm0_decrypt(ctx, w, ciphertext, len, m_len, message));
+}
+
+int8_t colm127_encrypt_cached(const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, const colm_ad_cache* cache, const uint8_t* suffix, uint64_t suffix_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags)
+{
+	const colm_backend* b = backend();
+	block_t w;
+	int8_t result;
+
+	if (b == &colm_backend_unsupported)
+	{
+		return -6;
+	}
+
+	result = colm_ad_cache_mac(ctx, cache, NONCE_BLOCK(npub, COLM127_PARAM), suffix, suffix_len, &w);
+	return result != 0 ? result : b->colm_tau_encrypt(ctx, w, 127, message, message_len, c_len, ciphertext, tag_len, tags);
+}
+
+int8_t colm127_decrypt_cached(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, const colm_ad_cache* cache, const uint8_t* suffix, uint64_t suffix_len, uint64_t npub, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message)
+{
+	const colm_backend* b = backend();
+	block_t w;
+	int8_t result;
+
+	if (b == &colm_backend_unsupported)
+	{
+		return -6;
+	}
+
+	result = colm_ad_cache_mac(ctx, cache, NONCE_BLOCK(npub, COLM127_PARAM), suffix, suffix_len, &w);
+	return COLM_STATS_RESULT(result != 0 ? result : b->colm_tau_decrypt(ctx, w, 127, ciphertext, len, tag_len, tags, m_len, message));
+}
+
+
+// the key is only needed for one message: prepare a temporary context and wipe it afterwards
+
+int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t* c_len, uint8_t* ciphertext)
+{
+	colm_key_ctx ctx;
+	int8_t result = colm_key_ctx_init(&ctx, key);
+
+	if (result == 0)
+	{
+		result = colm0_encrypt_ctx(&ctx, message, message_len, associated_data, data_len, npub, c_len, ciphertext);
+	}
+	colm_key_ctx_free(&ctx);
+
+	return result;
+}
+
+int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t* m_len, uint8_t* message)
+{
+	colm_key_ctx ctx;
+	int8_t result = colm_key_ctx_init(&ctx, key);
+
+	if (result == 0)
+	{
+		result = colm0_decrypt_ctx(&ctx, ciphertext, len, associated_data, data_len, npub, m_len, message);
+	}
+	colm_key_ctx_free(&ctx);
+
+	return result;
+}
+
+int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags)
+{
+	colm_key_ctx ctx;
+	int8_t result = colm_key_ctx_init(&ctx, key);
+
+	if (result == 0)
+	{
+		result = colm127_encrypt_ctx(&ctx, message, message_len, associated_data, data_len, npub, c_len, ciphertext, tag_len, tags);
+	}
+	colm_key_ctx_free(&ctx);
+
+	return result;
+}
+
+int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, block_t key, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message)
+{
+	colm_key_ctx ctx;
+	int8_t result = colm_key_ctx_init(&ctx, key);
+
+	if (result == 0)
+	{
+		result = colm127_decrypt_ctx(&ctx, ciphertext, len, associated_data, data_len, npub, tag_len, tags, m_len, message);
+	}
+	colm_key_ctx_free(&ctx);
+
+	return result;
+}
@@ -0,0 +1,156 @@
+/*
+ * COLM127 with the intermediate tags in the ciphertext (in-band format).
+ *
+ * Every tag directly follows the ciphertext block it belongs to, so the output is one buffer:
+ *   C_1 ... C_127 T_1 C_128 ... C_254 T_2 ... C_l [T] tag
+ * The blocks are the same as the output of colm127_encrypt, only the tags are spliced in. The length of the output only depends
+ * on the length of the message (colm127_inband_len).
+ */
+
+#include "colm.h"
+#include "colm_backend.h"
+
+#define SEGMENT_BLOCKS 127
+
+// number of intermediate tags of a message (one after every 127th block, the last block counts even for an empty message)
+static uint64_t tag_count(uint64_t message_len)
+{
+	uint64_t blocks = message_len > 0 ? (message_len + BLOCKSIZE - 1) / BLOCKSIZE : 1;
+	return blocks / SEGMENT_BLOCKS;
+}
+
+uint64_t colm127_tags_len(uint64_t message_len)
+{
+	return tag_count(message_len) * BLOCKSIZE;
+}
+
+uint64_t colm127_inband_len(uint64_t message_len)
+{
+	return message_len + BLOCKSIZE + colm127_tags_len(message_len);
+}
+
+// everything below uses the AES instructions (see aes_crypto.h)
+AES_TARGET_BEGIN
+
+int8_t colm127_encrypt_inband(const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext)
+{
+	const colm_backend* b = colm_backend_active();
+	uint64_t blocks = message_len > 0 ? (message_len - 1) / BLOCKSIZE : 0; // all blocks before the last one
+	uint64_t tail = blocks % SEGMENT_BLOCKS;
+	const uint8_t* in = message;
+	uint8_t* out = ciphertext;
+	uint8_t remaining;
+	colm_state st;
+
+	if (b == NULL)
+	{
+		return -6;
+	}
+
+	*c_len = colm127_inband_len(message_len);
+
+	st.w = b->mac(ctx, NONCE_BLOCK(npub, COLM127_PARAM), associated_data, data_len);
+	st.checksum = ZERO_BLOCK();
+	st.delta_m = ctx->L;
+	st.delta_c = ctx->delta_c;
+
+	// whole segments, the tag right behind their last block
+	for (; blocks >= SEGMENT_BLOCKS; blocks -= SEGMENT_BLOCKS)
+	{
+		b->encrypt_blocks(ctx, &st, in, out, SEGMENT_BLOCKS - 1);
+		in += (SEGMENT_BLOCKS - 1) * BLOCKSIZE;
+		out += (SEGMENT_BLOCKS - 1) * BLOCKSIZE;
+
+		colm_encrypt_tag_block(ctx, &st, in, out, out + BLOCKSIZE);
+		in += BLOCKSIZE;
+		out += 2 * BLOCKSIZE;
+	}
+
+	b->encrypt_blocks(ctx, &st, in, out, tail);
+	in += tail * BLOCKSIZE;
+	out += tail * BLOCKSIZE;
+
+	// the last block is followed by a tag if it is the 127th of its segment
+	remaining = (uint8_t)(message_len - (in - message));
+	if (tail == SEGMENT_BLOCKS - 1)
+	{
+		colm_encrypt_last(ctx, &st, in, remaining, out, out + BLOCKSIZE, out + 2 * BLOCKSIZE);
+	}
+	else
+	{
+		colm_encrypt_last(ctx, &st, in, remaining, out, NULL, out + BLOCKSIZE);
+	}
+
+	return 0;
+}
+
+int8_t colm127_decrypt_inband(const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* m_len, uint8_t* message)
+{
+	const colm_backend* b = colm_backend_active();
+	uint64_t message_len, blocks, tail, tags;
+	const uint8_t* in = ciphertext;
+	uint8_t* out = message;
+	uint8_t remaining;
+	colm_state st;
+	int8_t result;
+
+	if (b == NULL)
+	{
+		return -6;
+	}
+
+	// the length of the message: len minus tag and intermediate tags (one per 2048 bytes, try the neighbours of the estimate)
+	if (len < BLOCKSIZE)
+	{
+		// -1 => invalid size of ciphertext
+		return -1;
+	}
+	tags = (len - BLOCKSIZE) / ((SEGMENT_BLOCKS + 1) * BLOCKSIZE) + 1;
+	while (tags > 0 && (tags * BLOCKSIZE > len - BLOCKSIZE || colm127_inband_len(len - BLOCKSIZE - tags * BLOCKSIZE) != len))
+	{
+		tags--;
+	}
+	message_len = len - BLOCKSIZE - tags * BLOCKSIZE;
+	if (colm127_inband_len(message_len) != len)
+	{
+		return -1;
+	}
+
+	*m_len = message_len;
+	blocks = message_len > 0 ? (message_len - 1) / BLOCKSIZE : 0;
+	tail = blocks % SEGMENT_BLOCKS;
+
+	st.w = b->mac(ctx, NONCE_BLOCK(npub, COLM127_PARAM), associated_data, data_len);
+	st.checksum = ZERO_BLOCK();
+	st.delta_m = ctx->L;
+	st.delta_c = ctx->delta_c;
+
+	for (; blocks >= SEGMENT_BLOCKS; blocks -= SEGMENT_BLOCKS)
+	{
+		b->decrypt_blocks(ctx, &st, in, out, SEGMENT_BLOCKS - 1);
+		in += (SEGMENT_BLOCKS - 1) * BLOCKSIZE;
+		out += (SEGMENT_BLOCKS - 1) * BLOCKSIZE;
+
+		result = colm_decrypt_tag_block(ctx, &st, in, out, in + BLOCKSIZE);
+		if (result != 0)
+		{
+			return result;
+		}
+		in += 2 * BLOCKSIZE;
+		out += BLOCKSIZE;
+	}
+
+	b->decrypt_blocks(ctx, &st, in, out, tail);
+	in += tail * BLOCKSIZE;
+	out += tail * BLOCKSIZE;
+
+	remaining = (uint8_t)(message_len - (out - message));
+	if (tail == SEGMENT_BLOCKS - 1)
+	{
+		return colm_decrypt_last(ctx, &st, in, in + BLOCKSIZE, in + 2 * BLOCKSIZE, remaining, out);
+	}
+
+	return colm_decrypt_last(ctx, &st, in, NULL, in + BLOCKSIZE, remaining, out);
+}
+
+AES_TARGET_END
@@ -0,0 +1,368 @@
+/*
+ * Scatter / gather API: message, ciphertext and associated data in fragments (e.g. the buffer chain of a network packet).
+ *
+ * A cursor walks over the fragments of each side. A run of full blocks that lies in one input and one output fragment goes through the
+ * block loops of the backend in place (encrypt_blocks / decrypt_blocks of colm_backend.h), only a block across the border of a fragment
+ * is collected in a block buffer. The last block and the tag (at most 32 bytes) are always put together in a buffer and finished with
+ * the helpers of colm_stream.c. The associated data is summed up with the queue of colm_ad_queue.h, a single fragment goes to mac().
+ */
+
+#include "colm.h"
+#include "colm_backend.h"
+#include "colm_ad_queue.h"
+
+#define SEGMENT_BLOCKS 127
+
+// position in an array of fragments
+typedef struct iov_cursor
+{
+	const colm_iovec* iov;
+	size_t count;
+	size_t index;  // current fragment
+	size_t offset; // bytes of it already used
+} iov_cursor;
+
+static void cursor_init(iov_cursor* c, const colm_iovec* iov, size_t count)
+{
+	c->iov = iov;
+	c->count = count;
+	c->index = 0;
+	c->offset = 0;
+}
+
+static uint64_t iov_total(const colm_iovec* iov, size_t count)
+{
+	uint64_t total = 0;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		total += iov[i].iov_len;
+	}
+
+	return total;
+}
+
+// bytes left in the current fragment (empty and used up fragments are skipped), 0 at the end
+static size_t cursor_avail(iov_cursor* c)
+{
+	while (c->index < c->count && c->offset == c->iov[c->index].iov_len)
+	{
+		c->index++;
+		c->offset = 0;
+	}
+
+	return c->index < c->count ? c->iov[c->index].iov_len - c->offset : 0;
+}
+
+static uint8_t* cursor_ptr(const iov_cursor* c)
+{
+	return (uint8_t*)c->iov[c->index].iov_base + c->offset;
+}
+
+// len bytes from the fragments to buf (gather) or from buf to the fragments (scatter), the fragments have at least len bytes left
+static void cursor_copy(iov_cursor* c, uint8_t* buf, uint64_t len, uint8_t scatter)
+{
+	size_t take;
+
+	while (len > 0)
+	{
+		take = cursor_avail(c);
+		if (take > len)
+		{
+			take = (size_t)len;
+		}
+
+		scatter ? memcpy(cursor_ptr(c), buf, take) : memcpy(buf, cursor_ptr(c), take);
+		c->offset += take;
+		buf += take;
+		len -= take;
+	}
+}
+
+// everything below uses the AES instructions (see aes_crypto.h)
+AES_TARGET_BEGIN
+
+// w = MAC of the nonce and the associated data, the same value mac() returns for the fragments in one buffer
+static block_t iov_mac(const colm_key_ctx* ctx, const colm_backend* b, block_t npub_param, const colm_iovec* associated_data, size_t data_count)
+{
+	const block_t* aes_round_keys = ctx->aes_encryption_keys;
+	ad_queue q = { .sum = ZERO_BLOCK() };
+	block_t delta = ctx->delta_ad;
+	uint8_t buf[BLOCKSIZE] = { 0 };
+	uint64_t left = iov_total(associated_data, data_count);
+	uint64_t blocks;
+	iov_cursor c;
+
+	cursor_init(&c, associated_data, data_count);
+
+	// all of it in one fragment (or none): the MAC of the backend
+	if (cursor_avail(&c) == left)
+	{
+		return b->mac(ctx, npub_param, left > 0 ? cursor_ptr(&c) : NULL, left);
+	}
+
+	queue_push(&q, XOR_BLOCK(SWAP_BLOCK(npub_param), ctx->delta_ad), aes_round_keys);
+
+	while (left >= BLOCKSIZE)
+	{
+		blocks = cursor_avail(&c) / BLOCKSIZE;
+		if (blocks > left / BLOCKSIZE)
+		{
+			blocks = left / BLOCKSIZE;
+		}
+
+		if (blocks > 0)
+		{
+			queue_blocks(&q, cursor_ptr(&c), blocks, &delta, aes_round_keys);
+			c.offset += blocks * BLOCKSIZE;
+		}
+		else
+		{
+			// block across the border of a fragment
+			blocks = 1;
+			cursor_copy(&c, buf, BLOCKSIZE, 0);
+			queue_blocks(&q, buf, 1, &delta, aes_round_keys);
+		}
+		left -= blocks * BLOCKSIZE;
+	}
+
+	// padded last block
+	if (left > 0)
+	{
+		memset(buf, 0, BLOCKSIZE);
+		cursor_copy(&c, buf, left, 0);
+		buf[left] ^= 0x80; /* padding */
+		delta = gf_mul7(delta);
+		queue_push(&q, XOR_BLOCK(LOAD_BLOCK(buf), delta), aes_round_keys);
+	}
+
+	queue_flush(&q, aes_round_keys);
+	return q.sum;
+}
+
+/*
+ * n full blocks, none of them the last block of the message. until_tag counts the blocks up to the next intermediate tag
+ * (as in colm_stream.c, UINT64_MAX for COLM0), the tags are written to / read from *tags.
+ */
+static int8_t iov_blocks(const colm_key_ctx* ctx, const colm_backend* b, colm_state* st, iov_cursor* in, iov_cursor* out, uint64_t n, uint8_t decrypt, uint64_t* until_tag, uint8_t** tags)
+{
+	uint8_t in_buf[BLOCKSIZE], out_buf[BLOCKSIZE];
+	const uint8_t* src;
+	uint8_t* dst;
+	uint64_t k;
+	uint8_t direct_out;
+	int8_t result;
+
+	while (n > 0)
+	{
+		// blocks in one piece in the input and in the output, up to the block before the intermediate tag
+		k = cursor_avail(in) < cursor_avail(out) ? cursor_avail(in) : cursor_avail(out);
+		k /= BLOCKSIZE;
+		if (k > n)
+		{
+			k = n;
+		}
+		if (k >= *until_tag)
+		{
+			k = *until_tag - 1;
+		}
+
+		if (k > 0)
+		{
+			decrypt ? b->decrypt_blocks(ctx, st, cursor_ptr(in), cursor_ptr(out), k) : b->encrypt_blocks(ctx, st, cursor_ptr(in), cursor_ptr(out), k);
+			in->offset += k * BLOCKSIZE;
+			out->offset += k * BLOCKSIZE;
+			*until_tag -= k;
+			n -= k;
+			continue;
+		}
+
+		// a single block: across the border of a fragment or followed by an intermediate tag
+		if (cursor_avail(in) >= BLOCKSIZE)
+		{
+			src = cursor_ptr(in);
+			in->offset += BLOCKSIZE;
+		}
+		else
+		{
+			cursor_copy(in, in_buf, BLOCKSIZE, 0);
+			src = in_buf;
+		}
+		direct_out = cursor_avail(out) >= BLOCKSIZE;
+		dst = direct_out ? cursor_ptr(out) : out_buf;
+
+		if (*until_tag == 1)
+		{
+			if (decrypt)
+			{
+				result = colm_decrypt_tag_block(ctx, st, src, dst, *tags);
+				if (result != 0)
+				{
+					return result;
+				}
+			}
+			else
+			{
+				colm_encrypt_tag_block(ctx, st, src, dst, *tags);
+			}
+			*tags += BLOCKSIZE;
+			*until_tag = SEGMENT_BLOCKS;
+		}
+		else
+		{
+			decrypt ? b->decrypt_blocks(ctx, st, src, dst, 1) : b->encrypt_blocks(ctx, st, src, dst, 1);
+			*until_tag -= 1;
+		}
+
+		if (direct_out)
+		{
+			out->offset += BLOCKSIZE;
+		}
+		else
+		{
+			cursor_copy(out, out_buf, BLOCKSIZE, 1);
+		}
+		n--;
+	}
+
+	return 0;
+}
+
+static int8_t iov_encrypt(const colm_key_ctx* ctx, const colm_iovec* message, size_t message_count, const colm_iovec* associated_data, size_t data_count, uint64_t npub,
+                          uint64_t* c_len, const colm_iovec* ciphertext, size_t c_count, uint64_t* tag_len, uint8_t* tags, uint8_t tag_interval)
+{
+	const colm_backend* b = colm_backend_active();
+	uint64_t message_len = iov_total(message, message_count);
+	uint64_t blocks = message_len > 0 ? (message_len - 1) / BLOCKSIZE : 0; // all blocks before the last one
+	uint64_t until_tag = tag_interval ? tag_interval : UINT64_MAX;
+	uint8_t buf[BLOCKSIZE], last[2 * BLOCKSIZE];
+	uint8_t* tag_out = tags;
+	uint8_t remaining;
+	iov_cursor in, out;
+	colm_state st;
+
+	if (b == NULL)
+	{
+		return -6;
+	}
+
+	*c_len = message_len + BLOCKSIZE;
+	if (iov_total(ciphertext, c_count) < *c_len)
+	{
+		// -1 => the output fragments are too small
+		return -1;
+	}
+
+	st.w = iov_mac(ctx, b, NONCE_BLOCK(npub, tag_interval ? COLM127_PARAM : COLM0_PARAM), associated_data, data_count);
+	st.checksum = ZERO_BLOCK();
+	st.delta_m = ctx->L;
+	st.delta_c = ctx->delta_c;
+
+	cursor_init(&in, message, message_count);
+	cursor_init(&out, ciphertext, c_count);
+	iov_blocks(ctx, b, &st, &in, &out, blocks, 0, &until_tag, &tag_out);
+
+	// the last block and the tag
+	remaining = (uint8_t)(message_len - blocks * BLOCKSIZE);
+	cursor_copy(&in, buf, remaining, 0);
+	colm_encrypt_last(ctx, &st, buf, remaining, last, --until_tag == 0 ? tag_out : NULL, last + BLOCKSIZE);
+	cursor_copy(&out, last, BLOCKSIZE + remaining, 1);
+
+	if (tag_len != NULL)
+	{
+		*tag_len = (uint64_t)(tag_out - tags) + (until_tag == 0 ? BLOCKSIZE : 0);
+	}
+
+	return 0;
+}
+
+static int8_t iov_decrypt(const colm_key_ctx* ctx, const colm_iovec* ciphertext, size_t c_count, const colm_iovec* associated_data, size_t data_count, uint64_t npub,
+                          uint64_t tag_len, uint8_t* tags, uint64_t* m_len, const colm_iovec* message, size_t message_count, uint8_t tag_interval)
+{
+	const colm_backend* b = colm_backend_active();
+	uint64_t len = iov_total(ciphertext, c_count);
+	uint64_t blocks, until_tag = tag_interval ? tag_interval : UINT64_MAX;
+	uint8_t buf[2 * BLOCKSIZE], last[BLOCKSIZE];
+	uint8_t* tag_in = tags;
+	uint8_t remaining;
+	iov_cursor in, out;
+	colm_state st;
+	int8_t result;
+
+	if (b == NULL)
+	{
+		return -6;
+	}
+
+	if (len < BLOCKSIZE)
+	{
+		// -1 => invalid size of ciphertext
+		return -1;
+	}
+
+	*m_len = len - BLOCKSIZE;
+	if (iov_total(message, message_count) < *m_len)
+	{
+		// -1 => the output fragments are too small
+		return -1;
+	}
+	blocks = *m_len > 0 ? (*m_len - 1) / BLOCKSIZE : 0;
+
+	// -1 => not all intermediate tags there
+	if (tag_interval && tag_len / BLOCKSIZE < (blocks + 1) / tag_interval)
+	{
+		return -1;
+	}
+
+	st.w = iov_mac(ctx, b, NONCE_BLOCK(npub, tag_interval ? COLM127_PARAM : COLM0_PARAM), associated_data, data_count);
+	st.checksum = ZERO_BLOCK();
+	st.delta_m = ctx->L;
+	st.delta_c = ctx->delta_c;
+
+	cursor_init(&in, ciphertext, c_count);
+	cursor_init(&out, message, message_count);
+	result = iov_blocks(ctx, b, &st, &in, &out, blocks, 1, &until_tag, &tag_in);
+	if (result != 0)
+	{
+		return result;
+	}
+
+	// the last block and the tag, the plaintext is written before the check (as by colm0_decrypt)
+	remaining = (uint8_t)(*m_len - blocks * BLOCKSIZE);
+	cursor_copy(&in, buf, BLOCKSIZE + remaining, 0);
+	result = colm_decrypt_last(ctx, &st, buf, --until_tag == 0 ? tag_in : NULL, buf + BLOCKSIZE, remaining, last);
+	cursor_copy(&out, last, remaining, 1);
+
+	return result;
+}
+
+
+
+/* ----------------------- PUBLIC API ------------------------- */
+
+int8_t colm0_encryptv(const colm_key_ctx* ctx, const colm_iovec* message, size_t message_count, const colm_iovec* associated_data, size_t data_count, uint64_t npub,
+                      uint64_t* c_len, const colm_iovec* ciphertext, size_t c_count)
+{
+	return iov_encrypt(ctx, message, message_count, associated_data, data_count, npub, c_len, ciphertext, c_count, NULL, NULL, 0);
+}
+
+int8_t colm0_decryptv(const colm_key_ctx* ctx, const colm_iovec* ciphertext, size_t c_count, const colm_iovec* associated_data, size_t data_count, uint64_t npub,
+                      uint64_t* m_len, const colm_iovec* message, size_t message_count)
+{
+	return iov_decrypt(ctx, ciphertext, c_count, associated_data, data_count, npub, 0, NULL, m_len, message, message_count, 0);
+}
+
+int8_t colm127_encryptv(const colm_key_ctx* ctx, const colm_iovec* message, size_t message_count, const colm_iovec* associated_data, size_t data_count, uint64_t npub,
+                        uint64_t* c_len, const colm_iovec* ciphertext, size_t c_count, uint64_t* tag_len, uint8_t* tags)
+{
+	return iov_encrypt(ctx, message, message_count, associated_data, data_count, npub, c_len, ciphertext, c_count, tag_len, tags, SEGMENT_BLOCKS);
+}
+
+int8_t colm127_decryptv(const colm_key_ctx* ctx, const colm_iovec* ciphertext, size_t c_count, const colm_iovec* associated_data, size_t data_count, uint64_t npub,
+                        uint64_t tag_len, uint8_t* tags, uint64_t* m_len, const colm_iovec* message, size_t message_count)
+{
+	return iov_decrypt(ctx, ciphertext, c_count, associated_data, data_count, npub, tag_len, tags, m_len, message, message_count, SEGMENT_BLOCKS);
+}
+
+AES_TARGET_END
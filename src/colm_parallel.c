@@ -5,105 +5,124 @@
  */
 
 #include "colm.h"
+#include "colm_backend.h"
+#include "colm_rho.h"
+#include "colm_delta.h"
 
+// everything below uses the AES instructions (see aes_crypto.h)
+AES_TARGET_BEGIN
 
-#define EQUALS(a, b) (vaddlvq_u8(veorq_u8(a, b)) == 0)
-
-#define RHO_INPLACE(x, st, w_new) do { \
-									w_new = veorq_u8(gf_mul2(st), x); \
-									x = veorq_u8(w_new, st); \
-									st = w_new; \
-								} while(0)
+#define SET_ENCRPTION_KEYS(key, round_keys) AES_SET_ENCRYPTION_KEYS(key, round_keys);
+#define SET_DECRPTION_KEYS(encryption_round_keys, decryption_round_keys) AES_SET_DECRYPTION_KEYS(encryption_round_keys, decryption_round_keys)
 
-#define RHO_INVERSE_INPLACE(y, st, w_new) do { \
-											w_new = gf_mul2(st); \
-											st = veorq_u8(st, y); \
-											y = veorq_u8(w_new, st); \
-										} while(0)
 
+// perform galois multiplication with 3 (x * 2 + x)
+block_t gf_mul3(block_t x)
+{
+	return XOR_BLOCK(gf_mul2(x), x);
+}
 
-#define LOAD_BLOCK(ptr) vrev64q_u8(vld1q_u8(ptr)) // load and change endianness
-#define STORE_BLOCK(ptr, block) vst1q_u8(ptr, vrev64q_u8(block))
+// perform galois multiplication with 7 (((2 * x) * 2) + (2 * x) + x)
+block_t gf_mul7(block_t x)
+{
+	block_t tmp = gf_mul2(x);
+	return XOR_BLOCK(XOR_BLOCK(gf_mul2(tmp), tmp), x);
+}
 
+// general galois multiplication, bit by bit. Only used a few times per message (to jump to a block, colm_thread.c and colm_seek.c)
+block_t gf_mul(block_t a, block_t b)
+{
+	uint8_t buf[BLOCKSIZE];
+	uint64_t half[2]; // upper and lower 64 bit of b (STORE_BLOCK gives the same layout on all platforms)
+	block_t result = ZERO_BLOCK();
+	int i;
 
-#define SET_ENCRPTION_KEYS(key, round_keys) AES_SET_ENCRYPTION_KEYS(key, round_keys);
-#define SET_DECRPTION_KEYS(encryption_round_keys, decryption_round_keys) AES_SET_DECRYPTION_KEYS(encryption_round_keys, decryption_round_keys)
+	STORE_BLOCK(buf, b);
+	memcpy(half, buf, BLOCKSIZE);
 
+	for (i = 127; i >= 0; i--)
+	{
+		result = gf_mul2(result);
+		if ((half[i < 64] >> (i & 63)) & 1)
+		{
+			result = XOR_BLOCK(result, a);
+		}
+	}
 
-// perform galois multiplication with 2
-uint8x16_t gf_mul2(uint8x16_t x)
-{
-	uint8x16_t temp = vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(x), 7));
-	uint8x16_t x64 = vshlq_n_u8(x, 1); // multiply by two
-	x64 = vorrq_u8(x64, vandq_u8(vextq_u8(temp, zero_vector, 1), ((uint8x16_t){1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0}))); // handle overflow bit from lower bytes to higher bytes
-	return veorq_u8(x64, vandq_u8(vdupq_laneq_u8(temp, 0), (uint8x16_t){0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x87}));
+	return result;
 }
 
-// perform galois multiplication with 3 (x * 2 + x)
-uint8x16_t gf_mul3(uint8x16_t x)
+// 2^n (square and multiply, the multiply is a doubling)
+block_t gf_pow2(uint64_t n)
 {
-	return veorq_u8(gf_mul2(x), x);
+	const uint8_t one[BLOCKSIZE] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0 };
+	block_t result = LOAD_BLOCK(one);
+	int i;
+
+	for (i = 63; i >= 0 && !((n >> i) & 1); i--); // skip the leading zeros
+
+	for (; i >= 0; i--)
+	{
+		result = gf_mul(result, result);
+		if ((n >> i) & 1)
+		{
+			result = gf_mul2(result);
+		}
+	}
+
+	return result;
 }
 
-// perform galois multiplication with 7 (((2 * x) * 2) + (2 * x) + x)
-uint8x16_t gf_mul7(uint8x16_t x)
+// x * 2^n
+block_t gf_mul_pow2(block_t x, uint64_t n)
 {
-	uint8x16_t tmp = gf_mul2(x);
-	return veorq_u8(veorq_u8(gf_mul2(tmp), tmp), x);
+	return n == 0 ? x : gf_mul(x, gf_pow2(n));
 }
 
 
-// the first part of the colm cipher: calculate the "mac of the authenticated data"
-uint8x16_t mac(uint8x16_t npub_param, uint8_t* associated_data, const uint64_t data_len, uint8x16_t L, uint8x16_t* aes_round_keys)
+// MAC of the authenticated data from in on, v and delta are the state after the blocks before in (window: see lane_deltas)
+PIPELINED block_t mac_blocks(block_t v, block_t delta, const block_t* window, const uint8_t* in, uint64_t len, const block_t* aes_round_keys, const uint8_t width)
 {
-	uint8_t* in = associated_data;
-	uint64_t len = data_len;
 	uint8_t buf[BLOCKSIZE] = { 0 };
-	uint8x16_t block, v, delta;
-	uint8x16_t block1, block2, block3;
-	uint8x16_t delta1, delta2, delta3;
-	uint8x16_t tmp;
-	
-	delta = delta3= gf_mul3(L);
+	block_t block;
+	block_t blocks[COLM_MAX_PIPELINE_WIDTH], deltas[COLM_MAX_PIPELINE_WIDTH];
+	uint8_t j;
+
+	lane_deltas(delta, window, deltas, width);
 
-	v = veorq_u8(vrev64q_u8(npub_param), delta);
-	AES_ENCRYPT(v, aes_round_keys);
-	
     // this loop performs parallel processing of the authenticated data
-	while (len >= 3 * BLOCKSIZE)
+	while (len >= width * BLOCKSIZE)
 	{
-		delta1 = gf_mul2(delta3);
-		delta2 = gf_mul2(delta1);
-		delta3 = gf_mul2(delta2);
-
-		block1 = LOAD_BLOCK(in);
-		block2 = LOAD_BLOCK(in + BLOCKSIZE);
-		block3 = LOAD_BLOCK(in + (2 * BLOCKSIZE));
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			blocks[j] = XOR_BLOCK(LOAD_BLOCK(in + j * BLOCKSIZE), deltas[j]);
+		}
 
-		block1 = veorq_u8(block1, delta1);
-		block2 = veorq_u8(block2, delta2);
-		block3 = veorq_u8(block3, delta3);
+		AES_ENCRYPTN(blocks, width, aes_round_keys);
 
-		AES_ENCRYPT3(block1, block2, block3, aes_round_keys);
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			v = XOR_BLOCK(v, blocks[j]);
+		}
 
-		v = veorq_u8(v, block1);
-		v = veorq_u8(v, block2);
-		v = veorq_u8(v, block3);
+		delta = deltas[width - 1];
+		lane_deltas_next(deltas, width);
 
-		in += 3 * BLOCKSIZE;
-		len -= 3 * BLOCKSIZE;
+		in += width * BLOCKSIZE;
+		len -= width * BLOCKSIZE;
 	}
 
-	delta = delta3;
-
-    // take care of the remaining blocks of the authenticated data(if the authenticated data is not a multiple of 3 * BLOCKSIZE)
+    // take care of the remaining blocks of the authenticated data(if the authenticated data is not a multiple of width * BLOCKSIZE)
+	// (at max width - 1, their deltas are already prepared)
+	j = 0;
 	while (len >= BLOCKSIZE)
 	{
-		delta = gf_mul2(delta);
-		block = LOAD_BLOCK(in);
-		block = tmp = veorq_u8(block, delta);
-		AES_ENCRYPT(tmp, aes_round_keys);
-		v = veorq_u8(tmp, block);
+		delta = deltas[j++];
+		block = XOR_BLOCK(LOAD_BLOCK(in), delta);
+		AES_ENCRYPT(block, aes_round_keys);
+		v = XOR_BLOCK(v, block);
 		in += BLOCKSIZE;
 		len -= BLOCKSIZE;
 	}
@@ -115,111 +134,418 @@ uint8x16_t mac(uint8x16_t npub_param, uint8_t* associated_data, const uint64_t d
 		delta = gf_mul7(delta);
 		memcpy(buf, in, len);
 		buf[len] ^= 0x80; /* padding */
-		block = LOAD_BLOCK(buf);
-		block = tmp = veorq_u8(delta, block);
-		AES_ENCRYPT(tmp, aes_round_keys);
-		v = veorq_u8(tmp, block);
+		block = XOR_BLOCK(LOAD_BLOCK(buf), delta);
+		AES_ENCRYPT(block, aes_round_keys);
+		v = XOR_BLOCK(v, block);
 	}
 
 	return v;
 }
 
+// the first part of the colm cipher: calculate the "mac of the authenticated data"
+// delta is the initial delta of the MAC (3 * L). It only depends on the key and is therefore cached in the key context (window: its first multiples)
+PIPELINED block_t mac_with_delta(block_t npub_param, uint8_t* associated_data, const uint64_t data_len, block_t delta, const block_t* window, const block_t* aes_round_keys, const uint8_t width)
+{
+	block_t v = XOR_BLOCK(SWAP_BLOCK(npub_param), delta);
+	COLM_STATS_DECLARE;
 
+	COLM_STATS_START();
+	AES_ENCRYPT(v, aes_round_keys);
+	v = mac_blocks(v, delta, window, associated_data, data_len, aes_round_keys, width);
+	COLM_STATS_PHASE(COLM_PHASE_MAC, 1 + (data_len + BLOCKSIZE - 1) / BLOCKSIZE);
 
-/* ----------------------- COLM 0 ------------------------- */
+	return v;
+}
 
-int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8x16_t key, uint64_t* c_len, uint8_t* ciphertext)
+block_t mac(block_t npub_param, uint8_t* associated_data, const uint64_t data_len, block_t L, block_t* aes_round_keys)
 {
+	return mac_with_delta(npub_param, associated_data, data_len, gf_mul3(L), NULL, aes_round_keys, COLM_PIPELINE_WIDTH);
+}
 
-    // prepare initial variables
-	uint8x16_t checksum = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-	uint8x16_t w, w_tmp;
-	uint8x16_t block1, block2, block3, block;
-	uint8x16_t aes_round_keys[11];
-	uint8x16_t delta_m1, delta_m2, delta_m3, delta_m;
-	uint8x16_t delta_c1, delta_c2, delta_c3, delta_c;
-	uint8x16_t L = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-	
-    // the pointers are used to move dynamically through the in and output
-	const uint8_t* in = message;
-	uint8_t* out = ciphertext;
-	uint64_t remaining = message_len;
+static block_t mac_ctx_pipelined(const colm_key_ctx* ctx, block_t npub_param, uint8_t* associated_data, uint64_t data_len)
+{
+	CALL_WITH_PIPELINE_WIDTH(ctx->pipeline_width, mac_with_delta, npub_param, associated_data, data_len, ctx->delta_ad, ctx->delta_ad_window, ctx->aes_encryption_keys);
+}
+
+
+
+/* ----------------------- KEY CONTEXT ------------------------- */
+
+/*
+ * Everything that only depends on the key (AES round keys, L = E_K(0) and the deltas of the first blocks) is calculated once here.
+ * The context can then be used for any number of messages, so the per message cost is only the block processing.
+ */
+static int8_t key_ctx_init(colm_key_ctx* ctx, block_t key)
+{
+	block_t L = ZERO_BLOCK();
+	uint8_t i;
+
+	SET_ENCRPTION_KEYS(key, ctx->aes_encryption_keys);
+	SET_DECRPTION_KEYS(ctx->aes_encryption_keys, ctx->aes_decryption_keys);
+
+	AES_ENCRYPT(L, ctx->aes_encryption_keys);
+
+	ctx->L = L;
+	ctx->delta_ad = gf_mul3(L);
+	ctx->delta_c = gf_mul3(ctx->delta_ad);
+
+	// deltas of the first blocks, the pipelined loops take them from here instead of doubling them one after the other
+	ctx->delta_m_window[0] = gf_mul2(ctx->L);
+	ctx->delta_c_window[0] = gf_mul2(ctx->delta_c);
+	ctx->delta_ad_window[0] = gf_mul2(ctx->delta_ad);
+	for (i = 1; i < COLM_DELTA_WINDOW; i++)
+	{
+		ctx->delta_m_window[i] = gf_mul2(ctx->delta_m_window[i - 1]);
+		ctx->delta_c_window[i] = gf_mul2(ctx->delta_c_window[i - 1]);
+		ctx->delta_ad_window[i] = gf_mul2(ctx->delta_ad_window[i - 1]);
+	}
+
+	ctx->pipeline_width = COLM_PIPELINE_WIDTH;
+
+	return 0;
+}
+
+// select how many blocks the pipelined loops process at once (3, 4, 6 or 8)
+int8_t colm_key_ctx_set_pipeline_width(colm_key_ctx* ctx, uint8_t width)
+{
+	if (width != 3 && width != 4 && width != 6 && width != 8)
+	{
+		return -1;
+	}
+
+	ctx->pipeline_width = width;
+	return 0;
+}
+
+// wipe the key material (volatile, so the compiler can't drop the stores)
+void colm_key_ctx_free(colm_key_ctx* ctx)
+{
+	volatile uint8_t* p = (volatile uint8_t*)ctx;
+	size_t i;
+
+	for (i = 0; i < sizeof(colm_key_ctx); i++)
+	{
+		p[i] = 0;
+	}
+}
+
+
+
+/* ----------------------- SHORT MESSAGES ------------------------- */
+
+/*
+ * Messages of up to COLM_SHORT_BLOCKS blocks (the last one counts, an empty message has one).
+ * The first AES layer of all blocks, of the last block and of the tag only depends on the message (the last block and the tag on the
+ * checksum), so it is one batch. rho chains the lanes and the second layer is one more batch: two AES latencies instead of two per block
+ * and two for the tag. With with_mac the nonce and up to COLM_SHORT_AD_LEN bytes of associated data join the first batch and w is the
+ * xor of their lanes, so the whole encryption is two AES latencies.
+ * blocks and with_mac are constants, everything is unrolled (the AD lanes are always encrypted, the unused ones are ignored).
+ */
+PIPELINED int8_t colm0_encrypt_short_blocks(const colm_key_ctx* ctx, block_t w, block_t npub_param, const uint8_t* associated_data, uint64_t data_len, const uint8_t* message, uint64_t message_len, uint8_t* ciphertext, const uint8_t with_mac, const uint8_t blocks)
+{
+	const uint8_t last = blocks - 1; // lane of the last block, the tag is in the lane after it
+	const uint8_t nonce = blocks + 1; // with_mac: lane of the nonce, the associated data follows
+	block_t x[COLM_SHORT_BLOCKS + 2 + COLM_SHORT_AD_BLOCKS];
+	block_t checksum = ZERO_BLOCK();
+	block_t delta_m = last > 0 ? ctx->delta_m_window[last - 1] : ctx->L;
+	block_t delta_c = last > 0 ? ctx->delta_c_window[last - 1] : ctx->delta_c;
+	const block_t* aes_round_keys = ctx->aes_encryption_keys;
+	uint64_t remaining = message_len - last * BLOCKSIZE; // bytes of the last block (0 - 16)
 	uint8_t buf[BLOCKSIZE] = { 0 };
-	
-	*c_len = message_len + BLOCKSIZE;
-	
-    // as we use AES ECB as building block of colm we can prepare the roundkeys.
-	SET_ENCRPTION_KEYS(key, aes_round_keys);
-	
-	
-	AES_ENCRYPT(L, aes_round_keys);
+	uint8_t j;
+	COLM_STATS_DECLARE;
 
-    // calculate MAC of authenticatedcata
-	w = mac(vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(npub), ((uint64x1_t){0x0000800000000000}))), associated_data, data_len, L, aes_round_keys);
-	
-    // prepare more variables
-	delta_m3 = L;
-	delta_c3 = gf_mul3(gf_mul3(L));
+	COLM_STATS_START();
+	UNROLL_LANES
+	for (j = 0; j < last; j++)
+	{
+		x[j] = LOAD_BLOCK(message + j * BLOCKSIZE);
+		checksum = XOR_BLOCK(checksum, x[j]);
+		x[j] = XOR_BLOCK(x[j], ctx->delta_m_window[j]);
+	}
 
+	memcpy(buf, message + last * BLOCKSIZE, remaining);
+	delta_m = gf_mul7(delta_m);
+	delta_c = gf_mul7(delta_c);
+	if (remaining < BLOCKSIZE)
+	{
+		buf[remaining] = 0x80;
+		delta_m = gf_mul7(delta_m);
+		delta_c = gf_mul7(delta_c);
+	}
+	checksum = XOR_BLOCK(checksum, LOAD_BLOCK(buf));
+	x[last] = XOR_BLOCK(checksum, delta_m);
+	x[blocks] = XOR_BLOCK(checksum, gf_mul2(delta_m));
 
-    // this loop makes use of pipelining to parralelize the encryption process
-    // this upps the performance of the encryption up to (almost) three times
-	while(remaining > 3 * BLOCKSIZE)
+	if (with_mac)
 	{
-		delta_m1 = gf_mul2(delta_m3);
-		delta_m2 = gf_mul2(delta_m1);
-		delta_m3 = gf_mul2(delta_m2);
+		x[nonce] = XOR_BLOCK(SWAP_BLOCK(npub_param), ctx->delta_ad);
 
-		block1 = LOAD_BLOCK(in);
-		block2 = LOAD_BLOCK(in + BLOCKSIZE);
-		block3 = LOAD_BLOCK(in + (2 * BLOCKSIZE));
-		
-		checksum = veorq_u8(checksum, block1);
-		checksum = veorq_u8(checksum, block2);
-		checksum = veorq_u8(checksum, block3);
+		UNROLL_LANES
+		for (j = 0; j < COLM_SHORT_AD_BLOCKS; j++)
+		{
+			if (data_len >= (uint64_t)(j + 1) * BLOCKSIZE)
+			{
+				x[nonce + 1 + j] = XOR_BLOCK(LOAD_BLOCK(associated_data + j * BLOCKSIZE), ctx->delta_ad_window[j]);
+			}
+			else if (data_len > (uint64_t)j * BLOCKSIZE)
+			{
+				// last block partial
+				memset(buf, 0, BLOCKSIZE);
+				memcpy(buf, associated_data + j * BLOCKSIZE, data_len - j * BLOCKSIZE);
+				buf[data_len - j * BLOCKSIZE] = 0x80;
+				x[nonce + 1 + j] = XOR_BLOCK(LOAD_BLOCK(buf), gf_mul7(j > 0 ? ctx->delta_ad_window[j - 1] : ctx->delta_ad));
+			}
+			else
+			{
+				x[nonce + 1 + j] = ZERO_BLOCK();
+			}
+		}
+
+		AES_ENCRYPTN(x, blocks + 2 + COLM_SHORT_AD_BLOCKS, aes_round_keys);
+		COLM_STATS_BLOCKS(COLM_PHASE_MAC, 1 + (data_len + BLOCKSIZE - 1) / BLOCKSIZE);
 
-		block1 = veorq_u8(block1, delta_m1);
-		block2 = veorq_u8(block2, delta_m2);
-		block3 = veorq_u8(block3, delta_m3);
+		w = x[nonce];
+		UNROLL_LANES
+		for (j = 0; j < COLM_SHORT_AD_BLOCKS; j++)
+		{
+			if (data_len > (uint64_t)j * BLOCKSIZE)
+			{
+				w = XOR_BLOCK(w, x[nonce + 1 + j]);
+			}
+		}
+	}
+	else
+	{
+		AES_ENCRYPTN(x, blocks + 1, aes_round_keys);
+	}
+	COLM_STATS_PHASE(COLM_PHASE_LAYER1, blocks + 1);
 
-		AES_ENCRYPT3(block1, block2, block3, aes_round_keys);
+	rho_group(x, &w, blocks + 1);
+	COLM_STATS_PHASE(COLM_PHASE_RHO, blocks + 1);
 
-		delta_c1 = gf_mul2(delta_c3);
-		delta_c2 = gf_mul2(delta_c1);
-		delta_c3 = gf_mul2(delta_c2);
-		
-		RHO_INPLACE(block1, w, w_tmp);
-		RHO_INPLACE(block2, w, w_tmp);
-		RHO_INPLACE(block3, w, w_tmp);
+	AES_ENCRYPTN(x, blocks + 1, aes_round_keys);
 
-		AES_ENCRYPT3(block1, block2, block3, aes_round_keys);
-		
-		block1 = veorq_u8(block1, delta_c1);
-		block2 = veorq_u8(block2, delta_c2);
-		block3 = veorq_u8(block3, delta_c3);
+	UNROLL_LANES
+	for (j = 0; j < last; j++)
+	{
+		STORE_BLOCK(ciphertext + j * BLOCKSIZE, XOR_BLOCK(x[j], ctx->delta_c_window[j]));
+	}
+	STORE_BLOCK(ciphertext + last * BLOCKSIZE, XOR_BLOCK(x[last], delta_c));
+
+	// no tag after an empty last block
+	if (remaining > 0)
+	{
+		STORE_BLOCK(buf, XOR_BLOCK(x[blocks], gf_mul2(delta_c)));
+		memcpy(ciphertext + blocks * BLOCKSIZE, buf, remaining);
+	}
+	COLM_STATS_PHASE(COLM_PHASE_LAYER2, blocks + 1);
+
+	return 0;
+}
 
-		STORE_BLOCK(out, block1);
-		STORE_BLOCK(out + BLOCKSIZE, block2);
-		STORE_BLOCK(out + (2 * BLOCKSIZE), block3);
+/*
+ * Decryption of a short message: the two layers of all blocks are one batch each (rho^-1 has no doubling in the chain), only the tag
+ * needs the plaintext and is two more AES latencies. len is the length of the ciphertext (>= BLOCKSIZE), message == NULL => nothing is stored.
+ */
+PIPELINED int8_t colm0_decrypt_short_blocks(const colm_key_ctx* ctx, block_t w, const uint8_t* ciphertext, uint64_t len, uint8_t* message, const uint8_t blocks)
+{
+	const uint8_t last = blocks - 1;
+	block_t y[COLM_SHORT_BLOCKS];
+	block_t checksum = ZERO_BLOCK();
+	block_t w_tmp, block;
+	block_t delta_m = last > 0 ? ctx->delta_m_window[last - 1] : ctx->L;
+	block_t delta_c = last > 0 ? ctx->delta_c_window[last - 1] : ctx->delta_c;
+	const block_t* aes_encryption_keys = ctx->aes_encryption_keys;
+	const block_t* aes_decryption_keys = ctx->aes_decryption_keys;
+	uint64_t remaining = len - BLOCKSIZE - last * BLOCKSIZE;
+	uint8_t buf[BLOCKSIZE];
+	uint8_t j;
+	COLM_STATS_DECLARE;
+
+	COLM_STATS_START();
+	delta_m = gf_mul7(delta_m);
+	delta_c = gf_mul7(delta_c);
+	if (remaining < BLOCKSIZE)
+	{
+		delta_m = gf_mul7(delta_m);
+		delta_c = gf_mul7(delta_c);
+	}
 
-		in += 3 * BLOCKSIZE;
-		out += 3 * BLOCKSIZE;
-		remaining -= 3 * BLOCKSIZE;
+	UNROLL_LANES
+	for (j = 0; j < last; j++)
+	{
+		y[j] = XOR_BLOCK(LOAD_BLOCK(ciphertext + j * BLOCKSIZE), ctx->delta_c_window[j]);
 	}
+	y[last] = XOR_BLOCK(LOAD_BLOCK(ciphertext + last * BLOCKSIZE), delta_c);
 
-	delta_m = delta_m3;
-	delta_c = delta_c3;
+	AES_DECRYPTN(y, blocks, aes_decryption_keys);
+	COLM_STATS_PHASE(COLM_PHASE_LAYER1, blocks);
 
-    // finish up the remaining block (at max 2)
-	while (remaining > BLOCKSIZE)
+	UNROLL_LANES
+	for (j = 0; j < blocks; j++)
 	{
-		delta_m = gf_mul2(delta_m);
-		delta_c = gf_mul2(delta_c);
+		RHO_INVERSE_INPLACE(y[j], w, w_tmp);
+	}
+	COLM_STATS_PHASE(COLM_PHASE_RHO, blocks);
+
+	AES_DECRYPTN(y, blocks, aes_decryption_keys);
+
+	UNROLL_LANES
+	for (j = 0; j < last; j++)
+	{
+		y[j] = XOR_BLOCK(y[j], ctx->delta_m_window[j]);
+		checksum = XOR_BLOCK(checksum, y[j]);
+		if (message != NULL)
+		{
+			STORE_BLOCK(message + j * BLOCKSIZE, y[j]);
+		}
+	}
+	COLM_STATS_PHASE(COLM_PHASE_LAYER2, blocks);
+
+	// the last lane is the checksum of the whole message, the last (padded) plaintext block is its difference to the others
+	block = XOR_BLOCK(y[last], delta_m);
+	checksum = XOR_BLOCK(checksum, block);
+	STORE_BLOCK(buf, checksum);
+	if (message != NULL)
+	{
+		memcpy(message + last * BLOCKSIZE, buf, remaining);
+	}
+
+	block = XOR_BLOCK(block, gf_mul2(delta_m));
+	AES_ENCRYPT(block, aes_encryption_keys);
+	RHO_INPLACE(block, w, w_tmp);
+	AES_ENCRYPT(block, aes_encryption_keys);
+	block = XOR_BLOCK(block, gf_mul2(delta_c));
+
+	STORE_BLOCK(buf, block);
+	COLM_STATS_PHASE(COLM_PHASE_TAIL, 1);
+	if (memcmp(ciphertext + blocks * BLOCKSIZE, buf, remaining) != 0)
+	{
+		return -2;
+	}
+
+	if (remaining < BLOCKSIZE)
+	{
+		STORE_BLOCK(buf, checksum);
+		// check padding
+		if (buf[remaining] != 0x80)
+		{
+			return -3;
+		}
+		for (j = remaining + 1; j < BLOCKSIZE; j++)
+		{
+			if (buf[j] != 0)
+			{
+				return -4;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// blocks of a short message (the last one counts, an empty message has one)
+#define SHORT_BLOCKS(len) ((len) > BLOCKSIZE ? ((len) + BLOCKSIZE - 1) / BLOCKSIZE : 1)
+
+#define CALL_WITH_SHORT_BLOCKS(blocks, function, ...) do { \
+														switch (blocks) \
+														{ \
+															case 1: return function(__VA_ARGS__, 1); \
+															case 2: return function(__VA_ARGS__, 2); \
+															case 3: return function(__VA_ARGS__, 3); \
+															default: return function(__VA_ARGS__, 4); \
+														} \
+													} while (0)
+
+int8_t colm0_encrypt_short(const colm_key_ctx* ctx, block_t w, const uint8_t* message, uint64_t message_len, uint8_t* ciphertext)
+{
+	CALL_WITH_SHORT_BLOCKS(SHORT_BLOCKS(message_len), colm0_encrypt_short_blocks, ctx, w, ZERO_BLOCK(), NULL, 0, message, message_len, ciphertext, 0);
+}
+
+int8_t colm0_encrypt_mac_short(const colm_key_ctx* ctx, block_t npub_param, const uint8_t* associated_data, uint64_t data_len, const uint8_t* message, uint64_t message_len, uint8_t* ciphertext)
+{
+	CALL_WITH_SHORT_BLOCKS(SHORT_BLOCKS(message_len), colm0_encrypt_short_blocks, ctx, ZERO_BLOCK(), npub_param, associated_data, data_len, message, message_len, ciphertext, 1);
+}
+
+int8_t colm0_decrypt_short(const colm_key_ctx* ctx, block_t w, const uint8_t* ciphertext, uint64_t len, uint8_t* message)
+{
+	CALL_WITH_SHORT_BLOCKS(SHORT_BLOCKS(len - BLOCKSIZE), colm0_decrypt_short_blocks, ctx, w, ciphertext, len, message);
+}
+
+
+
+/* ----------------------- COLM 0 ------------------------- */
+
+/*
+ * The blocks before the last block of a message (no intermediate tags), st holds the chaining state before and after them.
+ * Used for whole messages and for the streaming API (colm_stream.c).
+ */
+PIPELINED void encrypt_blocks_pipelined(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, uint64_t full_blocks, const uint8_t width)
+{
+	block_t w = st->w, checksum = st->checksum, delta_m = st->delta_m, delta_c = st->delta_c;
+	block_t w_tmp;
+	block_t blocks[COLM_MAX_PIPELINE_WIDTH], block;
+	block_t deltas_m[COLM_MAX_PIPELINE_WIDTH], deltas_c[COLM_MAX_PIPELINE_WIDTH];
+	const block_t* aes_round_keys = ctx->aes_encryption_keys;
+	uint64_t remaining = full_blocks * BLOCKSIZE;
+	uint8_t j;
+	COLM_STATS_DECLARE;
+
+	lane_deltas(delta_m, DELTA_WINDOW(delta_m, ctx->L, ctx->delta_m_window), deltas_m, width);
+	lane_deltas(delta_c, DELTA_WINDOW(delta_c, ctx->delta_c, ctx->delta_c_window), deltas_c, width);
+
+    // this loop makes use of pipelining to parralelize the encryption process
+    // this upps the performance of the encryption up to (almost) width times
+	while(remaining >= width * BLOCKSIZE)
+	{
+		COLM_STATS_START();
+
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			blocks[j] = LOAD_BLOCK(in + j * BLOCKSIZE);
+			checksum = XOR_BLOCK(checksum, blocks[j]);
+			blocks[j] = XOR_BLOCK(blocks[j], deltas_m[j]);
+		}
+
+		AES_ENCRYPTN(blocks, width, aes_round_keys);
+		COLM_STATS_PHASE(COLM_PHASE_LAYER1, width);
+
+		rho_group(blocks, &w, width);
+		COLM_STATS_PHASE(COLM_PHASE_RHO, width);
+
+		AES_ENCRYPTN(blocks, width, aes_round_keys);
+
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			STORE_BLOCK(out + j * BLOCKSIZE, XOR_BLOCK(blocks[j], deltas_c[j]));
+		}
+		COLM_STATS_PHASE(COLM_PHASE_LAYER2, width);
+
+		delta_m = deltas_m[width - 1];
+		delta_c = deltas_c[width - 1];
+		lane_deltas_next(deltas_m, width);
+		lane_deltas_next(deltas_c, width);
+
+		in += width * BLOCKSIZE;
+		out += width * BLOCKSIZE;
+		remaining -= width * BLOCKSIZE;
+	}
+
+    // finish up the remaining blocks (at max width - 1, their deltas are already prepared)
+	COLM_STATS_START();
+	j = 0;
+	while (remaining > 0)
+	{
+		delta_m = deltas_m[j];
+		delta_c = deltas_c[j++];
 
 		block = LOAD_BLOCK(in);
-		checksum = veorq_u8(checksum, block);
+		checksum = XOR_BLOCK(checksum, block);
 		
-		block = veorq_u8(block, delta_m);
+		block = XOR_BLOCK(block, delta_m);
 
 		AES_ENCRYPT(block, aes_round_keys);
 
@@ -227,7 +553,7 @@ int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated
 
 		AES_ENCRYPT(block, aes_round_keys);
 
-		block = veorq_u8(block, delta_c);
+		block = XOR_BLOCK(block, delta_c);
 
 		STORE_BLOCK(out, block);
 
@@ -235,9 +561,150 @@ int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated
 		out += BLOCKSIZE;
 		remaining -= BLOCKSIZE;
 	}
+	COLM_STATS_PHASE(COLM_PHASE_TAIL, full_blocks % width);
+
+	st->w = w;
+	st->checksum = checksum;
+	st->delta_m = delta_m;
+	st->delta_c = delta_c;
+}
+
+static void encrypt_blocks_ctx_pipelined(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, uint64_t full_blocks)
+{
+	// like CALL_WITH_PIPELINE_WIDTH, without a return value
+	switch (ctx->pipeline_width)
+	{
+		case 4: encrypt_blocks_pipelined(ctx, st, in, out, full_blocks, 4); break;
+		case 6: encrypt_blocks_pipelined(ctx, st, in, out, full_blocks, 6); break;
+		case 8: encrypt_blocks_pipelined(ctx, st, in, out, full_blocks, 8); break;
+		default: encrypt_blocks_pipelined(ctx, st, in, out, full_blocks, 3); break;
+	}
+}
+
+PIPELINED void decrypt_blocks_pipelined(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, uint64_t full_blocks, const uint8_t width)
+{
+	block_t w = st->w, checksum = st->checksum, delta_m = st->delta_m, delta_c = st->delta_c;
+	block_t w_tmp;
+	block_t blocks[COLM_MAX_PIPELINE_WIDTH], block;
+	block_t deltas_m[COLM_MAX_PIPELINE_WIDTH], deltas_c[COLM_MAX_PIPELINE_WIDTH];
+	const block_t* aes_decryption_keys = ctx->aes_decryption_keys;
+	uint64_t remaining = full_blocks * BLOCKSIZE;
+	uint8_t j;
+	COLM_STATS_DECLARE;
+
+	lane_deltas(delta_m, DELTA_WINDOW(delta_m, ctx->L, ctx->delta_m_window), deltas_m, width);
+	lane_deltas(delta_c, DELTA_WINDOW(delta_c, ctx->delta_c, ctx->delta_c_window), deltas_c, width);
+
+    // this loop makes use of pipelining to parralelize the decryption process
+    // this upps the performance of the decryption up to (almost) width times
+	while (remaining >= width * BLOCKSIZE) {
+		COLM_STATS_START();
+
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			blocks[j] = XOR_BLOCK(LOAD_BLOCK(in + j * BLOCKSIZE), deltas_c[j]);
+		}
+
+		AES_DECRYPTN(blocks, width, aes_decryption_keys);
+		COLM_STATS_PHASE(COLM_PHASE_LAYER1, width);
+
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			RHO_INVERSE_INPLACE(blocks[j], w, w_tmp);
+		}
+		COLM_STATS_PHASE(COLM_PHASE_RHO, width);
+
+		AES_DECRYPTN(blocks, width, aes_decryption_keys);
+
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			blocks[j] = XOR_BLOCK(blocks[j], deltas_m[j]);
+			checksum = XOR_BLOCK(checksum, blocks[j]);
+		}
+
+		if (out != NULL)
+		{
+			UNROLL_LANES
+			for (j = 0; j < width; j++)
+			{
+				STORE_BLOCK(out + j * BLOCKSIZE, blocks[j]);
+			}
+			out += width * BLOCKSIZE;
+		}
+		COLM_STATS_PHASE(COLM_PHASE_LAYER2, width);
+
+		delta_m = deltas_m[width - 1];
+		delta_c = deltas_c[width - 1];
+		lane_deltas_next(deltas_m, width);
+		lane_deltas_next(deltas_c, width);
+
+		in += width * BLOCKSIZE;
+		remaining -= width * BLOCKSIZE;
+	}
+
+    // decrypt the remaining blocks (their deltas are already prepared)
+	COLM_STATS_START();
+	j = 0;
+	while (remaining > 0) {
+		delta_m = deltas_m[j];
+		delta_c = deltas_c[j++];
+
+		block = LOAD_BLOCK(in);
+		block = XOR_BLOCK(block, delta_c);
+
+		AES_DECRYPT(block, aes_decryption_keys);
+
+		/* (X,W') = rho^-1(block, W) */
+		RHO_INVERSE_INPLACE(block, w, w_tmp);
+
+		AES_DECRYPT(block, aes_decryption_keys);
+		block = XOR_BLOCK(block, delta_m);
+		
+		checksum = XOR_BLOCK(checksum, block);
+
+		if (out != NULL)
+		{
+			STORE_BLOCK(out, block);
+			out += BLOCKSIZE;
+		}
+
+		in += BLOCKSIZE;
+		remaining -= BLOCKSIZE;
+	}
+	COLM_STATS_PHASE(COLM_PHASE_TAIL, full_blocks % width);
+
+	st->w = w;
+	st->checksum = checksum;
+	st->delta_m = delta_m;
+	st->delta_c = delta_c;
+}
 
+static void decrypt_blocks_ctx_pipelined(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, uint64_t full_blocks)
+{
+	// like CALL_WITH_PIPELINE_WIDTH, without a return value
+	switch (ctx->pipeline_width)
+	{
+		case 4: decrypt_blocks_pipelined(ctx, st, in, out, full_blocks, 4); break;
+		case 6: decrypt_blocks_pipelined(ctx, st, in, out, full_blocks, 6); break;
+		case 8: decrypt_blocks_pipelined(ctx, st, in, out, full_blocks, 8); break;
+		default: decrypt_blocks_pipelined(ctx, st, in, out, full_blocks, 3); break;
+	}
+}
 
+// last block (remaining bytes of in, 0 - 16) and tag of COLM0, st holds the state after all blocks before it
+PIPELINED void colm0_encrypt_last(const colm_key_ctx* ctx, const colm_state* st, const uint8_t* in, uint64_t remaining, uint8_t* out)
+{
+	block_t w = st->w, checksum = st->checksum, delta_m = st->delta_m, delta_c = st->delta_c;
+	block_t w_tmp;
+	block_t block;
+	const block_t* aes_round_keys = ctx->aes_encryption_keys;
+	uint8_t buf[BLOCKSIZE] = { 0 };
+	COLM_STATS_DECLARE;
 
+	COLM_STATS_START();
 
 	// handdle remaining bytes
 	memcpy(buf, in, remaining);
@@ -254,9 +721,9 @@ int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated
 
 	block = LOAD_BLOCK(buf);
 
-	block = checksum = veorq_u8(checksum, block);
+	block = checksum = XOR_BLOCK(checksum, block);
 	
-	block = veorq_u8(block, delta_m);
+	block = XOR_BLOCK(block, delta_m);
 
 	AES_ENCRYPT(block, aes_round_keys);
 
@@ -264,148 +731,231 @@ int8_t colm0_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated
 
 	AES_ENCRYPT(block, aes_round_keys);
 
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 
 	STORE_BLOCK(out, block);
 
 	out += BLOCKSIZE;
+	COLM_STATS_PHASE(COLM_PHASE_TAIL, 1);
 	
 	// if remaining == 0
-	if (remaining == 0) return 0;
+	if (remaining == 0) return;
 
 	// add tag
 	delta_m = gf_mul2(delta_m);
 	delta_c = gf_mul2(delta_c);
 
-	block = veorq_u8(delta_m, checksum);
+	block = XOR_BLOCK(delta_m, checksum);
 	AES_ENCRYPT(block, aes_round_keys);
 
 	RHO_INPLACE(block, w, w_tmp);
 
 	AES_ENCRYPT(block, aes_round_keys);
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 
 	STORE_BLOCK((uint8_t*)buf, block);
 	memcpy(out, buf, remaining);
+	COLM_STATS_PHASE(COLM_PHASE_TAIL, 0);
+}
+
+PIPELINED int8_t colm0_encrypt_pipelined(const colm_key_ctx* ctx, block_t w, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext, const uint8_t width)
+{
+	uint64_t full_blocks = message_len > BLOCKSIZE ? (message_len - 1) / BLOCKSIZE : 0; // all blocks before the last one
+
+    // the roundkeys, L and the initial deltas have already been prepared in the key context, w (the MAC of the authenticated data) by the caller
+	colm_state st = { .w = w, .checksum = ZERO_BLOCK(), .delta_m = ctx->L, .delta_c = ctx->delta_c };
+	
+	*c_len = message_len + BLOCKSIZE;
+
+	if (message_len <= COLM_SHORT_LEN)
+	{
+		return colm0_encrypt_short(ctx, w, message, message_len, ciphertext);
+	}
+
+	encrypt_blocks_pipelined(ctx, &st, message, ciphertext, full_blocks, width);
+	colm0_encrypt_last(ctx, &st, message + full_blocks * BLOCKSIZE, message_len - full_blocks * BLOCKSIZE, ciphertext + full_blocks * BLOCKSIZE);
 
 	return 0;
 }
 
+static int8_t colm0_encrypt_ctx_pipelined(const colm_key_ctx* ctx, block_t w, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext)
+{
+	CALL_WITH_PIPELINE_WIDTH(ctx->pipeline_width, colm0_encrypt_pipelined, ctx, w, message, message_len, c_len, ciphertext);
+}
 
 /*
- * COLM 0 is an mode of operation of AES. It is an authenticated encryption scheme (like AES-GCM) with the advantage of nonce misuse resistance.
- * COLM 0 will output an tag at the end of an encryption (like AES-GCM)
+ * COLM0 encryption together with the MAC of the associated data.
+ * The first AES layer of a message block (E(M_i ^ delta_m)) does not need w, so while the MAC runs the first layer of the first
+ * message blocks runs as width more lanes of every MAC batch. The results are parked in the ciphertext, rho and the second layer
+ * finish them as soon as w is known. Long associated data then costs no extra pass before the message loop can start.
  */
-int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8x16_t key, uint64_t* m_len, uint8_t* message)
+PIPELINED int8_t colm0_encrypt_mac_pipelined(const colm_key_ctx* ctx, block_t npub_param, uint8_t* associated_data, uint64_t data_len, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext, const uint8_t width)
 {
-    // prepare initial variables
-	uint8x16_t checksum = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-	uint8x16_t w, w_tmp;
-	uint8x16_t block1, block2, block3, block;
-	uint8x16_t aes_encryption_keys[11];
-	uint8x16_t aes_decryption_keys[11];
-	uint8x16_t delta_m1, delta_m2, delta_m3, delta_m;
-	uint8x16_t delta_c1, delta_c2, delta_c3, delta_c;
-	uint8x16_t L = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+	block_t blocks[2 * COLM_MAX_PIPELINE_WIDTH];
+	block_t deltas[COLM_MAX_PIPELINE_WIDTH], deltas_m[COLM_MAX_PIPELINE_WIDTH], deltas_c[COLM_MAX_PIPELINE_WIDTH];
+	block_t v, delta = ctx->delta_ad;
+	const block_t* aes_round_keys = ctx->aes_encryption_keys;
+	const uint8_t* ad = associated_data;
+	const uint8_t* in = message;
+	uint8_t* out = ciphertext;
+	uint64_t full_blocks = message_len > BLOCKSIZE ? (message_len - 1) / BLOCKSIZE : 0; // all blocks before the last one
+	uint64_t groups = data_len / (width * BLOCKSIZE); // batches of width AD and width message blocks
+	uint64_t parked, i;
+	uint8_t j;
+	colm_state st = { .checksum = ZERO_BLOCK(), .delta_m = ctx->L, .delta_c = ctx->delta_c };
+	COLM_STATS_DECLARE;
 
-    // the pointers are used to move dynamically through the in and output
-	const uint8_t* in = ciphertext;
-	uint8_t* out = message;
-	uint64_t remaining = *m_len = len - BLOCKSIZE;
-	uint32_t i;
-	uint8_t buf[BLOCKSIZE] = { 0 }; 
-	
-	if (len < BLOCKSIZE)
+	*c_len = message_len + BLOCKSIZE;
+
+	if (message_len <= COLM_SHORT_LEN)
 	{
-		// -1 => invalid size of ciphertext
-		return -1;
+		if (data_len <= COLM_SHORT_AD_LEN)
+		{
+			return colm0_encrypt_mac_short(ctx, npub_param, associated_data, data_len, message, message_len, ciphertext);
+		}
+		return colm0_encrypt_short(ctx, mac_with_delta(npub_param, associated_data, data_len, ctx->delta_ad, ctx->delta_ad_window, aes_round_keys, width), message, message_len, ciphertext);
 	}
 
-    // we are decryption but we still need the encryption keys to calculate the MAC and to derive the decryption keys from them
-	SET_ENCRPTION_KEYS(key, aes_encryption_keys);
-	SET_DECRPTION_KEYS(aes_encryption_keys, aes_decryption_keys);
-	
-    // prepare more variables
-	AES_ENCRYPT(L, aes_encryption_keys);
-	delta_m3 = L;
-	delta_c3 = gf_mul3(gf_mul3(L));
+	if (groups > full_blocks / width)
+	{
+		groups = full_blocks / width;
+	}
+	parked = groups * width;
 
-    // calculate the MAX of the authenticated data
-	w = mac(vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(npub), ((uint64x1_t){0x0000800000000000}))), associated_data, data_len, L, aes_encryption_keys);
+	COLM_STATS_START();
+	v = XOR_BLOCK(SWAP_BLOCK(npub_param), delta);
+	AES_ENCRYPT(v, aes_round_keys);
 
-    // this loop makes use of pipelining to parralelize the decryption process
-    // this upps the performance of the decryption up to (almost) three times
-	while (remaining > 3 * BLOCKSIZE) {
-		delta_c1 = gf_mul2(delta_c3);
-		delta_c2 = gf_mul2(delta_c1);
-		delta_c3 = gf_mul2(delta_c2);
+	lane_deltas(delta, ctx->delta_ad_window, deltas, width);
+	lane_deltas(st.delta_m, ctx->delta_m_window, deltas_m, width);
+	lane_deltas(st.delta_c, ctx->delta_c_window, deltas_c, width);
+
+	// AD blocks in lanes 0 .. width - 1, the first layer of the message blocks in lanes width .. 2 * width - 1
+	for (i = 0; i < groups; i++)
+	{
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			blocks[j] = XOR_BLOCK(LOAD_BLOCK(ad + j * BLOCKSIZE), deltas[j]);
 
-		block1 = LOAD_BLOCK(in);
-		block2 = LOAD_BLOCK(in + BLOCKSIZE);
-		block3 = LOAD_BLOCK(in + (2 * BLOCKSIZE));
+			blocks[width + j] = LOAD_BLOCK(in + j * BLOCKSIZE);
+			st.checksum = XOR_BLOCK(st.checksum, blocks[width + j]);
+			blocks[width + j] = XOR_BLOCK(blocks[width + j], deltas_m[j]);
+		}
 
-		block1 = veorq_u8(block1, delta_c1);
-		block2 = veorq_u8(block2, delta_c2);
-		block3 = veorq_u8(block3, delta_c3);
+		AES_ENCRYPTN(blocks, 2 * width, aes_round_keys);
 
-		AES_DECRYPT3(block1, block2, block3, aes_decryption_keys);
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			v = XOR_BLOCK(v, blocks[j]);
+			STORE_BLOCK(out + j * BLOCKSIZE, blocks[width + j]);
+		}
+		COLM_STATS_BLOCKS(COLM_PHASE_LAYER1, width);
 
-		delta_m1 = gf_mul2(delta_m3);
-		delta_m2 = gf_mul2(delta_m1);
-		delta_m3 = gf_mul2(delta_m2);
+		delta = deltas[width - 1];
+		st.delta_m = deltas_m[width - 1];
+		lane_deltas_next(deltas, width);
+		lane_deltas_next(deltas_m, width);
 
-		RHO_INVERSE_INPLACE(block1, w, w_tmp);
-		RHO_INVERSE_INPLACE(block2, w, w_tmp);
-		RHO_INVERSE_INPLACE(block3, w, w_tmp);
+		ad += width * BLOCKSIZE;
+		in += width * BLOCKSIZE;
+		out += width * BLOCKSIZE;
+	}
 
+	st.w = mac_blocks(v, delta, groups == 0 ? ctx->delta_ad_window : NULL, ad, data_len - parked * BLOCKSIZE, aes_round_keys, width);
+	COLM_STATS_PHASE(COLM_PHASE_MAC, 1 + (data_len + BLOCKSIZE - 1) / BLOCKSIZE);
 
-		AES_DECRYPT3(block1, block2, block3, aes_decryption_keys);
+	// rho and second layer of the parked blocks
+	out = ciphertext;
+	for (i = 0; i < groups; i++)
+	{
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			blocks[j] = LOAD_BLOCK(out + j * BLOCKSIZE);
+		}
 
-		block1 = veorq_u8(block1, delta_m1);
-		block2 = veorq_u8(block2, delta_m2);
-		block3 = veorq_u8(block3, delta_m3);
-		
-		checksum = veorq_u8(checksum, block1);
-		checksum = veorq_u8(checksum, block2);
-		checksum = veorq_u8(checksum, block3);
-		
-		STORE_BLOCK(out, block1);
-		STORE_BLOCK(out + BLOCKSIZE, block2);
-		STORE_BLOCK(out + (2 * BLOCKSIZE), block3);
+		rho_group(blocks, &st.w, width);
+		COLM_STATS_PHASE(COLM_PHASE_RHO, width);
+
+		AES_ENCRYPTN(blocks, width, aes_round_keys);
+
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			STORE_BLOCK(out + j * BLOCKSIZE, XOR_BLOCK(blocks[j], deltas_c[j]));
+		}
+		COLM_STATS_PHASE(COLM_PHASE_LAYER2, width);
 
-		in += 3 * BLOCKSIZE;
-		out += 3 * BLOCKSIZE;
-		remaining -= 3 * BLOCKSIZE;
+		st.delta_c = deltas_c[width - 1];
+		lane_deltas_next(deltas_c, width);
+
+		out += width * BLOCKSIZE;
 	}
 
-	delta_m = delta_m3;
-	delta_c = delta_c3;
+	encrypt_blocks_pipelined(ctx, &st, in, out, full_blocks - parked, width);
+	in += (full_blocks - parked) * BLOCKSIZE;
+	out += (full_blocks - parked) * BLOCKSIZE;
+	colm0_encrypt_last(ctx, &st, in, message_len - full_blocks * BLOCKSIZE, out);
 
-    // decrypt the remaining blocks
-	while (remaining > BLOCKSIZE) {
-		delta_m = gf_mul2(delta_m);
-		delta_c = gf_mul2(delta_c);
+	return 0;
+}
 
-		block = LOAD_BLOCK(in);
-		block = veorq_u8(block, delta_c);
+static int8_t colm0_encrypt_mac_ctx_pipelined(const colm_key_ctx* ctx, block_t npub_param, uint8_t* associated_data, uint64_t data_len, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext)
+{
+	CALL_WITH_PIPELINE_WIDTH(ctx->pipeline_width, colm0_encrypt_mac_pipelined, ctx, npub_param, associated_data, data_len, message, message_len, c_len, ciphertext);
+}
 
-		AES_DECRYPT(block, aes_decryption_keys);
 
-		/* (X,W') = rho^-1(block, W) */
-		RHO_INVERSE_INPLACE(block, w, w_tmp);
 
-		AES_DECRYPT(block, aes_decryption_keys);
-		block = veorq_u8(block, delta_m);
-		
-		checksum = veorq_u8(checksum, block);
+/*
+ * COLM 0 is an mode of operation of AES. It is an authenticated encryption scheme (like AES-GCM) with the advantage of nonce misuse resistance.
+ * COLM 0 will output an tag at the end of an encryption (like AES-GCM)
+ */
+PIPELINED int8_t colm0_decrypt_pipelined(const colm_key_ctx* ctx, block_t w, uint8_t* ciphertext, uint64_t len, uint64_t* m_len, uint8_t* message, const uint8_t width)
+{
+    // prepare initial variables
+	block_t checksum;
+	block_t w_tmp;
+	block_t block;
+	const block_t* aes_encryption_keys = ctx->aes_encryption_keys;
+	const block_t* aes_decryption_keys = ctx->aes_decryption_keys;
+	block_t delta_m, delta_c;
+	colm_state st = { .w = w, .checksum = ZERO_BLOCK(), .delta_m = ctx->L, .delta_c = ctx->delta_c };
 
-		STORE_BLOCK(out, block);
+    // the pointers are used to move dynamically through the in and output
+	const uint8_t* in = ciphertext;
+	uint8_t* out = message;
+	uint64_t remaining = *m_len = len - BLOCKSIZE;
+	uint64_t full_blocks;
+	uint32_t i;
+	uint8_t buf[BLOCKSIZE] = { 0 }; 
+	COLM_STATS_DECLARE;
+	
+	if (len < BLOCKSIZE)
+	{
+		// -1 => invalid size of ciphertext
+		return -1;
+	}
 
-		in += BLOCKSIZE;
-		out += BLOCKSIZE;
-		remaining -= BLOCKSIZE;
+	if (remaining <= COLM_SHORT_LEN)
+	{
+		return colm0_decrypt_short(ctx, w, ciphertext, len, message);
 	}
 
+	// all blocks before the last one
+	full_blocks = remaining > BLOCKSIZE ? (remaining - 1) / BLOCKSIZE : 0;
+	decrypt_blocks_pipelined(ctx, &st, in, out, full_blocks, width);
+	in += full_blocks * BLOCKSIZE;
+	remaining -= full_blocks * BLOCKSIZE;
+	COLM_STATS_START();
+
+	w = st.w;
+	checksum = st.checksum;
+	delta_m = st.delta_m;
+	delta_c = st.delta_c;
+
 	// finish up the decryption
 
 	delta_m = gf_mul7(delta_m);
@@ -418,42 +968,46 @@ int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data
 	}
 
 	block = LOAD_BLOCK(in);
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 	AES_DECRYPT(block, aes_decryption_keys);
 
 	/* (X,W') = rho^-1(block, W) */
 	RHO_INVERSE_INPLACE(block, w, w_tmp);
 
 	AES_DECRYPT(block, aes_decryption_keys);
-	block = veorq_u8(block, delta_m);
+	block = XOR_BLOCK(block, delta_m);
 	/* block now contains M[l] = M[l+1] */
 	
-	checksum = veorq_u8(checksum, block);
+	checksum = XOR_BLOCK(checksum, block);
 	/* checksum now contains M*[l] */
 	in += BLOCKSIZE;
 	
 	/* output last (maybe partial) plaintext block */
 	
 	// I had to store the block instead of the checksum.
-	STORE_BLOCK(buf, checksum);
-	//STORE_BLOCK(buf, block);
-	memcpy(out, buf, remaining);
+	if (out != NULL)
+	{
+		STORE_BLOCK(buf, checksum);
+		//STORE_BLOCK(buf, block);
+		memcpy(out + full_blocks * BLOCKSIZE, buf, remaining);
+	}
 
 	/* work on M[l+1] */
 	delta_m = gf_mul2(delta_m);
 	delta_c = gf_mul2(delta_c);
 
-	block = veorq_u8(delta_m, block);
+	block = XOR_BLOCK(delta_m, block);
 	AES_ENCRYPT(block, aes_encryption_keys);
 	
 	/* (Y,W') = rho(block, W) */
 	RHO_INPLACE(block, w, w_tmp);
 
 	AES_ENCRYPT(block, aes_encryption_keys);
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 	/* block now contains C'[l+1] */
 
 	STORE_BLOCK(buf, block);
+	COLM_STATS_PHASE(COLM_PHASE_TAIL, 1);
 
     // this is an important part. We need to verify the TAG
 	if (memcmp(in, buf, remaining) != 0) {
@@ -477,30 +1031,34 @@ int8_t colm0_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data
 	return 0;	
 }
 
+static int8_t colm0_decrypt_ctx_pipelined(const colm_key_ctx* ctx, block_t w, uint8_t* ciphertext, uint64_t len, uint64_t* m_len, uint8_t* message)
+{
+	CALL_WITH_PIPELINE_WIDTH(ctx->pipeline_width, colm0_decrypt_pipelined, ctx, w, ciphertext, len, m_len, message);
+}
 
 
 
-
-/* ------------------ COLM 127 ------------------- */
+/* ------------------ COLM 127 / COLM TAU ------------------- */
 
 /*
  * COLM 127 is the same encryption algorithm as COLM 127 only a little bit instanciated.
  * COLM 127 will work exactly the same as COLM 0 with the difference that it will generate intermediate tags every 127. block.
+ * The functions below take the interval as parameter tau (1 - 65535, COLM 127 is tau = 127), tau is also part of the nonce block (COLM_TAU_PARAM).
  * In this implementation the intermediate tags will be outputted in a seperate array.
- * In a production implementation this should be changed so that the intermediate tags will be outputted after each 127 cipher text blocks within the same output array.
+ * colm_inband.c provides the format with the intermediate tags after each 127 cipher text blocks within the same output array (colm127_encrypt_inband).
+ * The size of the tag array is colm127_tags_len(message_len), *tag_len is increased by the bytes written.
  */
 
-int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8x16_t key, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags)
+PIPELINED int8_t colm_tau_encrypt_pipelined(const colm_key_ctx* ctx, block_t w, const uint16_t tau, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags, const uint8_t width)
 {
     // initialize variables
-	uint8x16_t checksum = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-	uint8x16_t w, w_tmp;
-	uint8x16_t block1, block2, block3, block;
-	uint8x16_t aes_round_keys[11];
-	uint8x16_t delta_m1, delta_m2, delta_m3, delta_m;
-	uint8x16_t delta_c1, delta_c2, delta_c3, delta_c;
-	uint8x16_t L = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-	uint8x16_t w_tag;
+	block_t checksum = ZERO_BLOCK();
+	block_t w_tmp;
+	block_t blocks[COLM_MAX_PIPELINE_WIDTH + 1], block; // + 1: lane of the intermediate tag
+	block_t deltas_m[COLM_MAX_PIPELINE_WIDTH], deltas_c[COLM_MAX_PIPELINE_WIDTH];
+	const block_t* aes_round_keys = ctx->aes_encryption_keys;
+	block_t delta_m, delta_c;
+	block_t w_tag, tag = ZERO_BLOCK(), delta_tag = ZERO_BLOCK(); // only used in the groups with an intermediate tag
 
     // a few pointers to dynamically move arrount in the in/ouput arrays
 	const uint8_t* in = message;
@@ -508,113 +1066,104 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 	uint8_t* tag_out = tags;
 	uint64_t remaining = message_len;
 	uint8_t buf[BLOCKSIZE] = { 0 };
-	uint64_t iteration_counter = 3;
+	uint64_t until_tag = tau; // blocks up to the next one that is followed by an intermediate tag (1 => the next block)
 	uint8_t itag = 0;
+	uint8_t j;
+	COLM_STATS_DECLARE;
 
 	*c_len = message_len + BLOCKSIZE;
-	SET_ENCRPTION_KEYS(key, aes_round_keys);
-	
 
-	AES_ENCRYPT(L, aes_round_keys);
-	delta_m3 = L;
-	delta_c3 = gf_mul3(gf_mul3(L));
-	
-    // calculate MAC of authenticated data
-	w = mac(vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(npub), ((uint64x1_t){0x007F800000000000}))), associated_data, data_len, L, aes_round_keys);
-	
+	// no intermediate tag (the last block counts)
+	if (message_len <= COLM_SHORT_LEN && SHORT_BLOCKS(message_len) < tau)
+	{
+		return colm0_encrypt_short(ctx, w, message, message_len, ciphertext);
+	}
+
+	delta_m = ctx->L;
+	delta_c = ctx->delta_c;
+	lane_deltas(delta_m, ctx->delta_m_window, deltas_m, width);
+	lane_deltas(delta_c, ctx->delta_c_window, deltas_c, width);
+
 
     // parallel encryption of main blocks
-	while(remaining > 3 * BLOCKSIZE)
+	// (at most one tag per iteration, shorter intervals only use the loop below)
+	while (tau >= width && remaining > width * BLOCKSIZE)
 	{
-		itag = iteration_counter % 127;
+		// lane after which the intermediate tag has to be calculated (no tag in this iteration if itag >= width)
+		itag = until_tag <= width ? (uint8_t)(until_tag - 1) : width;
+		COLM_STATS_START();
 
-		delta_c1 = gf_mul2(delta_c3);
-		delta_c2 = gf_mul2(delta_c1);
-		delta_c3 = gf_mul2(delta_c2);
-	
-		delta_m1 = gf_mul2(delta_m3);
-		delta_m2 = gf_mul2(delta_m1);
-		delta_m3 = gf_mul2(delta_m2);
-		
-		block1 = LOAD_BLOCK(in);
-		block2 = LOAD_BLOCK(in + BLOCKSIZE);
-		block3 = LOAD_BLOCK(in + (2 * BLOCKSIZE));
-		
-		checksum = veorq_u8(checksum, block1);
-		checksum = veorq_u8(checksum, block2);
-		checksum = veorq_u8(checksum, block3);;
-
-		block1 = veorq_u8(block1, delta_m1);
-		block2 = veorq_u8(block2, delta_m2);
-		block3 = veorq_u8(block3, delta_m3);
-
-		AES_ENCRYPT3(block1, block2, block3, aes_round_keys);
-
-		RHO_INPLACE(block1, w, w_tmp); if (itag == 2) w_tag = w;
-		RHO_INPLACE(block2, w, w_tmp); if (itag == 1) w_tag = w;
-		RHO_INPLACE(block3, w, w_tmp); if (itag == 0) w_tag = w;
-
-		// calculate intermediate tag depending on the remaining blocks till the tag
-		switch (itag)
-		{
-			case 2: // tag "after" block1
-				delta_c1 = delta_c2;
-				delta_c = delta_c2;
-				delta_c2 = delta_c3;
-				delta_c3 = gf_mul2(delta_c3);
-				break;
-			case 1: // tag "after" block2
-				delta_c2 = delta_c3;
-				delta_c = delta_c3;
-				delta_c3 = gf_mul2(delta_c3);
-				break;
-			case 0: // tag "after" block3
-				delta_c3 = gf_mul2(delta_c3);
-				delta_c = delta_c3;
-				break;
-			default:
-				break;
-		}
-
-		if (itag <= 2)
-		{	
-			uint8x16_t tag = w_tag;
-			AES_ENCRYPT(tag, aes_round_keys);
-			tag = veorq_u8(tag, delta_c);
-			STORE_BLOCK(tag_out, tag);
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			blocks[j] = LOAD_BLOCK(in + j * BLOCKSIZE);
+			checksum = XOR_BLOCK(checksum, blocks[j]);
+			blocks[j] = XOR_BLOCK(blocks[j], deltas_m[j]);
+		}
+
+		AES_ENCRYPTN(blocks, width, aes_round_keys);
+		COLM_STATS_PHASE(COLM_PHASE_LAYER1, width);
+
+		w_tag = w;
+		rho_group(blocks, &w, width);
+		COLM_STATS_PHASE(COLM_PHASE_RHO, width);
+
+		// calculate intermediate tag, as one more lane of the second AES layer (on its own it would stall the pipeline)
+		if (itag < width)
+		{
+			blocks[width] = rho_state_after(w_tag, blocks, itag);
+			AES_ENCRYPTN(blocks, width + 1, aes_round_keys);
+			tag = blocks[width];
+		}
+		else
+		{
+			AES_ENCRYPTN(blocks, width, aes_round_keys);
+		}
+
+		// the tag "after" block itag shares its (once more doubled) delta_c with it
+		if (itag < width)
+		{
+			delta_tag = lane_deltas_tag(deltas_c, itag, width);
+			STORE_BLOCK(tag_out, XOR_BLOCK(tag, delta_tag));
 			tag_out += BLOCKSIZE;
 			*tag_len += BLOCKSIZE;
 		}
 
-		AES_ENCRYPT3(block1, block2, block3, aes_round_keys);
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			STORE_BLOCK(out + j * BLOCKSIZE, XOR_BLOCK(blocks[j], deltas_c[j]));
+		}
+		COLM_STATS_PHASE(COLM_PHASE_LAYER2, width);
 
-		block1 = veorq_u8(block1, delta_c1);
-		block2 = veorq_u8(block2, delta_c2);
-		block3 = veorq_u8(block3, delta_c3);
+		if (itag < width)
+		{
+			lane_deltas_tag_done(deltas_c, itag, width);
+		}
 
-		STORE_BLOCK(out, block1);
-		STORE_BLOCK(out + BLOCKSIZE, block2);
-		STORE_BLOCK(out + (2 * BLOCKSIZE), block3);
+		delta_m = deltas_m[width - 1];
+		delta_c = deltas_c[width - 1];
+		lane_deltas_next(deltas_m, width);
+		lane_deltas_next(deltas_c, width);
 
-		in += 3 * BLOCKSIZE;
-		out += 3 * BLOCKSIZE;
-		remaining -= 3 * BLOCKSIZE;
-		iteration_counter += 3;
+		in += width * BLOCKSIZE;
+		out += width * BLOCKSIZE;
+		remaining -= width * BLOCKSIZE;
+		until_tag = itag < width ? until_tag + tau - width : until_tag - width;
 	}
 
-	delta_m = delta_m3;
-	delta_c = delta_c3;
-
     // finish up the remaining blocks
+	COLM_STATS_START();
+	COLM_STATS_BLOCKS(COLM_PHASE_TAIL, SHORT_BLOCKS(remaining));
 	while(remaining > BLOCKSIZE)
 	{
 		delta_m = gf_mul2(delta_m);
 		
 		block = LOAD_BLOCK(in);
 		
-		checksum = veorq_u8(checksum, block);
+		checksum = XOR_BLOCK(checksum, block);
 		
-		block = veorq_u8(block, delta_m);
+		block = XOR_BLOCK(block, delta_m);
 
 		AES_ENCRYPT(block, aes_round_keys);
 
@@ -622,28 +1171,32 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 
 		RHO_INPLACE(block, w, w_tmp);
 		
-		// calculate Tag
-		if (iteration_counter % 127 == 0)
+		// calculate Tag (together with the block)
+		if (until_tag == 1)
 		{
 			delta_c = gf_mul2(delta_c);
-			uint8x16_t tag = w;
-			AES_ENCRYPT(tag, aes_round_keys);
-			tag = veorq_u8(tag, delta_c);
+			blocks[0] = block;
+			blocks[1] = w;
+			AES_ENCRYPTN(blocks, 2, aes_round_keys);
+			block = blocks[0];
+			tag = XOR_BLOCK(blocks[1], delta_c);
 			STORE_BLOCK(tag_out, tag);
 			tag_out += BLOCKSIZE;
 			*tag_len += BLOCKSIZE;
 		}
-
-		AES_ENCRYPT(block, aes_round_keys);
+		else
+		{
+			AES_ENCRYPT(block, aes_round_keys);
+		}
 		
-		block = veorq_u8(block, delta_c);
+		block = XOR_BLOCK(block, delta_c);
 
 		STORE_BLOCK(out, block);
 
 		in += BLOCKSIZE;
 		out += BLOCKSIZE;
 		remaining -= BLOCKSIZE;
-		iteration_counter++;
+		until_tag = until_tag == 1 ? tau : until_tag - 1;
 	}
 
 	// handle remaining bytes
@@ -661,9 +1214,9 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 
 	block = LOAD_BLOCK(buf);//vld1q_u8(buf);
 
-	block = checksum = veorq_u8(checksum, block);
+	block = checksum = XOR_BLOCK(checksum, block);
 	
-	block = veorq_u8(block, delta_m);
+	block = XOR_BLOCK(block, delta_m);
 
 	AES_ENCRYPT(block, aes_round_keys);
 
@@ -671,24 +1224,26 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 
 	AES_ENCRYPT(block, aes_round_keys);
 
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 
 	STORE_BLOCK(out, block);
 
 	out += BLOCKSIZE;
 	
 	// calculate Tag
-	if (iteration_counter % 127 == 0)
+	if (until_tag == 1)
 	{
 		delta_c = gf_mul2(delta_c);
-		uint8x16_t tag = w;
+		tag = w;
 		AES_ENCRYPT(tag, aes_round_keys);
-		tag = veorq_u8(tag, delta_c);
+		tag = XOR_BLOCK(tag, delta_c);
 		STORE_BLOCK(tag_out, tag);
 		tag_out += BLOCKSIZE;
 		*tag_len += BLOCKSIZE;
 	}
 
+	COLM_STATS_PHASE(COLM_PHASE_TAIL, 0);
+
 	// if remaining == 0
 	if (remaining == 0) return 0;
 
@@ -696,32 +1251,38 @@ int8_t colm127_encrypt(uint8_t* message, uint64_t message_len, uint8_t* associat
 	delta_m = gf_mul2(delta_m);
 	delta_c = gf_mul2(delta_c);
 
-	block = veorq_u8(delta_m, checksum);
+	block = XOR_BLOCK(delta_m, checksum);
 	AES_ENCRYPT(block, aes_round_keys);
 
 	RHO_INPLACE(block, w, w_tmp);
 
 	AES_ENCRYPT(block, aes_round_keys);
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 
 	STORE_BLOCK((uint8_t*)buf, block);
 	memcpy(out, buf, remaining);
+	COLM_STATS_PHASE(COLM_PHASE_TAIL, 1);
 
 	return 0;
 }
 
-int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8x16_t key, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message)
+static int8_t colm_tau_encrypt_ctx_pipelined(const colm_key_ctx* ctx, block_t w, uint16_t tau, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags)
+{
+	CALL_WITH_PIPELINE_WIDTH(ctx->pipeline_width, colm_tau_encrypt_pipelined, ctx, w, tau, message, message_len, c_len, ciphertext, tag_len, tags);
+}
+
+
+PIPELINED int8_t colm_tau_decrypt_pipelined(const colm_key_ctx* ctx, block_t w, const uint16_t tau, uint8_t* ciphertext, uint64_t len, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message, const uint8_t width)
 {
     // prepare variables
-	uint8x16_t checksum = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-	uint8x16_t w, w_tmp;
-	uint8x16_t block1, block2, block3, block;
-	uint8x16_t aes_encryption_keys[11];
-	uint8x16_t aes_decryption_keys[11];
-	uint8x16_t delta_m1, delta_m2, delta_m3, delta_m;
-	uint8x16_t delta_c1, delta_c2, delta_c3, delta_c;
-	uint8x16_t L = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-	uint8x16_t w_tag;
+	block_t checksum = ZERO_BLOCK();
+	block_t w_tmp;
+	block_t blocks[COLM_MAX_PIPELINE_WIDTH + 1], block; // + 1: lane of the intermediate tag
+	block_t deltas_m[COLM_MAX_PIPELINE_WIDTH], deltas_c[COLM_MAX_PIPELINE_WIDTH];
+	const block_t* aes_encryption_keys = ctx->aes_encryption_keys;
+	const block_t* aes_decryption_keys = ctx->aes_decryption_keys;
+	block_t delta_m, delta_c;
+	block_t w_tag = ZERO_BLOCK(), delta_tag = ZERO_BLOCK(); // only used in the groups with an intermediate tag
 	
     // pointers to reference in/output data
 	const uint8_t* in = ciphertext;
@@ -730,8 +1291,10 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 	uint64_t remaining = *m_len = len - BLOCKSIZE;
 	uint32_t i;
 	uint8_t buf[BLOCKSIZE] = { 0 };
-	uint64_t iteration_counter = 3;
+	uint64_t until_tag = tau; // blocks up to the next one that is followed by an intermediate tag (1 => the next block)
 	uint8_t itag;
+	uint8_t j;
+	COLM_STATS_DECLARE;
 
 	if (len < BLOCKSIZE)
 	{
@@ -739,142 +1302,165 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 		return -1;
 	}
 
-    // generate encryption keys used to calculate the MAC and to derive the decryption keys
-	SET_ENCRPTION_KEYS(key, aes_encryption_keys);
-	SET_DECRPTION_KEYS(aes_encryption_keys, aes_decryption_keys);
-	
-	AES_ENCRYPT(L, aes_encryption_keys);
-	delta_m3 = L;
-	delta_c3 = gf_mul3(gf_mul3(L));
+	// -1 => not all intermediate tags there (one after every tau blocks, the last block counts)
+	if (tag_len / BLOCKSIZE < ((remaining > 0 ? (remaining - 1) / BLOCKSIZE : 0) + 1) / tau)
+	{
+		return -1;
+	}
 
-    // calculate MAC
-	w = mac(vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(npub), ((uint64x1_t){0x007F800000000000}))), associated_data, data_len, L, aes_encryption_keys);
+	if (remaining <= COLM_SHORT_LEN && SHORT_BLOCKS(remaining) < tau)
+	{
+		return colm0_decrypt_short(ctx, w, ciphertext, len, message);
+	}
+
+	delta_m = ctx->L;
+	delta_c = ctx->delta_c;
+	lane_deltas(delta_m, ctx->delta_m_window, deltas_m, width);
+	lane_deltas(delta_c, ctx->delta_c_window, deltas_c, width);
 
     // main decryption loop (in parallel)
-	while (remaining > 3 * BLOCKSIZE) {
-		itag = iteration_counter % 127;
-
-		delta_c1 = gf_mul2(delta_c3);
-		delta_c2 = gf_mul2(delta_c1);
-		delta_c3 = gf_mul2(delta_c2);
-
-		delta_m1 = gf_mul2(delta_m3);
-		delta_m2 = gf_mul2(delta_m1);
-		delta_m3 = gf_mul2(delta_m2);
-
-		block1 = LOAD_BLOCK(in);
-		block2 = LOAD_BLOCK(in + BLOCKSIZE);
-		block3 = LOAD_BLOCK(in + (2 * BLOCKSIZE));
-
-        // process the intermediate tag
-		switch (itag)
-		{
-			case 2: // tag "after" block1
-				delta_c1 = delta_c2;
-				delta_c = delta_c2;
-				delta_c2 = delta_c3;
-				delta_c3 = gf_mul2(delta_c3);
-				break;
-			case 1: // tag "after" block2
-				delta_c2 = delta_c3;
-				delta_c = delta_c3;
-				delta_c3 = gf_mul2(delta_c3);
-				break;
-			case 0: // tag "after" block3
-				delta_c3 = gf_mul2(delta_c3);
-				delta_c = delta_c3;
-				break;
-			default:
-				break;
-		}
-
-
-		block1 = veorq_u8(block1, delta_c1);
-		block2 = veorq_u8(block2, delta_c2);
-		block3 = veorq_u8(block3, delta_c3);
-
-		AES_DECRYPT3(block1, block2, block3, aes_decryption_keys);
-
-		RHO_INVERSE_INPLACE(block1, w, w_tmp); if (itag == 2) w_tag = w;
-		RHO_INVERSE_INPLACE(block2, w, w_tmp); if (itag == 1) w_tag = w;
-		RHO_INVERSE_INPLACE(block3, w, w_tmp); if (itag == 0) w_tag = w;
+	// (at most one tag per iteration, shorter intervals only use the loop below)
+	while (tau >= width && remaining > width * BLOCKSIZE) {
+		// lane after which the intermediate tag has to be verified (no tag in this iteration if itag >= width)
+		itag = until_tag <= width ? (uint8_t)(until_tag - 1) : width;
+		COLM_STATS_START();
+
+		// the tag "after" block itag shares its (once more doubled) delta_c with it
+		if (itag < width)
+		{
+			delta_tag = lane_deltas_tag(deltas_c, itag, width);
+		}
+
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			blocks[j] = XOR_BLOCK(LOAD_BLOCK(in + j * BLOCKSIZE), deltas_c[j]);
+		}
+
+		// the intermediate tag only depends on its delta_c, so it is decrypted as one more lane of the first AES layer
+		if (itag < width)
+		{
+			blocks[width] = XOR_BLOCK(LOAD_BLOCK(tag_in), delta_tag);
+			AES_DECRYPTN(blocks, width + 1, aes_decryption_keys);
+		}
+		else
+		{
+			// no tag in this group, the lane is not compared
+			blocks[width] = ZERO_BLOCK();
+			AES_DECRYPTN(blocks, width, aes_decryption_keys);
+		}
+		COLM_STATS_PHASE(COLM_PHASE_LAYER1, width);
+
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			RHO_INVERSE_INPLACE(blocks[j], w, w_tmp);
+			if (j == itag) w_tag = w;
+		}
 
 		// verify intermediate tag
-		if (itag <= 2)
+		if (itag < width)
 		{
-			uint8x16_t tag = LOAD_BLOCK(tag_in);
-			tag = veorq_u8(tag, delta_c);
-			AES_DECRYPT(tag, aes_decryption_keys);
-			if (!EQUALS(tag, w_tag))
+			if (!EQUALS(blocks[width], w_tag))
 			{
 				return -5;
 			}
 			tag_in += BLOCKSIZE;
 		}
+		COLM_STATS_PHASE(COLM_PHASE_RHO, width);
 
-		AES_DECRYPT3(block1, block2, block3, aes_decryption_keys);
+		AES_DECRYPTN(blocks, width, aes_decryption_keys);
 
-		block1 = veorq_u8(block1, delta_m1);
-		block2 = veorq_u8(block2, delta_m2);
-		block3 = veorq_u8(block3, delta_m3);
+		UNROLL_LANES
+		for (j = 0; j < width; j++)
+		{
+			blocks[j] = XOR_BLOCK(blocks[j], deltas_m[j]);
+			checksum = XOR_BLOCK(checksum, blocks[j]);
+		}
 
-		checksum = veorq_u8(checksum, block1);
-		checksum = veorq_u8(checksum, block2);
-		checksum = veorq_u8(checksum, block3);
-		
-		STORE_BLOCK(out, block1);
-		STORE_BLOCK(out + BLOCKSIZE, block2);
-		STORE_BLOCK(out + (2 * BLOCKSIZE), block3);
+		if (out != NULL)
+		{
+			UNROLL_LANES
+			for (j = 0; j < width; j++)
+			{
+				STORE_BLOCK(out + j * BLOCKSIZE, blocks[j]);
+			}
+			out += width * BLOCKSIZE;
+		}
+		COLM_STATS_PHASE(COLM_PHASE_LAYER2, width);
 
-		in += 3 * BLOCKSIZE;
-		out += 3 * BLOCKSIZE;
-		remaining -= 3 * BLOCKSIZE;
-		iteration_counter += 3;
-	}
+		if (itag < width)
+		{
+			lane_deltas_tag_done(deltas_c, itag, width);
+		}
 
+		delta_m = deltas_m[width - 1];
+		delta_c = deltas_c[width - 1];
+		lane_deltas_next(deltas_m, width);
+		lane_deltas_next(deltas_c, width);
 
-	delta_m = delta_m3;
-	delta_c = delta_c3;
+		in += width * BLOCKSIZE;
+		remaining -= width * BLOCKSIZE;
+		until_tag = itag < width ? until_tag + tau - width : until_tag - width;
+	}
 
-    // decrypt remaining blocks (at max 2)
+    // decrypt remaining blocks (at max width - 1)
+	COLM_STATS_START();
+	COLM_STATS_BLOCKS(COLM_PHASE_TAIL, SHORT_BLOCKS(remaining));
 	while (remaining > BLOCKSIZE) {
 		delta_c = gf_mul2(delta_c);
 		delta_m = gf_mul2(delta_m);
 
-		// verify tag
+		// the block before an intermediate tag shares the tags delta_c
+		if (until_tag == 1)
+		{
+			delta_c = gf_mul2(delta_c);
+		}
+
 		block = LOAD_BLOCK(in);
 
-		block = veorq_u8(block, delta_c);
+		block = XOR_BLOCK(block, delta_c);
 
-		AES_DECRYPT(block, aes_decryption_keys);
+		// the tag is decrypted together with the block
+		if (until_tag == 1)
+		{
+			blocks[0] = block;
+			blocks[1] = XOR_BLOCK(LOAD_BLOCK(tag_in), delta_c);
+			AES_DECRYPTN(blocks, 2, aes_decryption_keys);
+			block = blocks[0];
+		}
+		else
+		{
+			AES_DECRYPT(block, aes_decryption_keys);
+		}
+
+		RHO_INVERSE_INPLACE(block, w, w_tmp);
 
-		if (iteration_counter % 127 == 0)
+		// verify tag
+		if (until_tag == 1)
 		{		
-			delta_c = gf_mul2(delta_c);
-			uint8x16_t tag = LOAD_BLOCK(tag_in);
-			tag = veorq_u8(tag, delta_c);
-			AES_DECRYPT(tag, aes_decryption_keys);
-			if (!EQUALS(tag, w))
+			if (!EQUALS(blocks[1], w))
 			{
 				return -5;
 			}
 			tag_in += BLOCKSIZE;
 		}
-
-		RHO_INVERSE_INPLACE(block, w, w_tmp);
 		
 		AES_DECRYPT(block, aes_decryption_keys);
 		
-		block = veorq_u8(block, delta_m);
+		block = XOR_BLOCK(block, delta_m);
 		
-		checksum = veorq_u8(checksum, block);
+		checksum = XOR_BLOCK(checksum, block);
 		
-		STORE_BLOCK(out, block);
+		if (out != NULL)
+		{
+			STORE_BLOCK(out, block);
+			out += BLOCKSIZE;
+		}
 
 		in += BLOCKSIZE;
-		out += BLOCKSIZE;
 		remaining -= BLOCKSIZE;
-		iteration_counter++;
+		until_tag = until_tag == 1 ? tau : until_tag - 1;
 	}
 
     // decrypt the last few bytes
@@ -889,31 +1475,33 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 	}
 
 	block = LOAD_BLOCK(in);
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 	AES_DECRYPT(block, aes_decryption_keys);
 
 	/* (X,W') = rho^-1(block, W) */
 	RHO_INVERSE_INPLACE(block, w, w_tmp);
 
 	AES_DECRYPT(block, aes_decryption_keys);
-	block = veorq_u8(block, delta_m);
+	block = XOR_BLOCK(block, delta_m);
 	/* block now contains M[l] = M[l+1] */
 	
-	checksum = veorq_u8(checksum, block);
+	checksum = XOR_BLOCK(checksum, block);
 	/* checksum now contains M*[l] */
 	in += BLOCKSIZE;
 	
 	/* output last (maybe partial) plaintext block */
 	
-	STORE_BLOCK(buf, checksum);
-	
-	memcpy(out, buf, remaining);
+	if (out != NULL)
+	{
+		STORE_BLOCK(buf, checksum);
+		memcpy(out, buf, remaining);
+	}
 
-	if (iteration_counter % 127 == 0)
+	if (until_tag == 1)
 	{		
 		delta_c = gf_mul2(delta_c);
-		uint8x16_t tag = LOAD_BLOCK(tag_in);
-		tag = veorq_u8(tag, delta_c);
+		block_t tag = LOAD_BLOCK(tag_in);
+		tag = XOR_BLOCK(tag, delta_c);
 		AES_DECRYPT(tag, aes_decryption_keys);
 		if (!EQUALS(tag, w))
 		{
@@ -926,19 +1514,20 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 	delta_m = gf_mul2(delta_m);
 	delta_c = gf_mul2(delta_c);
 
-	block = veorq_u8(delta_m, block);
+	block = XOR_BLOCK(delta_m, block);
 	AES_ENCRYPT(block, aes_encryption_keys);
 	
 	/* (Y,W') = rho(block, W) */
 	RHO_INPLACE(block, w, w_tmp);
 
 	AES_ENCRYPT(block, aes_encryption_keys);
-	block = veorq_u8(block, delta_c);
+	block = XOR_BLOCK(block, delta_c);
 	/* block now contains C'[l+1] */
 
 
     // verify end tag (same as colm 0)
 	STORE_BLOCK(buf, block);
+	COLM_STATS_PHASE(COLM_PHASE_TAIL, 1);
 	if (memcmp(in, buf, remaining) != 0) {
 		return -2;
 	}
@@ -960,3 +1549,28 @@ int8_t colm127_decrypt(uint8_t* ciphertext, uint64_t len, uint8_t* associated_da
 
 	return 0;
 }
+
+static int8_t colm_tau_decrypt_ctx_pipelined(const colm_key_ctx* ctx, block_t w, uint16_t tau, uint8_t* ciphertext, uint64_t len, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message)
+{
+	CALL_WITH_PIPELINE_WIDTH(ctx->pipeline_width, colm_tau_decrypt_pipelined, ctx, w, tau, ciphertext, len, tag_len, tags, m_len, message);
+}
+
+
+
+/* ----------------------- BACKEND ------------------------- */
+
+// selected by colm_dispatch.c if the CPU has the AES instructions
+const colm_backend colm_backend_pipelined = {
+	.name = AES_BACKEND_NAME,
+	.key_ctx_init = key_ctx_init,
+	.mac = mac_ctx_pipelined,
+	.colm0_encrypt = colm0_encrypt_ctx_pipelined,
+	.colm0_encrypt_mac = colm0_encrypt_mac_ctx_pipelined,
+	.colm0_decrypt = colm0_decrypt_ctx_pipelined,
+	.colm_tau_encrypt = colm_tau_encrypt_ctx_pipelined,
+	.colm_tau_decrypt = colm_tau_decrypt_ctx_pipelined,
+	.encrypt_blocks = encrypt_blocks_ctx_pipelined,
+	.decrypt_blocks = decrypt_blocks_ctx_pipelined,
+};
+
+AES_TARGET_END
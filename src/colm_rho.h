@@ -0,0 +1,102 @@
+/*
+ * Rho of the encryption over the blocks of a pipelined group: W_j = 2 W_(j-1) ^ X_j and Y_j = W_j ^ W_(j-1), x holds X on input and Y on output.
+ *
+ * rho_chain doubles w once per block, so a group of n blocks is a chain of n dependent doublings. Once the AES layers are wide, this chain
+ * is the longest dependency of the loop. rho_lookahead uses W_j = 2^j W_0 ^ P_j with P_j = 2^(j-1) X_1 ^ ... ^ X_j instead:
+ * the P_j only depend on the blocks and are built in log2(n) steps (P_j ^= 2^d P_(j-d) for d = 1, 2, 4, ...), and W_0 is multiplied with
+ * all powers at once (gf_mul2k). From one group to the next the chain is a single multiplication with 2^n.
+ * The inverse has no doubling in the chain (W_j = W_(j-1) ^ Y_j), so the decryption keeps RHO_INVERSE_INPLACE.
+ *
+ * rho_group picks the lookahead from COLM_RHO_LOOKAHEAD blocks per group on. It is off (0) by default: on out-of-order x86 cores the
+ * doublings of one group already overlap with the AES of the others and the extra multiplications compete with the AES unit, so whole
+ * messages got slower. It is meant for cores where the chain is the limit (in-order cores, -DCOLM_RHO_LOOKAHEAD=8).
+ * bench/bench_rho.c compares both kernels.
+ */
+
+#ifndef COLM_RHO
+#define COLM_RHO
+
+#include "colm_backend.h"
+
+#ifndef COLM_RHO_LOOKAHEAD
+#define COLM_RHO_LOOKAHEAD 0
+#endif
+
+#define COLM_RHO_MAX_LANES 16
+
+// one doubling per block
+PIPELINED void rho_chain(block_t* x, block_t* w, const uint8_t n)
+{
+	block_t st = *w, w_tmp;
+	uint8_t j;
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		RHO_INPLACE(x[j], st, w_tmp);
+	}
+
+	*w = st;
+}
+
+// prefix sums of the blocks, only the last step depends on w (n <= COLM_RHO_MAX_LANES)
+PIPELINED void rho_lookahead(block_t* x, block_t* w, const uint8_t n)
+{
+	block_t p[COLM_RHO_MAX_LANES];
+	block_t prev = *w, w_j;
+	uint8_t d, j;
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		p[j] = x[j];
+	}
+
+	// p[j] = sum of 2^(j - i) x[i] for i <= j (from the top, so p[j - d] is still the one of the previous step)
+	UNROLL_LANES
+	for (d = 1; d < n; d *= 2)
+	{
+		UNROLL_LANES
+		for (j = n - 1; j >= d; j--)
+		{
+			p[j] = XOR_BLOCK(p[j], gf_mul2k(p[j - d], d));
+		}
+	}
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		w_j = XOR_BLOCK(gf_mul2k(*w, j + 1), p[j]);
+		x[j] = XOR_BLOCK(w_j, prev);
+		prev = w_j;
+	}
+
+	*w = prev;
+}
+
+// W after lane of a group, from the w before the group and its outputs (W_j = W_(j-1) ^ Y_j)
+PIPELINED block_t rho_state_after(block_t w, const block_t* y, uint8_t lane)
+{
+	uint8_t j;
+
+	for (j = 0; j <= lane; j++)
+	{
+		w = XOR_BLOCK(w, y[j]);
+	}
+
+	return w;
+}
+
+PIPELINED void rho_group(block_t* x, block_t* w, const uint8_t n)
+{
+#if COLM_RHO_LOOKAHEAD > 0
+	if (n >= COLM_RHO_LOOKAHEAD)
+	{
+		rho_lookahead(x, w, n);
+		return;
+	}
+#endif
+	rho_chain(x, w, n);
+}
+
+#endif
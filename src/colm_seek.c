@@ -0,0 +1,131 @@
+/*
+ * Random access to the segments of a COLM127 ciphertext.
+ *
+ * An intermediate tag is the encryption of the rho state after its segment: tag = E(W) ^ delta_c. Decrypting the tag before a segment
+ * gives the state the segment starts with, and the deltas of any block are L * 2^i and delta_c * 2^(i + tags before it). So a segment can be
+ * decrypted and checked against its own tag without touching anything before it, a range read costs O(range) instead of O(offset + range).
+ *
+ * The tags alone don't bind a segment to its object: the deltas only depend on the position, so a segment together with the tags around it
+ * from another object under the same key (other nonce and associated data) would verify as well. The start state of a range therefore comes
+ * from an index stored next to the object, one block per intermediate tag: index[k] = E(W ^ w0), W the state after segment k and w0 the MAC
+ * of nonce and associated data. Only the object with the same nonce and associated data gets the right W out of it, any other start state
+ * (a foreign or modified index block, or a segment of another object or position) makes the tag at the end of the segment invalid.
+ *
+ * The last block of the message contains the checksum of all plaintext blocks, so the segment that contains it can only be decrypted
+ * with colm127_decrypt (or the streaming functions).
+ */
+
+#include "colm.h"
+#include "colm_backend.h"
+
+// everything below uses the AES instructions (see aes_crypto.h)
+AES_TARGET_BEGIN
+
+#define SEGMENT_BLOCKS 127
+
+// state at the start of segment first: deltas of its first block, w from the tag before it (w is the MAC for the first segment, tags == NULL: w is the state)
+void colm127_segment_start(const colm_key_ctx* ctx, block_t w, const uint8_t* tags, uint64_t first, colm_state* st)
+{
+	uint64_t start = first * SEGMENT_BLOCKS;
+	block_t tag;
+
+	st->checksum = ZERO_BLOCK();
+	st->delta_m = gf_mul_pow2(ctx->L, start);
+	st->delta_c = gf_mul_pow2(ctx->delta_c, start + first);
+	st->w = w;
+
+	if (first > 0 && tags != NULL)
+	{
+		// the tag shares delta_c with the block before it
+		tag = XOR_BLOCK(LOAD_BLOCK(tags + (first - 1) * BLOCKSIZE), st->delta_c);
+		AES_DECRYPT(tag, ctx->aes_decryption_keys);
+		st->w = tag;
+	}
+}
+
+// the segments first .. first + count - 1 from st on, -5 => the tag of segment *failed is invalid
+int8_t colm127_segments_decrypt(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, const uint8_t* tags, uint64_t first, uint64_t count, uint64_t* failed)
+{
+	const colm_backend* b = colm_backend_active();
+	uint64_t i;
+
+	for (i = first; i < first + count; i++)
+	{
+		b->decrypt_blocks(ctx, st, in, out, SEGMENT_BLOCKS - 1);
+		in += (SEGMENT_BLOCKS - 1) * BLOCKSIZE;
+		out += (SEGMENT_BLOCKS - 1) * BLOCKSIZE;
+
+		if (colm_decrypt_tag_block(ctx, st, in, out, tags + i * BLOCKSIZE) != 0)
+		{
+			*failed = i;
+			return -5;
+		}
+		in += BLOCKSIZE;
+		out += BLOCKSIZE;
+	}
+
+	return 0;
+}
+
+int8_t colm127_segment_index(const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub, const uint8_t* tags, uint64_t tag_len, uint8_t* index)
+{
+	const colm_backend* b = colm_backend_active();
+	block_t w0, block;
+	colm_state st;
+	uint64_t k;
+
+	if (b == NULL)
+	{
+		return -6;
+	}
+
+	w0 = b->mac(ctx, NONCE_BLOCK(npub, COLM127_PARAM), associated_data, data_len);
+
+	for (k = 0; k < tag_len / BLOCKSIZE; k++)
+	{
+		// state after segment k (at the start of segment k + 1)
+		colm127_segment_start(ctx, w0, tags, k + 1, &st);
+		block = XOR_BLOCK(st.w, w0);
+		AES_ENCRYPT(block, ctx->aes_encryption_keys);
+		STORE_BLOCK(index + k * BLOCKSIZE, block);
+	}
+
+	return 0;
+}
+
+int8_t colm127_decrypt_segments(const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t len, const uint8_t* tags, uint64_t tag_len,
+                                const uint8_t* index, uint64_t first, uint64_t count, const uint8_t* segments, uint8_t* message)
+{
+	const colm_backend* b = colm_backend_active();
+	uint64_t blocks, failed;
+	colm_state st;
+	block_t w, block;
+
+	if (b == NULL)
+	{
+		return -6;
+	}
+
+	// number of message blocks (the last one is there even for an empty message)
+	blocks = len > BLOCKSIZE ? (len - 1) / BLOCKSIZE : 1;
+
+	// -1 => the range contains the last block, or its tags (or the index) are missing
+	if (len < BLOCKSIZE || (first + count) * SEGMENT_BLOCKS >= blocks || first + count > tag_len / BLOCKSIZE || (first > 0 && index == NULL))
+	{
+		return -1;
+	}
+
+	w = b->mac(ctx, NONCE_BLOCK(npub, COLM127_PARAM), associated_data, data_len);
+
+	if (first > 0)
+	{
+		block = LOAD_BLOCK(index + (first - 1) * BLOCKSIZE);
+		AES_DECRYPT(block, ctx->aes_decryption_keys);
+		w = XOR_BLOCK(block, w);
+	}
+
+	colm127_segment_start(ctx, w, NULL, first, &st);
+	return colm127_segments_decrypt(ctx, &st, segments, message, tags, first, count, &failed);
+}
+
+AES_TARGET_END
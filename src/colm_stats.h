@@ -0,0 +1,71 @@
+/*
+ * Instrumentation of the hot paths, collected into the colm_stats of the calling thread (colm.h) if the library is built with -DCOLM_STATS.
+ * Otherwise all macros are empty and the loops are the same as without them.
+ *
+ * COLM_STATS_DECLARE declares the start time of a function, COLM_STATS_START starts a measurement and COLM_STATS_PHASE adds the time
+ * since then and n blocks to a phase and starts the next measurement right away, so the phases of a pipelined group follow each other
+ * without gaps. COLM_STATS_BLOCKS only counts blocks, COLM_STATS_RESULT counts the failures of a status code and passes it on.
+ * The time is the time stamp counter (rdtsc, CNTVCT_EL0 on ARMv8), without one the monotonic clock in nanoseconds.
+ */
+
+#ifndef COLM_STATS_H
+#define COLM_STATS_H
+
+#include "colm.h"
+
+#ifdef COLM_STATS
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif !defined(__aarch64__)
+#include <time.h>
+#endif
+
+extern __thread colm_stats colm_stats_thread;
+
+static inline uint64_t colm_stats_now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#elif defined(__aarch64__)
+	uint64_t value;
+	__asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+	return value;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline int8_t colm_stats_result(int8_t status)
+{
+	if (status < 0 && status > -COLM_STATS_STATUSES)
+	{
+		colm_stats_thread.failures[-status]++;
+	}
+	return status;
+}
+
+#define COLM_STATS_DECLARE uint64_t colm_stats_start = 0
+#define COLM_STATS_START() (colm_stats_start = colm_stats_now())
+#define COLM_STATS_PHASE(phase, n) do { \
+										uint64_t colm_stats_end = colm_stats_now(); \
+										colm_stats_thread.cycles[phase] += colm_stats_end - colm_stats_start; \
+										colm_stats_thread.blocks[phase] += (n); \
+										colm_stats_start = colm_stats_end; \
+									} while (0)
+#define COLM_STATS_BLOCKS(phase, n) (colm_stats_thread.blocks[phase] += (n))
+#define COLM_STATS_RESULT(status) colm_stats_result(status)
+
+#else
+
+#define COLM_STATS_DECLARE
+#define COLM_STATS_START() ((void)0)
+#define COLM_STATS_PHASE(phase, n) ((void)0)
+#define COLM_STATS_BLOCKS(phase, n) ((void)0)
+#define COLM_STATS_RESULT(status) (status)
+
+#endif
+
+#endif
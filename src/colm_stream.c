@@ -0,0 +1,536 @@
+/*
+ * Streaming API: init / update / final for messages that are not in memory at once.
+ *
+ * COLM needs to know which block is the last one (it is processed with other deltas, followed by the tag), so update holds back
+ * the last block of what it has seen so far (for a ciphertext the last block and the tag, at most 32 bytes). Everything before it
+ * goes through the block loops of the selected backend (encrypt_blocks / decrypt_blocks of colm_backend.h), so a stream runs at
+ * the speed of the one-shot functions as long as the chunks are not tiny, with constant memory independent of the message size.
+ * The intermediate tags of COLM127 are inserted here, the chunks are split at them.
+ * The COLM127 decryption collects the plaintext of a segment in a window and only outputs it after the tag at its end verified.
+ */
+
+#include "colm.h"
+#include "colm_backend.h"
+
+// everything below uses the AES instructions (see aes_crypto.h)
+AES_TARGET_BEGIN
+
+static int8_t stream_init(colm_stream* st, const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8_t tag_interval)
+{
+	const colm_backend* b = colm_backend_active();
+
+	if (b == NULL)
+	{
+		return -6;
+	}
+
+	st->ctx = ctx;
+	st->state.w = b->mac(ctx, NONCE_BLOCK(npub, tag_interval ? COLM127_PARAM : COLM0_PARAM), associated_data, data_len);
+	st->state.checksum = ZERO_BLOCK();
+	st->state.delta_m = ctx->L;
+	st->state.delta_c = ctx->delta_c;
+	st->tag_interval = tag_interval;
+	st->until_tag = tag_interval ? tag_interval : UINT64_MAX;
+	st->buffered = 0;
+
+	return 0;
+}
+
+// a block that is followed by an intermediate tag (same as the loops of colm127_encrypt in colm_parallel.c)
+void colm_encrypt_tag_block(const colm_key_ctx* ctx, colm_state* s, const uint8_t* in, uint8_t* out, uint8_t* tag)
+{
+	block_t blocks[2], w_tmp;
+
+	s->delta_m = gf_mul2(s->delta_m);
+	blocks[0] = LOAD_BLOCK(in);
+	s->checksum = XOR_BLOCK(s->checksum, blocks[0]);
+	blocks[0] = XOR_BLOCK(blocks[0], s->delta_m);
+
+	AES_ENCRYPT(blocks[0], ctx->aes_encryption_keys);
+	RHO_INPLACE(blocks[0], s->w, w_tmp);
+
+	// second layer of the block and the tag together
+	blocks[1] = s->w;
+	AES_ENCRYPTN(blocks, 2, ctx->aes_encryption_keys);
+
+	// the tag shares its (once more doubled) delta_c with the block
+	s->delta_c = gf_mul2(gf_mul2(s->delta_c));
+	STORE_BLOCK(out, XOR_BLOCK(blocks[0], s->delta_c));
+	STORE_BLOCK(tag, XOR_BLOCK(blocks[1], s->delta_c));
+}
+
+// n full blocks, none of them the last block of the message
+static void process_blocks(colm_stream* st, const colm_backend* b, const uint8_t* in, uint8_t* out, uint64_t n, uint8_t decrypt, uint8_t** tags, uint64_t* tag_len)
+{
+	uint64_t k;
+
+	while (n > 0)
+	{
+		if (n < st->until_tag)
+		{
+			decrypt ? b->decrypt_blocks(st->ctx, &st->state, in, out, n) : b->encrypt_blocks(st->ctx, &st->state, in, out, n);
+			st->until_tag -= n;
+			return;
+		}
+
+		// the blocks up to the intermediate tag (only the COLM127 encryption gets here, its decryption uses verify_blocks)
+		k = st->until_tag - 1;
+		b->encrypt_blocks(st->ctx, &st->state, in, out, k);
+		colm_encrypt_tag_block(st->ctx, &st->state, in + k * BLOCKSIZE, out + k * BLOCKSIZE, *tags);
+		*tags += BLOCKSIZE;
+		*tag_len += BLOCKSIZE;
+		st->until_tag = st->tag_interval;
+
+		in += (k + 1) * BLOCKSIZE;
+		out += (k + 1) * BLOCKSIZE;
+		n -= k + 1;
+	}
+}
+
+// a block that is followed by an intermediate tag, decrypted (same as the loops of colm127_decrypt in colm_parallel.c)
+int8_t colm_decrypt_tag_block(const colm_key_ctx* ctx, colm_state* s, const uint8_t* in, uint8_t* out, const uint8_t* tag)
+{
+	block_t blocks[2], w_tmp;
+
+	s->delta_m = gf_mul2(s->delta_m);
+	s->delta_c = gf_mul2(gf_mul2(s->delta_c));
+
+	blocks[0] = XOR_BLOCK(LOAD_BLOCK(in), s->delta_c);
+	AES_DECRYPT(blocks[0], ctx->aes_decryption_keys);
+	RHO_INVERSE_INPLACE(blocks[0], s->w, w_tmp);
+
+	// second layer of the block and the tag together
+	blocks[1] = XOR_BLOCK(LOAD_BLOCK(tag), s->delta_c);
+	AES_DECRYPTN(blocks, 2, ctx->aes_decryption_keys);
+
+	blocks[0] = XOR_BLOCK(blocks[0], s->delta_m);
+	s->checksum = XOR_BLOCK(s->checksum, blocks[0]);
+	STORE_BLOCK(out, blocks[0]);
+
+	// -5 => intermediate tag invalid
+	return EQUALS(blocks[1], s->w) ? 0 : -5;
+}
+
+// the tags of the call are queued behind the ones not used yet
+static int8_t queue_tags(colm127_decrypt_stream* st, const uint8_t* tags, uint64_t tag_len)
+{
+	if (tag_len % BLOCKSIZE != 0 || tag_len / BLOCKSIZE > (uint64_t)(COLM_STREAM_TAGS - st->tags_queued))
+	{
+		return -8;
+	}
+
+	if (tag_len > 0)
+	{
+		memcpy(st->tags + st->tags_queued * BLOCKSIZE, tags, tag_len);
+	}
+	st->tags_queued += (uint8_t)(tag_len / BLOCKSIZE);
+	return 0;
+}
+
+// the next queued tag is used up
+static void pop_tag(colm127_decrypt_stream* vs)
+{
+	vs->tags_queued--;
+	memmove(vs->tags, vs->tags + BLOCKSIZE, vs->tags_queued * BLOCKSIZE);
+}
+
+// n full blocks into the window, a segment is released to out as soon as its tag verified
+static int8_t verify_blocks(colm127_decrypt_stream* vs, const colm_backend* b, const uint8_t* in, uint64_t n, uint8_t** out, uint64_t* out_len)
+{
+	colm_stream* st = &vs->stream;
+	uint64_t k;
+
+	while (n > 0)
+	{
+		if (n < st->until_tag)
+		{
+			b->decrypt_blocks(st->ctx, &st->state, in, vs->window + vs->window_len, n);
+			vs->window_len += (uint16_t)(n * BLOCKSIZE);
+			st->until_tag -= n;
+			return 0;
+		}
+
+		if (vs->tags_queued == 0)
+		{
+			// -8 => the tag of the segment did not come with its ciphertext
+			return -8;
+		}
+
+		k = st->until_tag - 1;
+		b->decrypt_blocks(st->ctx, &st->state, in, vs->window + vs->window_len, k);
+		vs->window_len += (uint16_t)(k * BLOCKSIZE);
+		if (colm_decrypt_tag_block(st->ctx, &st->state, in + k * BLOCKSIZE, vs->window + vs->window_len, vs->tags) != 0)
+		{
+			return -5;
+		}
+		vs->window_len += BLOCKSIZE;
+		pop_tag(vs);
+		st->until_tag = st->tag_interval;
+
+		memcpy(*out, vs->window, vs->window_len);
+		*out += vs->window_len;
+		*out_len += vs->window_len;
+		vs->window_len = 0;
+
+		in += (k + 1) * BLOCKSIZE;
+		n -= k + 1;
+	}
+
+	return 0;
+}
+
+// n full blocks of the stream to out, or through the window if vs is given
+static int8_t consume_blocks(colm_stream* st, colm127_decrypt_stream* vs, const colm_backend* b, const uint8_t* in, uint64_t n, uint8_t** out, uint64_t* out_len, uint8_t decrypt, uint8_t** tags, uint64_t* tag_len)
+{
+	if (vs != NULL)
+	{
+		return verify_blocks(vs, b, in, n, out, out_len);
+	}
+
+	process_blocks(st, b, in, *out, n, decrypt, tags, tag_len);
+	*out += n * BLOCKSIZE;
+	*out_len += n * BLOCKSIZE;
+	return 0;
+}
+
+// everything but the last hold bytes seen so far is processed, in place of the held back bytes first
+static int8_t stream_update(colm_stream* st, colm127_decrypt_stream* vs, const uint8_t* in, uint64_t len, uint8_t* out, uint64_t* out_len, uint8_t* tags, uint64_t* tag_len, uint8_t decrypt)
+{
+	const colm_backend* b = colm_backend_active();
+	const uint8_t hold = decrypt ? 2 * BLOCKSIZE : BLOCKSIZE;
+	uint64_t n, dummy_len;
+	uint8_t take;
+	int8_t status;
+
+	if (b == NULL)
+	{
+		return -6;
+	}
+
+	if (tag_len == NULL)
+	{
+		tag_len = &dummy_len;
+	}
+
+	*out_len = 0;
+	*tag_len = 0;
+
+	// the held back bytes are no longer the end of the message
+	while (st->buffered > 0 && st->buffered + len > hold)
+	{
+		if (st->buffered < BLOCKSIZE)
+		{
+			take = BLOCKSIZE - st->buffered;
+			memcpy(st->buf + st->buffered, in, take);
+			st->buffered += take;
+			in += take;
+			len -= take;
+		}
+
+		status = consume_blocks(st, vs, b, st->buf, 1, &out, out_len, decrypt, &tags, tag_len);
+		if (status != 0)
+		{
+			return status;
+		}
+
+		st->buffered -= BLOCKSIZE;
+		memmove(st->buf, st->buf + BLOCKSIZE, st->buffered);
+	}
+
+	// the rest directly from the input
+	if (len > hold)
+	{
+		n = (len - hold + BLOCKSIZE - 1) / BLOCKSIZE;
+		status = consume_blocks(st, vs, b, in, n, &out, out_len, decrypt, &tags, tag_len);
+		if (status != 0)
+		{
+			return status;
+		}
+		in += n * BLOCKSIZE;
+		len -= n * BLOCKSIZE;
+	}
+
+	memcpy(st->buf + st->buffered, in, len);
+	st->buffered += (uint8_t)len;
+
+	return 0;
+}
+
+/*
+ * Last block (remaining bytes of in, 0 - 16) and tag, same as the end of colm127_encrypt in colm_parallel.c (without intermediate tags colm0_encrypt).
+ * out gets the last ciphertext block, tag the intermediate tag after it (NULL if there is none) and end the tag shortened to remaining bytes.
+ */
+void colm_encrypt_last(const colm_key_ctx* ctx, colm_state* s, const uint8_t* in, uint8_t remaining, uint8_t* out, uint8_t* tag, uint8_t* end)
+{
+	const block_t* aes_round_keys = ctx->aes_encryption_keys;
+	uint8_t buf[BLOCKSIZE] = { 0 };
+	block_t block, w_tmp;
+
+	memcpy(buf, in, remaining);
+	s->delta_m = gf_mul7(s->delta_m);
+	s->delta_c = gf_mul7(s->delta_c);
+
+	// pad if nessesary
+	if (remaining < BLOCKSIZE) {
+		buf[remaining] = 0x80;
+		s->delta_m = gf_mul7(s->delta_m);
+		s->delta_c = gf_mul7(s->delta_c);
+	}
+
+	s->checksum = XOR_BLOCK(s->checksum, LOAD_BLOCK(buf));
+	block = XOR_BLOCK(s->checksum, s->delta_m);
+	AES_ENCRYPT(block, aes_round_keys);
+	RHO_INPLACE(block, s->w, w_tmp);
+	AES_ENCRYPT(block, aes_round_keys);
+	STORE_BLOCK(out, XOR_BLOCK(block, s->delta_c));
+
+	// intermediate tag after the last block
+	if (tag != NULL)
+	{
+		s->delta_c = gf_mul2(s->delta_c);
+		block = s->w;
+		AES_ENCRYPT(block, aes_round_keys);
+		STORE_BLOCK(tag, XOR_BLOCK(block, s->delta_c));
+	}
+
+	// the tag (shortened to the length of the last block, nothing for an empty message)
+	if (remaining == 0)
+	{
+		return;
+	}
+
+	s->delta_m = gf_mul2(s->delta_m);
+	s->delta_c = gf_mul2(s->delta_c);
+	block = XOR_BLOCK(s->delta_m, s->checksum);
+	AES_ENCRYPT(block, aes_round_keys);
+	RHO_INPLACE(block, s->w, w_tmp);
+	AES_ENCRYPT(block, aes_round_keys);
+
+	STORE_BLOCK(buf, XOR_BLOCK(block, s->delta_c));
+	memcpy(end, buf, remaining);
+}
+
+/*
+ * Last block and tag verification, same as the end of colm127_decrypt in colm_parallel.c (without intermediate tags colm0_decrypt).
+ * in is the last ciphertext block, tag the intermediate tag after it (NULL if there is none), end the shortened tag of remaining bytes.
+ * out gets the remaining bytes of the last message block.
+ */
+int8_t colm_decrypt_last(const colm_key_ctx* ctx, colm_state* s, const uint8_t* in, const uint8_t* tag, const uint8_t* end, uint8_t remaining, uint8_t* out)
+{
+	const block_t* aes_encryption_keys = ctx->aes_encryption_keys;
+	const block_t* aes_decryption_keys = ctx->aes_decryption_keys;
+	uint8_t buf[BLOCKSIZE];
+	block_t block, last, w_tmp;
+	uint32_t i;
+
+	s->delta_m = gf_mul7(s->delta_m);
+	s->delta_c = gf_mul7(s->delta_c);
+
+	if (remaining < BLOCKSIZE) {
+		s->delta_m = gf_mul7(s->delta_m);
+		s->delta_c = gf_mul7(s->delta_c);
+	}
+
+	block = XOR_BLOCK(LOAD_BLOCK(in), s->delta_c);
+	AES_DECRYPT(block, aes_decryption_keys);
+	RHO_INVERSE_INPLACE(block, s->w, w_tmp);
+	AES_DECRYPT(block, aes_decryption_keys);
+	last = XOR_BLOCK(block, s->delta_m);
+
+	s->checksum = XOR_BLOCK(s->checksum, last);
+	STORE_BLOCK(buf, s->checksum);
+	memcpy(out, buf, remaining);
+
+	// intermediate tag after the last block
+	if (tag != NULL)
+	{
+		s->delta_c = gf_mul2(s->delta_c);
+		block = XOR_BLOCK(LOAD_BLOCK(tag), s->delta_c);
+		AES_DECRYPT(block, aes_decryption_keys);
+		if (!EQUALS(block, s->w))
+		{
+			return -5;
+		}
+	}
+
+	// recompute the tag from the last message block
+	s->delta_m = gf_mul2(s->delta_m);
+	s->delta_c = gf_mul2(s->delta_c);
+	block = XOR_BLOCK(s->delta_m, last);
+	AES_ENCRYPT(block, aes_encryption_keys);
+	RHO_INPLACE(block, s->w, w_tmp);
+	AES_ENCRYPT(block, aes_encryption_keys);
+
+	STORE_BLOCK(buf, XOR_BLOCK(block, s->delta_c));
+	if (memcmp(end, buf, remaining) != 0) {
+		return -2;
+	}
+
+	if (remaining < BLOCKSIZE) {
+		STORE_BLOCK(buf, s->checksum);
+		// check padding
+		if (buf[remaining] != 0x80) {
+			return -3;
+		}
+		// the remaining data has to be zero (padding scheme)
+		for (i = remaining + 1; i < BLOCKSIZE; i++) {
+			if (buf[i] != 0) {
+				return -4;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// the held back block of the stream
+static int8_t encrypt_final(colm_stream* st, uint8_t* out, uint64_t* c_len, uint8_t* tags, uint64_t* tag_len)
+{
+	uint8_t tag_follows;
+
+	if (colm_backend_active() == NULL)
+	{
+		return -6;
+	}
+
+	tag_follows = --st->until_tag == 0;
+
+	*c_len = st->buffered + BLOCKSIZE;
+	if (tag_len != NULL)
+	{
+		*tag_len = tag_follows ? BLOCKSIZE : 0;
+	}
+
+	colm_encrypt_last(st->ctx, &st->state, st->buf, st->buffered, out, tag_follows ? tags : NULL, out + BLOCKSIZE);
+	return 0;
+}
+
+// the held back block and tag of the stream, tag = the intermediate tag (if one follows the last block)
+static int8_t decrypt_final(colm_stream* st, uint8_t* out, uint64_t* m_len, const uint8_t* tag)
+{
+	uint8_t tag_follows;
+
+	if (colm_backend_active() == NULL)
+	{
+		return -6;
+	}
+
+	if (st->buffered < BLOCKSIZE)
+	{
+		// -1 => invalid size of ciphertext
+		return -1;
+	}
+
+	tag_follows = --st->until_tag == 0;
+
+	if (tag_follows && tag == NULL)
+	{
+		return -8;
+	}
+
+	*m_len = st->buffered - BLOCKSIZE;
+	return colm_decrypt_last(st->ctx, &st->state, st->buf, tag_follows ? tag : NULL, st->buf + BLOCKSIZE, st->buffered - BLOCKSIZE, out);
+}
+
+
+
+/* ----------------------- PUBLIC API ------------------------- */
+
+int8_t colm0_encrypt_init(colm_stream* st, const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub)
+{
+	return stream_init(st, ctx, associated_data, data_len, npub, 0);
+}
+
+int8_t colm0_encrypt_update(colm_stream* st, const uint8_t* message, uint64_t len, uint8_t* ciphertext, uint64_t* c_len)
+{
+	return stream_update(st, NULL, message, len, ciphertext, c_len, NULL, NULL, 0);
+}
+
+int8_t colm0_encrypt_final(colm_stream* st, uint8_t* ciphertext, uint64_t* c_len)
+{
+	return encrypt_final(st, ciphertext, c_len, NULL, NULL);
+}
+
+int8_t colm0_decrypt_init(colm_stream* st, const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub)
+{
+	return stream_init(st, ctx, associated_data, data_len, npub, 0);
+}
+
+int8_t colm0_decrypt_update(colm_stream* st, const uint8_t* ciphertext, uint64_t len, uint8_t* message, uint64_t* m_len)
+{
+	return stream_update(st, NULL, ciphertext, len, message, m_len, NULL, NULL, 1);
+}
+
+int8_t colm0_decrypt_final(colm_stream* st, uint8_t* message, uint64_t* m_len)
+{
+	return decrypt_final(st, message, m_len, NULL);
+}
+
+int8_t colm127_encrypt_init(colm_stream* st, const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub)
+{
+	return stream_init(st, ctx, associated_data, data_len, npub, 127);
+}
+
+int8_t colm127_encrypt_update(colm_stream* st, const uint8_t* message, uint64_t len, uint8_t* ciphertext, uint64_t* c_len, uint8_t* tags, uint64_t* tag_len)
+{
+	return stream_update(st, NULL, message, len, ciphertext, c_len, tags, tag_len, 0);
+}
+
+int8_t colm127_encrypt_final(colm_stream* st, uint8_t* ciphertext, uint64_t* c_len, uint8_t* tags, uint64_t* tag_len)
+{
+	return encrypt_final(st, ciphertext, c_len, tags, tag_len);
+}
+
+int8_t colm127_decrypt_init(colm127_decrypt_stream* st, const colm_key_ctx* ctx, uint8_t* associated_data, uint64_t data_len, uint64_t npub)
+{
+	st->status = 0;
+	st->tags_queued = 0;
+	st->window_len = 0;
+	st->status = stream_init(&st->stream, ctx, associated_data, data_len, npub, 127);
+	return st->status;
+}
+
+int8_t colm127_decrypt_update(colm127_decrypt_stream* st, const uint8_t* ciphertext, uint64_t len, const uint8_t* tags, uint64_t tag_len, uint8_t* message, uint64_t* m_len)
+{
+	*m_len = 0;
+
+	if (st->status == 0)
+	{
+		st->status = queue_tags(st, tags, tag_len);
+	}
+	if (st->status == 0)
+	{
+		st->status = stream_update(&st->stream, st, ciphertext, len, message, m_len, NULL, NULL, 1);
+	}
+
+	return st->status;
+}
+
+int8_t colm127_decrypt_final(colm127_decrypt_stream* st, const uint8_t* tags, uint64_t tag_len, uint8_t* message, uint64_t* m_len)
+{
+	uint64_t last_len;
+
+	*m_len = 0;
+
+	if (st->status == 0)
+	{
+		st->status = queue_tags(st, tags, tag_len);
+	}
+	if (st->status == 0)
+	{
+		st->status = decrypt_final(&st->stream, st->window + st->window_len, &last_len, st->tags_queued > 0 ? st->tags : NULL);
+	}
+	if (st->status != 0)
+	{
+		return st->status;
+	}
+
+	// everything verified: the rest of the last segment
+	*m_len = st->window_len + last_len;
+	memcpy(message, st->window, *m_len);
+	st->window_len = 0;
+
+	return 0;
+}
+
+AES_TARGET_END
@@ -0,0 +1,933 @@
+/*
+ * Multi-threaded COLM0 / COLM127 for large messages.
+ *
+ * The only serial part of COLM is the rho chain W_i = 2 * W_(i-1) + X_i. It is linear, so a segment of k blocks
+ * can be reduced on its own (S = sum 2^(k - i) * X_i, starting with W = 0) and later combined with the state before it:
+ * W_end = 2^k * W_start + S. A message is therefore processed in three steps:
+ *   1. every thread runs the first AES layer on its segment and reduces it (the X_i are kept in the output buffer)
+ *   2. the calling thread chains the segments (one multiplication with 2^k per segment)
+ *   3. every thread runs rho with the now known W_start and the second AES layer on its segment
+ * The decryption is even simpler, there W_i = W_(i-1) + Y_i, so the segments are just xored.
+ * The result is bit identical to the single threaded functions.
+ */
+
+#include "colm.h"
+#include "colm_backend.h"
+#include "colm_rho.h"
+#include <pthread.h>
+
+// everything below uses the AES instructions (see aes_crypto.h)
+AES_TARGET_BEGIN
+
+
+/* ----------------------- THREAD POOL ------------------------- */
+
+typedef struct segment segment;
+typedef int8_t (*segment_job)(segment* seg);
+
+typedef struct worker
+{
+	colm_thread_pool* pool;
+	uint8_t index;
+} worker;
+
+struct colm_thread_pool
+{
+	pthread_mutex_t busy; // one message at a time
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t done;
+	pthread_t threads[COLM_MAX_THREADS];
+	worker workers[COLM_MAX_THREADS];
+	uint8_t count; // including the calling thread, which works on the first segment
+
+	// the current job (protected by lock)
+	uint64_t generation;
+	segment_job job;
+	segment* segments;
+	uint8_t segment_count;
+	uint8_t pending;
+	uint8_t stop;
+};
+
+struct segment
+{
+	const colm_key_ctx* ctx;
+	const uint8_t* in;
+	uint8_t* out;
+	uint8_t* tags;        // all intermediate tags of the message (COLM127)
+	uint64_t first;       // index of the first block (starting at 1)
+	uint64_t blocks;
+	uint8_t tag_interval; // 127 for COLM127, 0 for COLM0
+	block_t sum;          // step 1: reduction of the segment
+	block_t w;            // step 3: W before the first block
+	block_t checksum;
+	int8_t result;
+	uint64_t failed;      // COLM127 decryption: segment of 127 blocks with the first invalid tag
+};
+
+static void* worker_main(void* arg)
+{
+	worker* self = (worker*)arg;
+	colm_thread_pool* pool = self->pool;
+	uint64_t seen = 0;
+	segment_job job;
+	segment* seg;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&pool->lock);
+		while (pool->generation == seen && !pool->stop)
+		{
+			pthread_cond_wait(&pool->start, &pool->lock);
+		}
+		if (pool->stop)
+		{
+			pthread_mutex_unlock(&pool->lock);
+			return NULL;
+		}
+		seen = pool->generation;
+		job = pool->job;
+		seg = self->index < pool->segment_count ? &pool->segments[self->index] : NULL;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (seg != NULL)
+		{
+			seg->result = job(seg);
+		}
+
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->pending == 0)
+		{
+			pthread_cond_signal(&pool->done);
+		}
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+// runs job on all segments and waits for them
+static int8_t run_segments(colm_thread_pool* pool, segment_job job, segment* segments, uint8_t count)
+{
+	uint8_t i;
+	int8_t result = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->job = job;
+	pool->segments = segments;
+	pool->segment_count = count;
+	pool->pending = pool->count - 1;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+
+	segments[0].result = job(&segments[0]);
+
+	pthread_mutex_lock(&pool->lock);
+	while (pool->pending > 0)
+	{
+		pthread_cond_wait(&pool->done, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	// report the error of the first segment that failed
+	for (i = 0; i < count; i++)
+	{
+		if (segments[i].result != 0)
+		{
+			result = segments[i].result;
+			break;
+		}
+	}
+
+	return result;
+}
+
+colm_thread_pool* colm_thread_pool_create(uint8_t threads)
+{
+	colm_thread_pool* pool;
+	uint8_t i;
+
+	if (threads < 1 || threads > COLM_MAX_THREADS)
+	{
+		return NULL;
+	}
+
+	pool = calloc(1, sizeof(colm_thread_pool));
+	if (pool == NULL)
+	{
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->busy, NULL);
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	pool->count = 1;
+
+	for (i = 1; i < threads; i++)
+	{
+		pool->workers[i].pool = pool;
+		pool->workers[i].index = i;
+		if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->workers[i]) != 0)
+		{
+			break; // work with the threads we got
+		}
+		pool->count++;
+	}
+
+	return pool;
+}
+
+void colm_thread_pool_free(colm_thread_pool* pool)
+{
+	uint8_t i;
+
+	if (pool == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 1; i < pool->count; i++)
+	{
+		pthread_join(pool->threads[i], NULL);
+	}
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->start);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_mutex_destroy(&pool->busy);
+	free(pool);
+}
+
+uint8_t colm_thread_pool_size(const colm_thread_pool* pool)
+{
+	return pool->count;
+}
+
+
+
+/* ----------------------- SEGMENTS ------------------------- */
+
+// delta_c after the first blocks of the message (the block of every intermediate tag is doubled once more)
+static block_t delta_c_after(const colm_key_ctx* ctx, uint64_t blocks, uint8_t tag_interval)
+{
+	return gf_mul_pow2(ctx->delta_c, blocks + (tag_interval ? blocks / tag_interval : 0));
+}
+
+// lane of the group starting at block index after which an intermediate tag follows (>= n if there is none)
+static inline uint8_t tag_lane(uint64_t index, uint8_t tag_interval)
+{
+	return tag_interval ? (uint8_t)((tag_interval - index % tag_interval) % tag_interval) : COLM_MAX_PIPELINE_WIDTH;
+}
+
+/*
+ * The groups process n blocks at once. They are called with the pipeline width for the bulk of a segment
+ * and with n = 1 for the remaining blocks, n is a compile time constant in both cases.
+ */
+
+// step 1 of the encryption: X_i = E(M_i + delta_m) into out, sum = 2^(k-1) * X_1 + ... + X_k
+PIPELINED void encrypt_first_layer_group(const block_t* aes_round_keys, const uint8_t* in, uint8_t* out, block_t* delta_m, block_t* sum, block_t* checksum, const uint8_t n)
+{
+	block_t blocks[COLM_MAX_PIPELINE_WIDTH];
+	uint8_t j;
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		*delta_m = gf_mul2(*delta_m);
+		blocks[j] = LOAD_BLOCK(in + j * BLOCKSIZE);
+		*checksum = XOR_BLOCK(*checksum, blocks[j]);
+		blocks[j] = XOR_BLOCK(blocks[j], *delta_m);
+	}
+
+	AES_ENCRYPTN(blocks, n, aes_round_keys);
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		*sum = XOR_BLOCK(gf_mul2(*sum), blocks[j]);
+		STORE_BLOCK(out + j * BLOCKSIZE, blocks[j]);
+	}
+}
+
+PIPELINED int8_t encrypt_first_layer(segment* seg, const uint8_t width)
+{
+	block_t delta_m = gf_mul_pow2(seg->ctx->L, seg->first - 1);
+	block_t sum = ZERO_BLOCK(), checksum = ZERO_BLOCK();
+	uint64_t i = 0;
+
+	for (; i + width <= seg->blocks; i += width)
+	{
+		encrypt_first_layer_group(seg->ctx->aes_encryption_keys, seg->in + i * BLOCKSIZE, seg->out + i * BLOCKSIZE, &delta_m, &sum, &checksum, width);
+	}
+	for (; i < seg->blocks; i++)
+	{
+		encrypt_first_layer_group(seg->ctx->aes_encryption_keys, seg->in + i * BLOCKSIZE, seg->out + i * BLOCKSIZE, &delta_m, &sum, &checksum, 1);
+	}
+
+	seg->sum = sum;
+	seg->checksum = checksum;
+	return 0;
+}
+
+// step 3 of the encryption: rho, intermediate tags and C_i = E(Y_i) + delta_c (out holds the X_i of step 1)
+PIPELINED void encrypt_second_layer_group(const segment* seg, uint64_t index, uint8_t* out, block_t* w, block_t* delta_c, const uint8_t n)
+{
+	const block_t* aes_round_keys = seg->ctx->aes_encryption_keys;
+	block_t blocks[COLM_MAX_PIPELINE_WIDTH];
+	block_t w_tag = *w, tag;
+	uint8_t itag = tag_lane(index, seg->tag_interval);
+	uint8_t j;
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		blocks[j] = LOAD_BLOCK(out + j * BLOCKSIZE);
+	}
+
+	rho_group(blocks, w, n);
+	if (itag < n)
+	{
+		w_tag = rho_state_after(w_tag, blocks, itag);
+	}
+
+	AES_ENCRYPTN(blocks, n, aes_round_keys);
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		*delta_c = gf_mul2(*delta_c);
+
+		// the tag "after" block j shares its (once more doubled) delta_c with it
+		if (j == itag)
+		{
+			*delta_c = gf_mul2(*delta_c);
+			tag = w_tag;
+			AES_ENCRYPT(tag, aes_round_keys);
+			STORE_BLOCK(seg->tags + ((index + j) / seg->tag_interval - 1) * BLOCKSIZE, XOR_BLOCK(tag, *delta_c));
+		}
+
+		STORE_BLOCK(out + j * BLOCKSIZE, XOR_BLOCK(blocks[j], *delta_c));
+	}
+}
+
+PIPELINED int8_t encrypt_second_layer(segment* seg, const uint8_t width)
+{
+	block_t delta_c = delta_c_after(seg->ctx, seg->first - 1, seg->tag_interval);
+	block_t w = seg->w;
+	uint64_t i = 0;
+
+	for (; i + width <= seg->blocks; i += width)
+	{
+		encrypt_second_layer_group(seg, seg->first + i, seg->out + i * BLOCKSIZE, &w, &delta_c, width);
+	}
+	for (; i < seg->blocks; i++)
+	{
+		encrypt_second_layer_group(seg, seg->first + i, seg->out + i * BLOCKSIZE, &w, &delta_c, 1);
+	}
+
+	return 0;
+}
+
+// step 1 of the decryption: Y_i = D(C_i + delta_c) into out, sum = Y_1 + ... + Y_k
+PIPELINED void decrypt_first_layer_group(const segment* seg, uint64_t index, const uint8_t* in, uint8_t* out, block_t* delta_c, block_t* sum, const uint8_t n)
+{
+	block_t blocks[COLM_MAX_PIPELINE_WIDTH];
+	uint8_t itag = tag_lane(index, seg->tag_interval);
+	uint8_t j;
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		*delta_c = gf_mul2(*delta_c);
+		if (j == itag) *delta_c = gf_mul2(*delta_c);
+		blocks[j] = XOR_BLOCK(LOAD_BLOCK(in + j * BLOCKSIZE), *delta_c);
+	}
+
+	AES_DECRYPTN(blocks, n, seg->ctx->aes_decryption_keys);
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		*sum = XOR_BLOCK(*sum, blocks[j]);
+		STORE_BLOCK(out + j * BLOCKSIZE, blocks[j]);
+	}
+}
+
+PIPELINED int8_t decrypt_first_layer(segment* seg, const uint8_t width)
+{
+	block_t delta_c = delta_c_after(seg->ctx, seg->first - 1, seg->tag_interval);
+	block_t sum = ZERO_BLOCK();
+	uint64_t i = 0;
+
+	for (; i + width <= seg->blocks; i += width)
+	{
+		decrypt_first_layer_group(seg, seg->first + i, seg->in + i * BLOCKSIZE, seg->out + i * BLOCKSIZE, &delta_c, &sum, width);
+	}
+	for (; i < seg->blocks; i++)
+	{
+		decrypt_first_layer_group(seg, seg->first + i, seg->in + i * BLOCKSIZE, seg->out + i * BLOCKSIZE, &delta_c, &sum, 1);
+	}
+
+	seg->sum = sum;
+	return 0;
+}
+
+// step 3 of the decryption: rho^-1, verify the intermediate tags and M_i = D(X_i) + delta_m (out holds the Y_i of step 1)
+PIPELINED int8_t decrypt_second_layer_group(const segment* seg, uint64_t index, uint8_t* out, block_t* w, block_t* delta_m, block_t* delta_c, block_t* checksum, const uint8_t n)
+{
+	const block_t* aes_decryption_keys = seg->ctx->aes_decryption_keys;
+	block_t blocks[COLM_MAX_PIPELINE_WIDTH];
+	block_t w_tmp, tag;
+	block_t w_tag = ZERO_BLOCK(), delta_tag = ZERO_BLOCK(); // only used if the group has an intermediate tag
+	uint8_t itag = tag_lane(index, seg->tag_interval);
+	uint8_t j;
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		*delta_c = gf_mul2(*delta_c);
+		blocks[j] = LOAD_BLOCK(out + j * BLOCKSIZE);
+		RHO_INVERSE_INPLACE(blocks[j], *w, w_tmp);
+		if (j == itag)
+		{
+			*delta_c = gf_mul2(*delta_c);
+			delta_tag = *delta_c;
+			w_tag = *w;
+		}
+	}
+
+	if (itag < n)
+	{
+		tag = XOR_BLOCK(LOAD_BLOCK(seg->tags + ((index + itag) / seg->tag_interval - 1) * BLOCKSIZE), delta_tag);
+		AES_DECRYPT(tag, aes_decryption_keys);
+		if (!EQUALS(tag, w_tag))
+		{
+			return -5;
+		}
+	}
+
+	AES_DECRYPTN(blocks, n, aes_decryption_keys);
+
+	UNROLL_LANES
+	for (j = 0; j < n; j++)
+	{
+		*delta_m = gf_mul2(*delta_m);
+		blocks[j] = XOR_BLOCK(blocks[j], *delta_m);
+		*checksum = XOR_BLOCK(*checksum, blocks[j]);
+		STORE_BLOCK(out + j * BLOCKSIZE, blocks[j]);
+	}
+
+	return 0;
+}
+
+PIPELINED int8_t decrypt_second_layer(segment* seg, const uint8_t width)
+{
+	block_t delta_m = gf_mul_pow2(seg->ctx->L, seg->first - 1);
+	block_t delta_c = delta_c_after(seg->ctx, seg->first - 1, seg->tag_interval);
+	block_t w = seg->w, checksum = ZERO_BLOCK();
+	uint64_t i = 0;
+
+	for (; i + width <= seg->blocks; i += width)
+	{
+		if (decrypt_second_layer_group(seg, seg->first + i, seg->out + i * BLOCKSIZE, &w, &delta_m, &delta_c, &checksum, width) != 0)
+		{
+			return -5;
+		}
+	}
+	for (; i < seg->blocks; i++)
+	{
+		if (decrypt_second_layer_group(seg, seg->first + i, seg->out + i * BLOCKSIZE, &w, &delta_m, &delta_c, &checksum, 1) != 0)
+		{
+			return -5;
+		}
+	}
+
+	seg->checksum = checksum;
+	return 0;
+}
+
+static int8_t encrypt_first_layer_job(segment* seg)
+{
+	CALL_WITH_PIPELINE_WIDTH(seg->ctx->pipeline_width, encrypt_first_layer, seg);
+}
+
+static int8_t encrypt_second_layer_job(segment* seg)
+{
+	CALL_WITH_PIPELINE_WIDTH(seg->ctx->pipeline_width, encrypt_second_layer, seg);
+}
+
+static int8_t decrypt_first_layer_job(segment* seg)
+{
+	CALL_WITH_PIPELINE_WIDTH(seg->ctx->pipeline_width, decrypt_first_layer, seg);
+}
+
+static int8_t decrypt_second_layer_job(segment* seg)
+{
+	CALL_WITH_PIPELINE_WIDTH(seg->ctx->pipeline_width, decrypt_second_layer, seg);
+}
+
+// COLM127 decryption of whole 127 block segments in one pass, the state at the start comes from the tag before them (see colm_seek.c)
+static int8_t decrypt_segments_job(segment* seg)
+{
+	uint64_t first = (seg->first - 1) / seg->tag_interval;
+	colm_state st;
+	int8_t result;
+
+	colm127_segment_start(seg->ctx, seg->w, seg->tags, first, &st);
+	result = colm127_segments_decrypt(seg->ctx, &st, seg->in, seg->out, seg->tags, first, seg->blocks / seg->tag_interval, &seg->failed);
+	seg->checksum = st.checksum;
+
+	return result;
+}
+
+/*
+ * Splits the blocks 1 ... blocks of the message into segments (at least COLM_THREAD_MIN_BLOCKS each).
+ * Returns the number of segments, less than 2 means the message is too short to be split.
+ */
+static uint8_t split_segments(colm_thread_pool* pool, const colm_key_ctx* ctx, const uint8_t* in, uint8_t* out, uint8_t* tags, uint64_t blocks, uint8_t tag_interval, segment* segments)
+{
+	uint64_t count = blocks / COLM_THREAD_MIN_BLOCKS;
+	uint64_t first = 1, size;
+	uint8_t i;
+
+	if (count > pool->count)
+	{
+		count = pool->count;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		size = blocks / count + (i < blocks % count ? 1 : 0);
+
+		segments[i].ctx = ctx;
+		segments[i].in = in + (first - 1) * BLOCKSIZE;
+		segments[i].out = out + (first - 1) * BLOCKSIZE;
+		segments[i].tags = tags;
+		segments[i].first = first;
+		segments[i].blocks = size;
+		segments[i].tag_interval = tag_interval;
+		segments[i].result = 0;
+
+		first += size;
+	}
+
+	return (uint8_t)count;
+}
+
+
+
+/* ----------------------- ENCRYPTION ------------------------- */
+
+// the last (maybe partial) block and the final tag, same as in colm_parallel.c
+static int8_t encrypt_final(const colm_key_ctx* ctx, const uint8_t* in, uint8_t* out, uint64_t remaining, block_t w, block_t checksum, block_t delta_m, block_t delta_c, uint64_t iteration_counter, uint8_t tag_interval, uint8_t* tag_out, uint64_t* tag_len)
+{
+	const block_t* aes_round_keys = ctx->aes_encryption_keys;
+	uint8_t buf[BLOCKSIZE] = { 0 };
+	block_t block, tag, w_tmp;
+
+	memcpy(buf, in, remaining);
+
+	delta_m = gf_mul7(delta_m);
+	delta_c = gf_mul7(delta_c);
+
+	// pad if nessesary
+	if (remaining < BLOCKSIZE) {
+		buf[remaining] = 0x80;
+		delta_m = gf_mul7(delta_m);
+		delta_c = gf_mul7(delta_c);
+	}
+
+	block = checksum = XOR_BLOCK(checksum, LOAD_BLOCK(buf));
+	block = XOR_BLOCK(block, delta_m);
+	AES_ENCRYPT(block, aes_round_keys);
+	RHO_INPLACE(block, w, w_tmp);
+	AES_ENCRYPT(block, aes_round_keys);
+	block = XOR_BLOCK(block, delta_c);
+	STORE_BLOCK(out, block);
+
+	out += BLOCKSIZE;
+
+	// intermediate tag after the last block
+	if (tag_interval && iteration_counter % tag_interval == 0)
+	{
+		delta_c = gf_mul2(delta_c);
+		tag = w;
+		AES_ENCRYPT(tag, aes_round_keys);
+		tag = XOR_BLOCK(tag, delta_c);
+		STORE_BLOCK(tag_out, tag);
+		*tag_len += BLOCKSIZE;
+	}
+
+	if (remaining == 0) return 0;
+
+	delta_m = gf_mul2(delta_m);
+	delta_c = gf_mul2(delta_c);
+
+	block = XOR_BLOCK(delta_m, checksum);
+	AES_ENCRYPT(block, aes_round_keys);
+	RHO_INPLACE(block, w, w_tmp);
+	AES_ENCRYPT(block, aes_round_keys);
+	block = XOR_BLOCK(block, delta_c);
+
+	STORE_BLOCK(buf, block);
+	memcpy(out, buf, remaining);
+
+	return 0;
+}
+
+// returns 1 if the message is too short to be split (nothing has been done then), -6 without AES instructions
+static int8_t encrypt_threaded(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags, uint8_t tag_interval)
+{
+	const colm_backend* b = colm_backend_active();
+	segment segments[COLM_MAX_THREADS];
+	uint64_t blocks = message_len > 0 ? (message_len - 1) / BLOCKSIZE : 0; // all blocks before the last one
+	uint64_t param = tag_interval ? COLM127_PARAM : COLM0_PARAM;
+	block_t w, checksum = ZERO_BLOCK(), factor;
+	uint8_t count, i;
+
+	if (b == NULL)
+	{
+		return -6;
+	}
+
+	count = split_segments(pool, ctx, message, ciphertext, tags, blocks, tag_interval, segments);
+	if (count < 2)
+	{
+		return 1;
+	}
+
+	*c_len = message_len + BLOCKSIZE;
+
+	w = b->mac(ctx, NONCE_BLOCK(npub, param), associated_data, data_len);
+
+	run_segments(pool, encrypt_first_layer_job, segments, count);
+
+	// chain the segments: W_end = 2^k * W_start + sum (the segments differ by at most one block)
+	factor = gf_pow2(segments[count - 1].blocks);
+	for (i = 0; i < count; i++)
+	{
+		segments[i].w = w;
+		w = XOR_BLOCK(gf_mul(w, segments[i].blocks == segments[count - 1].blocks ? factor : gf_mul2(factor)), segments[i].sum);
+		checksum = XOR_BLOCK(checksum, segments[i].checksum);
+	}
+
+	run_segments(pool, encrypt_second_layer_job, segments, count);
+
+	if (tag_interval)
+	{
+		*tag_len += blocks / tag_interval * BLOCKSIZE;
+	}
+
+	return encrypt_final(ctx, message + blocks * BLOCKSIZE, ciphertext + blocks * BLOCKSIZE, message_len - blocks * BLOCKSIZE, w, checksum,
+	                     gf_mul_pow2(ctx->L, blocks), delta_c_after(ctx, blocks, tag_interval),
+	                     blocks + 1, tag_interval, tags + (tag_interval ? blocks / tag_interval : 0) * BLOCKSIZE, tag_len);
+}
+
+
+
+/* ----------------------- DECRYPTION ------------------------- */
+
+// the last (maybe partial) block and verification of the final tag, same as in colm_parallel.c
+static int8_t decrypt_final(const colm_key_ctx* ctx, const uint8_t* in, uint8_t* out, uint64_t remaining, block_t w, block_t checksum, block_t delta_m, block_t delta_c, uint64_t iteration_counter, uint8_t tag_interval, const uint8_t* tag_in)
+{
+	const block_t* aes_encryption_keys = ctx->aes_encryption_keys;
+	const block_t* aes_decryption_keys = ctx->aes_decryption_keys;
+	uint8_t buf[BLOCKSIZE] = { 0 };
+	block_t block, tag, w_tmp;
+	uint32_t i;
+
+	delta_m = gf_mul7(delta_m);
+	delta_c = gf_mul7(delta_c);
+
+	if (remaining < BLOCKSIZE) {
+		delta_m = gf_mul7(delta_m);
+		delta_c = gf_mul7(delta_c);
+	}
+
+	block = XOR_BLOCK(LOAD_BLOCK(in), delta_c);
+	AES_DECRYPT(block, aes_decryption_keys);
+	RHO_INVERSE_INPLACE(block, w, w_tmp);
+	AES_DECRYPT(block, aes_decryption_keys);
+	block = XOR_BLOCK(block, delta_m);
+
+	checksum = XOR_BLOCK(checksum, block);
+	in += BLOCKSIZE;
+
+	STORE_BLOCK(buf, checksum);
+	memcpy(out, buf, remaining);
+
+	// intermediate tag after the last block
+	if (tag_interval && iteration_counter % tag_interval == 0)
+	{
+		delta_c = gf_mul2(delta_c);
+		tag = XOR_BLOCK(LOAD_BLOCK(tag_in), delta_c);
+		AES_DECRYPT(tag, aes_decryption_keys);
+		if (!EQUALS(tag, w))
+		{
+			return -5;
+		}
+	}
+
+	delta_m = gf_mul2(delta_m);
+	delta_c = gf_mul2(delta_c);
+
+	block = XOR_BLOCK(delta_m, block);
+	AES_ENCRYPT(block, aes_encryption_keys);
+	RHO_INPLACE(block, w, w_tmp);
+	AES_ENCRYPT(block, aes_encryption_keys);
+	block = XOR_BLOCK(block, delta_c);
+
+	STORE_BLOCK(buf, block);
+	if (memcmp(in, buf, remaining) != 0) {
+		return -2;
+	}
+
+	if (remaining < BLOCKSIZE) {
+		STORE_BLOCK(buf, checksum);
+		if (buf[remaining] != 0x80) {
+			return -3;
+		}
+		for (i = remaining + 1; i < BLOCKSIZE; i++) {
+			if (buf[i] != 0) {
+				return -4;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// returns 1 if the message is too short to be split (nothing has been done then), -6 without AES instructions
+static int8_t decrypt_threaded(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint8_t* tags, uint64_t* m_len, uint8_t* message, uint8_t tag_interval)
+{
+	const colm_backend* b = colm_backend_active();
+	segment segments[COLM_MAX_THREADS];
+	uint64_t message_len, blocks;
+	uint64_t param = tag_interval ? COLM127_PARAM : COLM0_PARAM;
+	block_t w, checksum = ZERO_BLOCK();
+	uint8_t count, i;
+	int8_t result;
+
+	if (b == NULL)
+	{
+		return -6;
+	}
+
+	if (len < BLOCKSIZE)
+	{
+		return 1; // the single threaded functions report the error
+	}
+
+	message_len = len - BLOCKSIZE;
+	blocks = message_len > 0 ? (message_len - 1) / BLOCKSIZE : 0;
+
+	count = split_segments(pool, ctx, ciphertext, message, tags, blocks, tag_interval, segments);
+	if (count < 2)
+	{
+		return 1;
+	}
+
+	*m_len = message_len;
+
+	w = b->mac(ctx, NONCE_BLOCK(npub, param), associated_data, data_len);
+
+	run_segments(pool, decrypt_first_layer_job, segments, count);
+
+	// chain the segments: W_end = W_start + sum
+	for (i = 0; i < count; i++)
+	{
+		segments[i].w = w;
+		w = XOR_BLOCK(w, segments[i].sum);
+	}
+
+	result = run_segments(pool, decrypt_second_layer_job, segments, count);
+	if (result != 0)
+	{
+		return result;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		checksum = XOR_BLOCK(checksum, segments[i].checksum);
+	}
+
+	return decrypt_final(ctx, ciphertext + blocks * BLOCKSIZE, message + blocks * BLOCKSIZE, message_len - blocks * BLOCKSIZE, w, checksum,
+	                     gf_mul_pow2(ctx->L, blocks), delta_c_after(ctx, blocks, tag_interval),
+	                     blocks + 1, tag_interval, tags + (tag_interval ? blocks / tag_interval : 0) * BLOCKSIZE);
+}
+
+
+
+/*
+ * COLM127: the threads get whole segments of 127 blocks. The state at the start of a segment is the decryption of the tag before it,
+ * so there is no first pass over the message, every thread decrypts and verifies its segments at once. The blocks after the
+ * last segment are processed by the calling thread, starting from the state of the last tag.
+ * pool == NULL (or a busy pool): everything by the calling thread. *failed = segment with the first invalid tag
+ */
+static int8_t decrypt_segments_threaded(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message, uint64_t* failed)
+{
+	const colm_backend* b = colm_backend_active();
+	segment segments[COLM_MAX_THREADS];
+	uint64_t message_len, blocks, segment_count, tail, first = 0, size;
+	block_t w, checksum = ZERO_BLOCK();
+	colm_state st;
+	uint8_t count = 1, i;
+	int8_t result;
+
+	if (b == NULL)
+	{
+		return -6;
+	}
+
+	if (len < BLOCKSIZE)
+	{
+		// -1 => invalid size of ciphertext
+		return -1;
+	}
+
+	message_len = len - BLOCKSIZE;
+	blocks = message_len > 0 ? (message_len - 1) / BLOCKSIZE : 0; // all blocks before the last one
+	segment_count = blocks / 127;
+	tail = blocks - segment_count * 127;
+
+	// -1 => not all intermediate tags there
+	if (tag_len / BLOCKSIZE < (blocks + 1) / 127)
+	{
+		return -1;
+	}
+
+	*m_len = message_len;
+
+	w = b->mac(ctx, NONCE_BLOCK(npub, COLM127_PARAM), associated_data, data_len);
+
+	if (pool != NULL)
+	{
+		size = blocks / COLM_THREAD_MIN_BLOCKS;
+		size = size < pool->count ? size : pool->count;
+		size = size < segment_count ? size : segment_count;
+		count = size > 0 ? (uint8_t)size : 1;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		size = segment_count / count + (i < segment_count % count ? 1 : 0);
+
+		segments[i].ctx = ctx;
+		segments[i].in = ciphertext + first * 127 * BLOCKSIZE;
+		segments[i].out = message + first * 127 * BLOCKSIZE;
+		segments[i].tags = tags;
+		segments[i].first = first * 127 + 1;
+		segments[i].blocks = size * 127;
+		segments[i].tag_interval = 127;
+		segments[i].w = w;
+		segments[i].result = 0;
+
+		first += size;
+	}
+
+	if (count > 1)
+	{
+		run_segments(pool, decrypt_segments_job, segments, count);
+	}
+	else
+	{
+		segments[0].result = decrypt_segments_job(&segments[0]);
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (segments[i].result != 0)
+		{
+			*failed = segments[i].failed;
+			return segments[i].result;
+		}
+		checksum = XOR_BLOCK(checksum, segments[i].checksum);
+	}
+
+	// the blocks after the last segment
+	colm127_segment_start(ctx, w, tags, segment_count, &st);
+	b->decrypt_blocks(ctx, &st, ciphertext + segment_count * 127 * BLOCKSIZE, message + segment_count * 127 * BLOCKSIZE, tail);
+
+	result = decrypt_final(ctx, ciphertext + blocks * BLOCKSIZE, message + blocks * BLOCKSIZE, message_len - blocks * BLOCKSIZE, st.w, XOR_BLOCK(checksum, st.checksum),
+	                       st.delta_m, st.delta_c, blocks + 1, 127, tags + segment_count * BLOCKSIZE);
+	if (result == -5)
+	{
+		*failed = segment_count;
+	}
+
+	return result;
+}
+
+
+
+/* ----------------------- PUBLIC API ------------------------- */
+
+// messages that are too short to be split (or no pool) are processed by the calling thread alone
+
+int8_t colm0_encrypt_threaded(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext)
+{
+	int8_t result = 1;
+
+	if (pool != NULL && pthread_mutex_trylock(&pool->busy) == 0)
+	{
+		result = encrypt_threaded(pool, ctx, message, message_len, associated_data, data_len, npub, c_len, ciphertext, NULL, NULL, 0);
+		pthread_mutex_unlock(&pool->busy);
+	}
+
+	return result == 1 ? colm0_encrypt_ctx(ctx, message, message_len, associated_data, data_len, npub, c_len, ciphertext) : result;
+}
+
+int8_t colm0_decrypt_threaded(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* m_len, uint8_t* message)
+{
+	int8_t result = 1;
+
+	if (pool != NULL && pthread_mutex_trylock(&pool->busy) == 0)
+	{
+		result = decrypt_threaded(pool, ctx, ciphertext, len, associated_data, data_len, npub, NULL, m_len, message, 0);
+		pthread_mutex_unlock(&pool->busy);
+	}
+
+	return result == 1 ? colm0_decrypt_ctx(ctx, ciphertext, len, associated_data, data_len, npub, m_len, message) : result;
+}
+
+int8_t colm127_encrypt_threaded(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* message, uint64_t message_len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags)
+{
+	int8_t result = 1;
+
+	if (pool != NULL && pthread_mutex_trylock(&pool->busy) == 0)
+	{
+		result = encrypt_threaded(pool, ctx, message, message_len, associated_data, data_len, npub, c_len, ciphertext, tag_len, tags, 127);
+		pthread_mutex_unlock(&pool->busy);
+	}
+
+	return result == 1 ? colm127_encrypt_ctx(ctx, message, message_len, associated_data, data_len, npub, c_len, ciphertext, tag_len, tags) : result;
+}
+
+int8_t colm127_decrypt_threaded(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message)
+{
+	uint64_t failed;
+
+	return colm127_decrypt_threaded_report(pool, ctx, ciphertext, len, associated_data, data_len, npub, tag_len, tags, m_len, message, &failed);
+}
+
+int8_t colm127_decrypt_threaded_report(colm_thread_pool* pool, const colm_key_ctx* ctx, uint8_t* ciphertext, uint64_t len, uint8_t* associated_data, uint64_t data_len, uint64_t npub, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message, uint64_t* failed_segment)
+{
+	int8_t result;
+
+	if (pool != NULL && pthread_mutex_trylock(&pool->busy) == 0)
+	{
+		result = decrypt_segments_threaded(pool, ctx, ciphertext, len, associated_data, data_len, npub, tag_len, tags, m_len, message, failed_segment);
+		pthread_mutex_unlock(&pool->busy);
+		return result;
+	}
+
+	return decrypt_segments_threaded(NULL, ctx, ciphertext, len, associated_data, data_len, npub, tag_len, tags, m_len, message, failed_segment);
+}
+
+AES_TARGET_END
@@ -0,0 +1,603 @@
+/*
+ * Wide implementation of COLM0 for x86-64 CPUs with VAES and AVX-512 (Ice Lake and later).
+ * Both AES layers and the MAC of the authenticated data have no dependency between the blocks, so they run on 16 blocks at a time
+ * (4 registers with 4 blocks each). Only the rho chain in between runs on single blocks (colm_rho.h).
+ * COLM127 and the key setup are taken from the pipelined implementation.
+ */
+
+#include "colm.h"
+#include "colm_backend.h"
+#include "colm_rho.h"
+#include "colm_delta.h"
+
+#if defined(AES_CRYPTO_X86)
+
+#include "aes_crypto_vaes.h"
+
+// everything below uses VAES and AVX-512 (see aes_crypto_vaes.h)
+VAES_TARGET_BEGIN
+
+#define RHO_INVERSE_WIDE(y, st, w_new) do { \
+											block_t lane0 = WIDE_EXTRACT(y, 0), lane1 = WIDE_EXTRACT(y, 1), lane2 = WIDE_EXTRACT(y, 2), lane3 = WIDE_EXTRACT(y, 3); \
+											RHO_INVERSE_INPLACE(lane0, st, w_new); \
+											RHO_INVERSE_INPLACE(lane1, st, w_new); \
+											RHO_INVERSE_INPLACE(lane2, st, w_new); \
+											RHO_INVERSE_INPLACE(lane3, st, w_new); \
+											y = wide_set(lane0, lane1, lane2, lane3); \
+										} while(0)
+
+// n is the number of wide registers (1 - 4), a compile time constant inside of the functions
+#define WIDE static inline __attribute__((always_inline))
+#define MAX_WIDE_REGISTERS 4
+
+// rho on the 4 * n blocks of n wide registers (colm_rho.h, with the lookahead all 16 blocks of a group share one chain step)
+WIDE void rho_wide(wide_block_t* x, block_t* st, const uint8_t n)
+{
+	block_t lanes[WIDE_LANES * MAX_WIDE_REGISTERS];
+	uint8_t k;
+
+	UNROLL_LANES
+	for (k = 0; k < n; k++)
+	{
+		lanes[4 * k] = WIDE_EXTRACT(x[k], 0);
+		lanes[4 * k + 1] = WIDE_EXTRACT(x[k], 1);
+		lanes[4 * k + 2] = WIDE_EXTRACT(x[k], 2);
+		lanes[4 * k + 3] = WIDE_EXTRACT(x[k], 3);
+	}
+
+	rho_group(lanes, st, WIDE_LANES * n);
+
+	UNROLL_LANES
+	for (k = 0; k < n; k++)
+	{
+		x[k] = wide_set(lanes[4 * k], lanes[4 * k + 1], lanes[4 * k + 2], lanes[4 * k + 3]);
+	}
+}
+
+
+/*
+ * The deltas of the next 4 * n blocks: deltas[k] holds delta * 2^(4k + 1) ... delta * 2^(4k + 4) (window: see lane_deltas in colm_delta.h).
+ * From then on all lanes are moved forward together (wide_gf_mul_pow2), the doubling chain is no longer serial.
+ */
+WIDE void wide_deltas(block_t delta, const block_t* window, wide_block_t* deltas, const uint8_t n)
+{
+	block_t lanes[WIDE_LANES * MAX_WIDE_REGISTERS];
+	uint8_t k;
+
+	lane_deltas(delta, window, lanes, WIDE_LANES * n);
+
+	UNROLL_LANES
+	for (k = 0; k < n; k++)
+	{
+		deltas[k] = wide_set(lanes[4 * k], lanes[4 * k + 1], lanes[4 * k + 2], lanes[4 * k + 3]);
+	}
+}
+
+WIDE void wide_deltas_next(wide_block_t* deltas, const uint8_t n)
+{
+	uint8_t k;
+
+	UNROLL_LANES
+	for (k = 0; k < n; k++)
+	{
+		deltas[k] = wide_gf_mul_pow2(deltas[k], WIDE_LANES * n);
+	}
+}
+
+
+
+/* ----------------------- MAC ------------------------- */
+
+// processes the authenticated data as long as at least 4 * n blocks are left, delta and v are updated
+WIDE void mac_wide_blocks(const uint8_t** in, uint64_t* len, block_t* delta, const block_t* window, block_t* v, const wide_block_t* wide_keys, const uint8_t n)
+{
+	wide_block_t blocks[MAX_WIDE_REGISTERS], deltas[MAX_WIDE_REGISTERS];
+	wide_block_t sum = WIDE_ZERO();
+	uint8_t k;
+
+	if (*len < n * WIDE_LANES * BLOCKSIZE)
+	{
+		return;
+	}
+
+	wide_deltas(*delta, window, deltas, n);
+
+	while (*len >= n * WIDE_LANES * BLOCKSIZE)
+	{
+		UNROLL_LANES
+		for (k = 0; k < n; k++)
+		{
+			blocks[k] = WIDE_XOR(WIDE_LOAD(*in + k * WIDE_LANES * BLOCKSIZE), deltas[k]);
+		}
+
+		AES_ENCRYPT_WIDE(blocks, n, wide_keys);
+
+		UNROLL_LANES
+		for (k = 0; k < n; k++)
+		{
+			sum = WIDE_XOR(sum, blocks[k]);
+		}
+
+		*delta = WIDE_EXTRACT(deltas[n - 1], 3);
+		wide_deltas_next(deltas, n);
+
+		*in += n * WIDE_LANES * BLOCKSIZE;
+		*len -= n * WIDE_LANES * BLOCKSIZE;
+	}
+
+	*v = XOR_BLOCK(*v, wide_fold(sum));
+}
+
+// same as mac() of colm_parallel.c, used by COLM0 and COLM127
+static block_t mac_vaes(const colm_key_ctx* ctx, block_t npub_param, uint8_t* associated_data, uint64_t data_len)
+{
+	const uint8_t* in = associated_data;
+	uint64_t len = data_len;
+	uint8_t buf[BLOCKSIZE] = { 0 };
+	block_t block, v;
+	block_t delta = ctx->delta_ad;
+	const block_t* aes_round_keys = ctx->aes_encryption_keys;
+	wide_block_t wide_keys[11];
+	COLM_STATS_DECLARE;
+
+	COLM_STATS_START();
+	WIDE_SET_KEYS(aes_round_keys, wide_keys);
+
+	v = XOR_BLOCK(SWAP_BLOCK(npub_param), delta);
+	AES_ENCRYPT(v, aes_round_keys);
+
+	mac_wide_blocks(&in, &len, &delta, ctx->delta_ad_window, &v, wide_keys, 4);
+	mac_wide_blocks(&in, &len, &delta, DELTA_WINDOW(delta, ctx->delta_ad, ctx->delta_ad_window), &v, wide_keys, 1);
+
+	// at most 3 full blocks are left
+	while (len >= BLOCKSIZE)
+	{
+		delta = gf_mul2(delta);
+		block = XOR_BLOCK(LOAD_BLOCK(in), delta);
+		AES_ENCRYPT(block, aes_round_keys);
+		v = XOR_BLOCK(v, block);
+		in += BLOCKSIZE;
+		len -= BLOCKSIZE;
+	}
+
+	if (len > 0) { /* last block partial */
+		delta = gf_mul7(delta);
+		memcpy(buf, in, len);
+		buf[len] ^= 0x80; /* padding */
+		block = XOR_BLOCK(LOAD_BLOCK(buf), delta);
+		AES_ENCRYPT(block, aes_round_keys);
+		v = XOR_BLOCK(v, block);
+	}
+	COLM_STATS_PHASE(COLM_PHASE_MAC, 1 + (data_len + BLOCKSIZE - 1) / BLOCKSIZE);
+
+	return v;
+}
+
+
+
+/* ----------------------- COLM 0 ------------------------- */
+
+// encrypts as long as more than 4 * n blocks are left (the last block is always handled by the caller)
+WIDE void colm0_encrypt_wide_blocks(const uint8_t** in, uint8_t** out, uint64_t* remaining, block_t* w, wide_block_t* checksum, block_t* delta_m, block_t* delta_c, const colm_key_ctx* ctx, const wide_block_t* wide_keys, const uint8_t n)
+{
+	wide_block_t blocks[MAX_WIDE_REGISTERS], deltas_m[MAX_WIDE_REGISTERS], deltas_c[MAX_WIDE_REGISTERS];
+	block_t st = *w;
+	uint8_t k;
+	COLM_STATS_DECLARE;
+
+	if (*remaining <= n * WIDE_LANES * BLOCKSIZE)
+	{
+		return;
+	}
+
+	wide_deltas(*delta_m, DELTA_WINDOW(*delta_m, ctx->L, ctx->delta_m_window), deltas_m, n);
+	wide_deltas(*delta_c, DELTA_WINDOW(*delta_c, ctx->delta_c, ctx->delta_c_window), deltas_c, n);
+
+	while (*remaining > n * WIDE_LANES * BLOCKSIZE)
+	{
+		COLM_STATS_START();
+		UNROLL_LANES
+		for (k = 0; k < n; k++)
+		{
+			blocks[k] = WIDE_LOAD(*in + k * WIDE_LANES * BLOCKSIZE);
+			*checksum = WIDE_XOR(*checksum, blocks[k]);
+			blocks[k] = WIDE_XOR(blocks[k], deltas_m[k]);
+		}
+
+		AES_ENCRYPT_WIDE(blocks, n, wide_keys);
+		COLM_STATS_PHASE(COLM_PHASE_LAYER1, n * WIDE_LANES);
+
+		rho_wide(blocks, &st, n);
+		COLM_STATS_PHASE(COLM_PHASE_RHO, n * WIDE_LANES);
+
+		AES_ENCRYPT_WIDE(blocks, n, wide_keys);
+
+		UNROLL_LANES
+		for (k = 0; k < n; k++)
+		{
+			WIDE_STORE(*out + k * WIDE_LANES * BLOCKSIZE, WIDE_XOR(blocks[k], deltas_c[k]));
+		}
+		COLM_STATS_PHASE(COLM_PHASE_LAYER2, n * WIDE_LANES);
+
+		*delta_m = WIDE_EXTRACT(deltas_m[n - 1], 3);
+		*delta_c = WIDE_EXTRACT(deltas_c[n - 1], 3);
+		wide_deltas_next(deltas_m, n);
+		wide_deltas_next(deltas_c, n);
+
+		*in += n * WIDE_LANES * BLOCKSIZE;
+		*out += n * WIDE_LANES * BLOCKSIZE;
+		*remaining -= n * WIDE_LANES * BLOCKSIZE;
+	}
+
+	*w = st;
+}
+
+static int8_t colm0_encrypt_vaes(const colm_key_ctx* ctx, block_t w, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext)
+{
+	block_t checksum;
+	block_t w_tmp;
+	block_t block;
+	const block_t* aes_round_keys = ctx->aes_encryption_keys;
+	wide_block_t wide_keys[11];
+	wide_block_t wide_checksum = WIDE_ZERO();
+	block_t delta_m, delta_c;
+
+	const uint8_t* in = message;
+	uint8_t* out = ciphertext;
+	uint64_t remaining = message_len;
+	uint8_t buf[BLOCKSIZE] = { 0 };
+	COLM_STATS_DECLARE;
+
+	*c_len = message_len + BLOCKSIZE;
+
+	if (message_len <= COLM_SHORT_LEN)
+	{
+		return colm0_encrypt_short(ctx, w, message, message_len, ciphertext);
+	}
+
+	WIDE_SET_KEYS(aes_round_keys, wide_keys);
+
+	delta_m = ctx->L;
+	delta_c = ctx->delta_c;
+
+	// 16 blocks at a time, then 4
+	colm0_encrypt_wide_blocks(&in, &out, &remaining, &w, &wide_checksum, &delta_m, &delta_c, ctx, wide_keys, 4);
+	colm0_encrypt_wide_blocks(&in, &out, &remaining, &w, &wide_checksum, &delta_m, &delta_c, ctx, wide_keys, 1);
+
+	COLM_STATS_START();
+	COLM_STATS_BLOCKS(COLM_PHASE_TAIL, (remaining + BLOCKSIZE - 1) / BLOCKSIZE);
+	checksum = wide_fold(wide_checksum);
+
+	// at most 3 full blocks (and the last block) are left
+	while (remaining > BLOCKSIZE)
+	{
+		delta_m = gf_mul2(delta_m);
+		delta_c = gf_mul2(delta_c);
+
+		block = LOAD_BLOCK(in);
+		checksum = XOR_BLOCK(checksum, block);
+		block = XOR_BLOCK(block, delta_m);
+		AES_ENCRYPT(block, aes_round_keys);
+		RHO_INPLACE(block, w, w_tmp);
+		AES_ENCRYPT(block, aes_round_keys);
+		block = XOR_BLOCK(block, delta_c);
+		STORE_BLOCK(out, block);
+
+		in += BLOCKSIZE;
+		out += BLOCKSIZE;
+		remaining -= BLOCKSIZE;
+	}
+
+	// handdle remaining bytes
+	memcpy(buf, in, remaining);
+
+	delta_m = gf_mul7(delta_m);
+	delta_c = gf_mul7(delta_c);
+
+	// pad if nessesary
+	if (remaining < BLOCKSIZE) {
+		buf[remaining] = 0x80;
+		delta_m = gf_mul7(delta_m);
+		delta_c = gf_mul7(delta_c);
+	}
+
+	block = checksum = XOR_BLOCK(checksum, LOAD_BLOCK(buf));
+	block = XOR_BLOCK(block, delta_m);
+	AES_ENCRYPT(block, aes_round_keys);
+	RHO_INPLACE(block, w, w_tmp);
+	AES_ENCRYPT(block, aes_round_keys);
+	block = XOR_BLOCK(block, delta_c);
+	STORE_BLOCK(out, block);
+
+	out += BLOCKSIZE;
+	COLM_STATS_PHASE(COLM_PHASE_TAIL, 0);
+
+	if (remaining == 0) return 0;
+
+	// add tag
+	delta_m = gf_mul2(delta_m);
+	delta_c = gf_mul2(delta_c);
+
+	block = XOR_BLOCK(delta_m, checksum);
+	AES_ENCRYPT(block, aes_round_keys);
+	RHO_INPLACE(block, w, w_tmp);
+	AES_ENCRYPT(block, aes_round_keys);
+	block = XOR_BLOCK(block, delta_c);
+
+	STORE_BLOCK(buf, block);
+	memcpy(out, buf, remaining);
+	COLM_STATS_PHASE(COLM_PHASE_TAIL, 1);
+
+	return 0;
+}
+
+// short messages with short associated data in one pass (colm0_encrypt_mac_short), the others MAC first
+static int8_t colm0_encrypt_mac_vaes(const colm_key_ctx* ctx, block_t npub_param, uint8_t* associated_data, uint64_t data_len, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext)
+{
+	if (message_len <= COLM_SHORT_LEN && data_len <= COLM_SHORT_AD_LEN)
+	{
+		*c_len = message_len + BLOCKSIZE;
+		return colm0_encrypt_mac_short(ctx, npub_param, associated_data, data_len, message, message_len, ciphertext);
+	}
+	return colm0_encrypt_vaes(ctx, mac_vaes(ctx, npub_param, associated_data, data_len), message, message_len, c_len, ciphertext);
+}
+
+// decrypts as long as more than 4 * n blocks are left (the last block and the tag are always handled by the caller), *out == NULL => nothing is stored
+WIDE void colm0_decrypt_wide_blocks(const uint8_t** in, uint8_t** out, uint64_t* remaining, block_t* w, wide_block_t* checksum, block_t* delta_m, block_t* delta_c, const colm_key_ctx* ctx, const wide_block_t* wide_keys, const uint8_t n)
+{
+	wide_block_t blocks[MAX_WIDE_REGISTERS], deltas_m[MAX_WIDE_REGISTERS], deltas_c[MAX_WIDE_REGISTERS];
+	block_t st = *w, w_tmp;
+	uint8_t k;
+	COLM_STATS_DECLARE;
+
+	if (*remaining <= n * WIDE_LANES * BLOCKSIZE)
+	{
+		return;
+	}
+
+	wide_deltas(*delta_m, DELTA_WINDOW(*delta_m, ctx->L, ctx->delta_m_window), deltas_m, n);
+	wide_deltas(*delta_c, DELTA_WINDOW(*delta_c, ctx->delta_c, ctx->delta_c_window), deltas_c, n);
+
+	while (*remaining > n * WIDE_LANES * BLOCKSIZE)
+	{
+		COLM_STATS_START();
+		UNROLL_LANES
+		for (k = 0; k < n; k++)
+		{
+			blocks[k] = WIDE_XOR(WIDE_LOAD(*in + k * WIDE_LANES * BLOCKSIZE), deltas_c[k]);
+		}
+
+		AES_DECRYPT_WIDE(blocks, n, wide_keys);
+		COLM_STATS_PHASE(COLM_PHASE_LAYER1, n * WIDE_LANES);
+
+		UNROLL_LANES
+		for (k = 0; k < n; k++)
+		{
+			RHO_INVERSE_WIDE(blocks[k], st, w_tmp);
+		}
+		COLM_STATS_PHASE(COLM_PHASE_RHO, n * WIDE_LANES);
+
+		AES_DECRYPT_WIDE(blocks, n, wide_keys);
+
+		UNROLL_LANES
+		for (k = 0; k < n; k++)
+		{
+			blocks[k] = WIDE_XOR(blocks[k], deltas_m[k]);
+			*checksum = WIDE_XOR(*checksum, blocks[k]);
+		}
+
+		if (*out != NULL)
+		{
+			UNROLL_LANES
+			for (k = 0; k < n; k++)
+			{
+				WIDE_STORE(*out + k * WIDE_LANES * BLOCKSIZE, blocks[k]);
+			}
+			*out += n * WIDE_LANES * BLOCKSIZE;
+		}
+		COLM_STATS_PHASE(COLM_PHASE_LAYER2, n * WIDE_LANES);
+
+		*delta_m = WIDE_EXTRACT(deltas_m[n - 1], 3);
+		*delta_c = WIDE_EXTRACT(deltas_c[n - 1], 3);
+		wide_deltas_next(deltas_m, n);
+		wide_deltas_next(deltas_c, n);
+
+		*in += n * WIDE_LANES * BLOCKSIZE;
+		*remaining -= n * WIDE_LANES * BLOCKSIZE;
+	}
+
+	*w = st;
+}
+
+static int8_t colm0_decrypt_vaes(const colm_key_ctx* ctx, block_t w, uint8_t* ciphertext, uint64_t len, uint64_t* m_len, uint8_t* message)
+{
+	block_t checksum;
+	block_t w_tmp;
+	block_t block;
+	const block_t* aes_encryption_keys = ctx->aes_encryption_keys;
+	const block_t* aes_decryption_keys = ctx->aes_decryption_keys;
+	wide_block_t wide_decryption_keys[11];
+	wide_block_t wide_checksum = WIDE_ZERO();
+	block_t delta_m, delta_c;
+
+	const uint8_t* in = ciphertext;
+	uint8_t* out = message;
+	uint64_t remaining;
+	uint32_t i;
+	uint8_t buf[BLOCKSIZE] = { 0 };
+	COLM_STATS_DECLARE;
+
+	if (len < BLOCKSIZE)
+	{
+		// -1 => invalid size of ciphertext
+		return -1;
+	}
+
+	remaining = *m_len = len - BLOCKSIZE;
+
+	if (remaining <= COLM_SHORT_LEN)
+	{
+		return colm0_decrypt_short(ctx, w, ciphertext, len, message);
+	}
+
+	WIDE_SET_KEYS(aes_decryption_keys, wide_decryption_keys);
+
+	delta_m = ctx->L;
+	delta_c = ctx->delta_c;
+
+	// 16 blocks at a time, then 4
+	colm0_decrypt_wide_blocks(&in, &out, &remaining, &w, &wide_checksum, &delta_m, &delta_c, ctx, wide_decryption_keys, 4);
+	colm0_decrypt_wide_blocks(&in, &out, &remaining, &w, &wide_checksum, &delta_m, &delta_c, ctx, wide_decryption_keys, 1);
+
+	COLM_STATS_START();
+	COLM_STATS_BLOCKS(COLM_PHASE_TAIL, (remaining + BLOCKSIZE - 1) / BLOCKSIZE);
+	checksum = wide_fold(wide_checksum);
+
+	// at most 3 full blocks (and the last block) are left
+	while (remaining > BLOCKSIZE) {
+		delta_m = gf_mul2(delta_m);
+		delta_c = gf_mul2(delta_c);
+
+		block = XOR_BLOCK(LOAD_BLOCK(in), delta_c);
+		AES_DECRYPT(block, aes_decryption_keys);
+		RHO_INVERSE_INPLACE(block, w, w_tmp);
+		AES_DECRYPT(block, aes_decryption_keys);
+		block = XOR_BLOCK(block, delta_m);
+
+		checksum = XOR_BLOCK(checksum, block);
+		if (out != NULL)
+		{
+			STORE_BLOCK(out, block);
+			out += BLOCKSIZE;
+		}
+
+		in += BLOCKSIZE;
+		remaining -= BLOCKSIZE;
+	}
+
+	// finish up the decryption (see colm_parallel.c)
+	delta_m = gf_mul7(delta_m);
+	delta_c = gf_mul7(delta_c);
+
+	if (remaining < BLOCKSIZE) {
+		delta_m = gf_mul7(delta_m);
+		delta_c = gf_mul7(delta_c);
+	}
+
+	block = XOR_BLOCK(LOAD_BLOCK(in), delta_c);
+	AES_DECRYPT(block, aes_decryption_keys);
+	RHO_INVERSE_INPLACE(block, w, w_tmp);
+	AES_DECRYPT(block, aes_decryption_keys);
+	block = XOR_BLOCK(block, delta_m);
+
+	checksum = XOR_BLOCK(checksum, block);
+	in += BLOCKSIZE;
+
+	if (out != NULL)
+	{
+		STORE_BLOCK(buf, checksum);
+		memcpy(out, buf, remaining);
+	}
+
+	// recompute the tag
+	delta_m = gf_mul2(delta_m);
+	delta_c = gf_mul2(delta_c);
+
+	block = XOR_BLOCK(delta_m, block);
+	AES_ENCRYPT(block, aes_encryption_keys);
+	RHO_INPLACE(block, w, w_tmp);
+	AES_ENCRYPT(block, aes_encryption_keys);
+	block = XOR_BLOCK(block, delta_c);
+
+	STORE_BLOCK(buf, block);
+	COLM_STATS_PHASE(COLM_PHASE_TAIL, 1);
+
+	if (memcmp(in, buf, remaining) != 0) {
+		return -2;
+	}
+
+	if (remaining < BLOCKSIZE) {
+		STORE_BLOCK(buf, checksum);
+		// check padding
+		if (buf[remaining] != 0x80) {
+			return -3;
+		}
+		for (i = remaining + 1; i < BLOCKSIZE; i++) {
+			if (buf[i] != 0) {
+				return -4;
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+
+/* ----------------------- BACKEND ------------------------- */
+
+// no wide version of these (yet), the intermediate tags of COLM127 break the 16 block groups (only their MAC is wide)
+
+static int8_t key_ctx_init_vaes(colm_key_ctx* ctx, block_t key)
+{
+	return colm_backend_pipelined.key_ctx_init(ctx, key);
+}
+
+// streaming: 16 blocks at a time as above, the rest (less than 4) pipelined
+static void encrypt_blocks_vaes(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, uint64_t full_blocks)
+{
+	wide_block_t wide_keys[11];
+	wide_block_t wide_checksum = WIDE_ZERO();
+	uint64_t remaining = full_blocks * BLOCKSIZE;
+
+	WIDE_SET_KEYS(ctx->aes_encryption_keys, wide_keys);
+
+	colm0_encrypt_wide_blocks(&in, &out, &remaining, &st->w, &wide_checksum, &st->delta_m, &st->delta_c, ctx, wide_keys, 4);
+	colm0_encrypt_wide_blocks(&in, &out, &remaining, &st->w, &wide_checksum, &st->delta_m, &st->delta_c, ctx, wide_keys, 1);
+	st->checksum = XOR_BLOCK(st->checksum, wide_fold(wide_checksum));
+
+	colm_backend_pipelined.encrypt_blocks(ctx, st, in, out, remaining / BLOCKSIZE);
+}
+
+static void decrypt_blocks_vaes(const colm_key_ctx* ctx, colm_state* st, const uint8_t* in, uint8_t* out, uint64_t full_blocks)
+{
+	wide_block_t wide_keys[11];
+	wide_block_t wide_checksum = WIDE_ZERO();
+	uint64_t remaining = full_blocks * BLOCKSIZE;
+
+	WIDE_SET_KEYS(ctx->aes_decryption_keys, wide_keys);
+
+	colm0_decrypt_wide_blocks(&in, &out, &remaining, &st->w, &wide_checksum, &st->delta_m, &st->delta_c, ctx, wide_keys, 4);
+	colm0_decrypt_wide_blocks(&in, &out, &remaining, &st->w, &wide_checksum, &st->delta_m, &st->delta_c, ctx, wide_keys, 1);
+	st->checksum = XOR_BLOCK(st->checksum, wide_fold(wide_checksum));
+
+	colm_backend_pipelined.decrypt_blocks(ctx, st, in, out, remaining / BLOCKSIZE);
+}
+
+static int8_t colm_tau_encrypt_vaes(const colm_key_ctx* ctx, block_t w, uint16_t tau, uint8_t* message, uint64_t message_len, uint64_t* c_len, uint8_t* ciphertext, uint64_t* tag_len, uint8_t* tags)
+{
+	return colm_backend_pipelined.colm_tau_encrypt(ctx, w, tau, message, message_len, c_len, ciphertext, tag_len, tags);
+}
+
+static int8_t colm_tau_decrypt_vaes(const colm_key_ctx* ctx, block_t w, uint16_t tau, uint8_t* ciphertext, uint64_t len, uint64_t tag_len, uint8_t* tags, uint64_t* m_len, uint8_t* message)
+{
+	return colm_backend_pipelined.colm_tau_decrypt(ctx, w, tau, ciphertext, len, tag_len, tags, m_len, message);
+}
+
+// selected by colm_dispatch.c if the CPU has VAES and AVX-512
+const colm_backend colm_backend_vaes = {
+	.name = VAES_BACKEND_NAME,
+	.key_ctx_init = key_ctx_init_vaes,
+	.mac = mac_vaes,
+	.colm0_encrypt = colm0_encrypt_vaes,
+	.colm0_decrypt = colm0_decrypt_vaes,
+	.colm0_encrypt_mac = colm0_encrypt_mac_vaes,
+	.colm_tau_encrypt = colm_tau_encrypt_vaes,
+	.colm_tau_decrypt = colm_tau_decrypt_vaes,
+	.encrypt_blocks = encrypt_blocks_vaes,
+	.decrypt_blocks = decrypt_blocks_vaes,
+};
+
+VAES_TARGET_END
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * In-place operation (colm.h): colm0_encrypt / colm0_decrypt and colm127_encrypt / colm127_decrypt with the output in the input buffer
+ * must give the same result as into a separate buffer. The lengths cover the empty message, partial and full last blocks and messages
+ * with several intermediate tags of COLM127, the tag of the encryption goes into the 16 bytes of slack behind the message.
+ * The bytes behind the slack must stay untouched.
+ *
+ * Build:
+ *   cc -O2 -Isrc test/test_inplace.c src/colm_parallel.c src/colm_dispatch.c src/colm_ad_cache.c src/colm_vaes.c -o test_inplace
+ * (on ARM with -march=armv8-a+crypto, without colm_vaes.c and together with the AES key schedule)
+ * Usage: test_inplace [backend], exit code 0 if all checks passed
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "colm.h"
+
+#define MAX_LEN (3 * 127 * BLOCKSIZE + 40)
+#define GUARD 32
+#define GUARD_BYTE 0xa5
+
+static uint8_t message[MAX_LEN];
+static uint8_t expected[MAX_LEN + BLOCKSIZE];
+static uint8_t expected_tags[MAX_LEN / 127 + 2 * BLOCKSIZE];
+static uint8_t buf[MAX_LEN + BLOCKSIZE + GUARD];
+static uint8_t tags[MAX_LEN / 127 + 2 * BLOCKSIZE];
+
+static int failures = 0;
+
+static void check(int ok, const char* what, uint64_t len, uint64_t ad_len)
+{
+	if (!ok)
+	{
+		if (failures < 10)
+		{
+			printf("FAIL %s: len %llu, ad %llu\n", what, (unsigned long long)len, (unsigned long long)ad_len);
+		}
+		failures++;
+	}
+}
+
+static int guard_intact(uint64_t from)
+{
+	uint64_t i;
+
+	for (i = from; i < from + GUARD; i++)
+	{
+		if (buf[i] != GUARD_BYTE)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void check_colm0(block_t key, uint8_t* ad, uint64_t len, uint64_t ad_len)
+{
+	uint64_t c_len, expected_len, m_len;
+	int8_t result;
+
+	colm0_encrypt(message, len, ad, ad_len, 1, key, &expected_len, expected);
+
+	memset(buf, GUARD_BYTE, sizeof(buf));
+	memcpy(buf, message, len);
+	result = colm0_encrypt(buf, len, ad, ad_len, 1, key, &c_len, buf);
+	check(result == 0 && c_len == expected_len && memcmp(buf, expected, c_len) == 0, "colm0_encrypt", len, ad_len);
+	check(guard_intact(len + BLOCKSIZE), "colm0_encrypt slack", len, ad_len);
+
+	result = colm0_decrypt(buf, c_len, ad, ad_len, 1, key, &m_len, buf);
+	check(result == 0 && m_len == len && memcmp(buf, message, len) == 0, "colm0_decrypt", len, ad_len);
+	check(guard_intact(len + BLOCKSIZE), "colm0_decrypt slack", len, ad_len);
+}
+
+static void check_colm127(block_t key, uint8_t* ad, uint64_t len, uint64_t ad_len)
+{
+	uint64_t c_len, expected_len, m_len, tag_len = 0, expected_tag_len = 0;
+	int8_t result;
+
+	colm127_encrypt(message, len, ad, ad_len, 1, key, &expected_len, expected, &expected_tag_len, expected_tags);
+
+	memset(buf, GUARD_BYTE, sizeof(buf));
+	memcpy(buf, message, len);
+	result = colm127_encrypt(buf, len, ad, ad_len, 1, key, &c_len, buf, &tag_len, tags);
+	check(result == 0 && c_len == expected_len && memcmp(buf, expected, c_len) == 0, "colm127_encrypt", len, ad_len);
+	check(tag_len == expected_tag_len && memcmp(tags, expected_tags, tag_len) == 0, "colm127_encrypt tags", len, ad_len);
+	check(guard_intact(len + BLOCKSIZE), "colm127_encrypt slack", len, ad_len);
+
+	result = colm127_decrypt(buf, c_len, ad, ad_len, 1, key, tag_len, tags, &m_len, buf);
+	check(result == 0 && m_len == len && memcmp(buf, message, len) == 0, "colm127_decrypt", len, ad_len);
+	check(guard_intact(len + BLOCKSIZE), "colm127_decrypt slack", len, ad_len);
+}
+
+int main(int argc, char** argv)
+{
+	const uint8_t key_bytes[BLOCKSIZE] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+	block_t key = LOAD_KEY(key_bytes);
+	uint8_t ad[40];
+	uint64_t len, ad_len, i;
+
+	if (argc > 1 && colm_backend_select(argv[1]) != 0)
+	{
+		fprintf(stderr, "backend %s not available\n", argv[1]);
+		return 1;
+	}
+
+	for (i = 0; i < MAX_LEN; i++)
+	{
+		message[i] = (uint8_t)(i * 31 + 7);
+	}
+	for (i = 0; i < sizeof(ad); i++)
+	{
+		ad[i] = (uint8_t)(i * 13 + 1);
+	}
+
+	for (ad_len = 0; ad_len <= sizeof(ad); ad_len += 20)
+	{
+		// every length up to 20 blocks, then steps across the intermediate tags
+		for (len = 0; len <= MAX_LEN; len += len < 20 * BLOCKSIZE ? 1 : 61)
+		{
+			check_colm0(key, ad, len, ad_len);
+			check_colm127(key, ad, len, ad_len);
+		}
+	}
+
+	printf("# backend: %s\n", colm_backend_name());
+	printf("%s (%d failures)\n", failures == 0 ? "in-place: ok" : "in-place: FAILED", failures);
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+/*
+ * Random access decryption of COLM127 (colm127_decrypt_segments): every range of segments must give the plaintext of colm127_encrypt_ctx,
+ * and a range must be rejected if anything in it comes from another object or position: a segment together with the tags and the index
+ * around it from an object with another nonce and associated data under the same key, a foreign or modified index block, a segment
+ * moved to another position.
+ *
+ * Build:
+ *   cc -O2 -Isrc test/test_seek.c src/colm_parallel.c src/colm_dispatch.c src/colm_ad_cache.c src/colm_seek.c src/colm_stream.c src/colm_vaes.c -o test_seek
+ * (on ARM with -march=armv8-a+crypto, without colm_vaes.c and together with the AES key schedule)
+ * Usage: test_seek [backend], exit code 0 if all checks passed
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "colm.h"
+
+#define SEGMENTS 5
+#define LEN (SEGMENTS * COLM_STREAM_WINDOW + 100) // SEGMENTS segments and the rest with the last block (can't be read this way)
+#define TAGS_LEN (SEGMENTS * BLOCKSIZE)
+
+typedef struct object
+{
+	uint8_t* ad;
+	uint64_t ad_len;
+	uint64_t npub;
+	uint8_t message[LEN];
+	uint8_t ciphertext[LEN + BLOCKSIZE];
+	uint8_t tags[TAGS_LEN];
+	uint8_t index[TAGS_LEN];
+	uint64_t c_len;
+	uint64_t tag_len;
+} object;
+
+static object a, b;
+static uint8_t out[LEN];
+static int failures = 0;
+
+static void check(int ok, const char* what)
+{
+	if (!ok)
+	{
+		printf("FAIL %s\n", what);
+		failures++;
+	}
+}
+
+static void create(const colm_key_ctx* ctx, object* o, uint8_t* ad, uint64_t ad_len, uint64_t npub, uint8_t seed)
+{
+	uint64_t i;
+
+	for (i = 0; i < LEN; i++)
+	{
+		o->message[i] = (uint8_t)(i * 31 + seed);
+	}
+	o->ad = ad;
+	o->ad_len = ad_len;
+	o->npub = npub;
+	o->tag_len = 0;
+	colm127_encrypt_ctx(ctx, o->message, LEN, ad, ad_len, npub, &o->c_len, o->ciphertext, &o->tag_len, o->tags);
+	colm127_segment_index(ctx, ad, ad_len, npub, o->tags, o->tag_len, o->index);
+}
+
+static int8_t read_range(const colm_key_ctx* ctx, const object* o, const uint8_t* ciphertext, const uint8_t* tags, const uint8_t* index, uint64_t first, uint64_t count)
+{
+	return colm127_decrypt_segments(ctx, o->ad, o->ad_len, o->npub, o->c_len, tags, o->tag_len, index, first, count,
+	                                ciphertext + first * COLM_STREAM_WINDOW, out);
+}
+
+int main(int argc, char** argv)
+{
+	const uint8_t key_bytes[BLOCKSIZE] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+	block_t key = LOAD_KEY(key_bytes);
+	colm_key_ctx ctx;
+	uint8_t ad_a[] = "hdrA", ad_b[] = "hdrB";
+	uint8_t spliced[LEN + BLOCKSIZE], spliced_tags[TAGS_LEN], spliced_index[TAGS_LEN];
+	uint64_t first, count;
+	int8_t result;
+
+	if (argc > 1 && colm_backend_select(argv[1]) != 0)
+	{
+		fprintf(stderr, "backend %s not available\n", argv[1]);
+		return 1;
+	}
+	if (colm_key_ctx_init(&ctx, key) != 0)
+	{
+		fprintf(stderr, "no AES instructions on this CPU\n");
+		return 1;
+	}
+
+	create(&ctx, &a, ad_a, 4, 1, 7);
+	create(&ctx, &b, ad_b, 4, 2, 11);
+	check(a.tag_len == TAGS_LEN && b.tag_len == TAGS_LEN, "number of intermediate tags");
+
+	// all ranges of whole segments
+	for (first = 0; first < SEGMENTS; first++)
+	{
+		for (count = 1; first + count <= SEGMENTS; count++)
+		{
+			result = read_range(&ctx, &a, a.ciphertext, a.tags, a.index, first, count);
+			check(result == 0 && memcmp(out, a.message + first * COLM_STREAM_WINDOW, count * COLM_STREAM_WINDOW) == 0, "range read");
+		}
+	}
+	check(read_range(&ctx, &a, a.ciphertext, a.tags, a.index, SEGMENTS, 1) == -1, "range with the last block");
+	check(read_range(&ctx, &a, a.ciphertext, a.tags, NULL, 1, 1) == -1, "range without index");
+
+	// segment 1 and tags 0 - 1 of b in a: rejected with the index of a and with the index of b
+	memcpy(spliced, a.ciphertext, a.c_len);
+	memcpy(spliced_tags, a.tags, TAGS_LEN);
+	memcpy(spliced + COLM_STREAM_WINDOW, b.ciphertext + COLM_STREAM_WINDOW, COLM_STREAM_WINDOW);
+	memcpy(spliced_tags, b.tags, 2 * BLOCKSIZE);
+	check(read_range(&ctx, &a, spliced, spliced_tags, a.index, 1, 1) == -5, "spliced segment, index of a");
+	memcpy(spliced_index, a.index, TAGS_LEN);
+	memcpy(spliced_index, b.index, BLOCKSIZE);
+	check(read_range(&ctx, &a, spliced, spliced_tags, spliced_index, 1, 1) == -5, "spliced segment, index of b");
+	check(read_range(&ctx, &a, spliced, spliced_tags, b.index, 1, 1) == -5, "spliced segment and whole index of b");
+
+	// segment 1 of a with a modified index block
+	memcpy(spliced_index, a.index, TAGS_LEN);
+	spliced_index[3] ^= 1;
+	check(read_range(&ctx, &a, a.ciphertext, a.tags, spliced_index, 1, 1) == -5, "modified index");
+
+	// segment 2 of a read as segment 1
+	memcpy(spliced, a.ciphertext, a.c_len);
+	memcpy(spliced + COLM_STREAM_WINDOW, a.ciphertext + 2 * COLM_STREAM_WINDOW, COLM_STREAM_WINDOW);
+	memcpy(spliced_tags, a.tags, TAGS_LEN);
+	memcpy(spliced_tags + BLOCKSIZE, a.tags + 2 * BLOCKSIZE, BLOCKSIZE);
+	check(read_range(&ctx, &a, spliced, spliced_tags, a.index, 1, 1) == -5, "moved segment");
+
+	// the whole object of b read with the nonce and associated data of a
+	check(read_range(&ctx, &a, b.ciphertext, b.tags, b.index, 2, 1) == -5, "object of b as a");
+
+	colm_key_ctx_free(&ctx);
+
+	printf("# backend: %s\n", colm_backend_name());
+	printf("%s (%d failures)\n", failures == 0 ? "segments: ok" : "segments: FAILED", failures);
+
+	return failures == 0 ? 0 : 1;
+}